@@ -0,0 +1,64 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_ASSET_PACK_H
+#define DEMO_ASSET_PACK_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mapped_file.h"
+
+namespace gfx {
+
+// ------------------------------------------------------------------
+// Single-file asset archive (tools/asset_pack.cpp writes it):
+//   header | LZ4-compressed index | entry data
+// Entries that compress well are stored as LZ4 blocks; the rest (already
+// compressed images, KTX textures) are stored raw at 4 KiB-aligned offsets,
+// so readers use them straight out of the mapping without a copy.
+// The whole pack is one mmap: one open for every asset, read sequentially.
+// ------------------------------------------------------------------
+    class AssetPack {
+    public:
+        struct Entry {
+            std::string name;
+            uint64_t offset = 0;        // from the start of the file
+            uint64_t storedSize = 0;
+            uint64_t size = 0;
+            bool compressed = false;
+        };
+
+        bool open(const std::string& path);
+
+        const Entry* find(const std::string& name) const;
+        const std::vector<Entry>& entries() const { return index; }
+
+        // Raw entries only: the bytes inside the mapping, valid while the pack is open
+        const uint8_t* view(const Entry& entry) const;
+        // Decompresses (or copies) the entry into `out`, which holds entry.size bytes
+        bool read(const Entry& entry, uint8_t* out) const;
+
+        size_t fileSize() const { return file.size(); }
+
+    private:
+        MappedFile file;
+        std::vector<Entry> index;
+        std::unordered_map<std::string, size_t> lookup;
+    };
+
+    struct AssetPackInput {
+        std::string name;
+        std::vector<uint8_t> bytes;
+        bool allowCompression = true;   // false keeps it raw (and mappable) regardless of ratio
+    };
+
+    // Entries are laid out in input order, so put them in the order they load
+    bool writeAssetPack(const std::string& path, const std::vector<AssetPackInput>& inputs);
+
+} // namespace gfx
+
+#endif //DEMO_ASSET_PACK_H
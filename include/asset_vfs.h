@@ -0,0 +1,63 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_ASSET_VFS_H
+#define DEMO_ASSET_VFS_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.h"
+
+namespace gfx {
+
+// ------------------------------------------------------------------
+// Contents of one asset: a view into a mounted pack (raw entries), a
+// decompressed copy (LZ4 entries), or a mapped loose file.
+// ------------------------------------------------------------------
+    class AssetData {
+    public:
+        bool valid() const { return found; }
+        const uint8_t* data() const { return bytes; }
+        size_t size() const { return length; }
+        std::string_view text() const { return { reinterpret_cast<const char*>(bytes), length }; }
+
+    private:
+        friend AssetData readAsset(const std::string& path);
+
+        const uint8_t* bytes = nullptr;
+        size_t length = 0;
+        bool found = false;
+        std::vector<uint8_t> owned;
+        MappedFile file;
+    };
+
+// ------------------------------------------------------------------
+// Virtual filesystem in front of the loaders (meshes, images, KTX, shader
+// sources). Paths stay real paths: a path under a mounted directory is
+// looked up in that directory's pack first and only falls back to the disk
+// when the pack does not have it, or the loose file is newer than the pack
+// (checked at mount, and again by hot reload through bypassAssetPack), so a
+// missing or stale pack just means loose files. Mount everything before
+// loading starts; packs stay mapped for the life of the program, which keeps
+// pack views valid.
+// ------------------------------------------------------------------
+
+    // Serves `directory`/name from the pack entry `prefix` + name. One pack can
+    // back several directories (each with its own prefix). False if the pack
+    // can't be opened.
+    bool mountAssetPack(const std::string& packPath, const std::string& directory, const std::string& prefix = "");
+
+    AssetData readAsset(const std::string& path);
+    bool assetExists(const std::string& path);
+
+    // Reads of `path` skip the packs from now on: the file on disk was edited
+    // after the pack was built (hot reload).
+    void bypassAssetPack(const std::string& path);
+
+} // namespace gfx
+
+#endif //DEMO_ASSET_VFS_H
@@ -0,0 +1,112 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_BOUNDS_H
+#define DEMO_BOUNDS_H
+#include <limits>
+#include <glm.hpp>
+
+namespace gfx {
+
+    struct AABB {
+        glm::vec3 min { std::numeric_limits<float>::max() };
+        glm::vec3 max { -std::numeric_limits<float>::max() };
+
+        bool valid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+        glm::vec3 center()  const { return (min + max) * 0.5f; }
+        glm::vec3 extents() const { return (max - min) * 0.5f; }
+
+        void expand(const glm::vec3& p) { min = glm::min(min, p); max = glm::max(max, p); }
+        void expand(const AABB& b)      { min = glm::min(min, b.min); max = glm::max(max, b.max); }
+    };
+
+    struct BoundingSphere {
+        glm::vec3 center { 0.0f };
+        float radius = 0.0f;
+    };
+
+// ------------------------------------------------------------------
+// Transform helpers
+// ------------------------------------------------------------------
+
+    // World-space box enclosing a transformed local box (Arvo's method).
+    inline AABB transformAABB(const AABB& b, const glm::mat4& m)
+    {
+        AABB out;
+        out.min = out.max = glm::vec3(m[3]);
+        for (int col = 0; col < 3; ++col) {
+            for (int row = 0; row < 3; ++row) {
+                float e = m[col][row] * b.min[col];
+                float f = m[col][row] * b.max[col];
+                out.min[row] += e < f ? e : f;
+                out.max[row] += e < f ? f : e;
+            }
+        }
+        return out;
+    }
+
+    // World-space sphere enclosing a local box under an affine transform.
+    inline BoundingSphere transformSphere(const AABB& b, const glm::mat4& m)
+    {
+        float sx = glm::length(glm::vec3(m[0]));
+        float sy = glm::length(glm::vec3(m[1]));
+        float sz = glm::length(glm::vec3(m[2]));
+        float s  = glm::max(sx, glm::max(sy, sz));
+
+        BoundingSphere out;
+        out.center = glm::vec3(m * glm::vec4(b.center(), 1.0f));
+        out.radius = glm::length(b.extents()) * s;
+        return out;
+    }
+
+// ------------------------------------------------------------------
+// Frustum (planes point inward; extracted from projection * view)
+// ------------------------------------------------------------------
+    struct Frustum {
+        glm::vec4 planes[6];
+
+        static Frustum fromMatrix(const glm::mat4& viewProj)
+        {
+            glm::vec4 r0(viewProj[0][0], viewProj[1][0], viewProj[2][0], viewProj[3][0]);
+            glm::vec4 r1(viewProj[0][1], viewProj[1][1], viewProj[2][1], viewProj[3][1]);
+            glm::vec4 r2(viewProj[0][2], viewProj[1][2], viewProj[2][2], viewProj[3][2]);
+            glm::vec4 r3(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+
+            Frustum f;
+            f.planes[0] = r3 + r0;  // left
+            f.planes[1] = r3 - r0;  // right
+            f.planes[2] = r3 + r1;  // bottom
+            f.planes[3] = r3 - r1;  // top
+            f.planes[4] = r3 + r2;  // near
+            f.planes[5] = r3 - r2;  // far
+            for (auto& p : f.planes)
+                p /= glm::length(glm::vec3(p));
+            return f;
+        }
+
+        bool intersects(const BoundingSphere& s) const
+        {
+            for (const auto& p : planes)
+                if (glm::dot(glm::vec3(p), s.center) + p.w < -s.radius)
+                    return false;
+            return true;
+        }
+
+        bool intersects(const AABB& b) const
+        {
+            const glm::vec3 c = b.center();
+            const glm::vec3 e = b.extents();
+            for (const auto& p : planes) {
+                glm::vec3 n(p);
+                float r = glm::dot(e, glm::abs(n));
+                if (glm::dot(n, c) + p.w < -r)
+                    return false;
+            }
+            return true;
+        }
+    };
+
+} // namespace gfx
+
+#endif //DEMO_BOUNDS_H
@@ -0,0 +1,126 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_BVH_H
+#define DEMO_BVH_H
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+#include <glm.hpp>
+
+#include "bounds.h"
+
+namespace gfx {
+
+    struct Ray {
+        glm::vec3 origin { 0.0f };
+        glm::vec3 direction { 0.0f, 0.0f, -1.0f };
+    };
+
+    // Ray with reciprocal direction cached for slab tests.
+    struct RayQuery {
+        glm::vec3 origin;
+        glm::vec3 direction;
+        glm::vec3 invDirection;
+
+        explicit RayQuery(const Ray& r);
+    };
+
+    // Entry distance of the ray into b, or +inf if it misses within [0, tMax].
+    float intersectAABB(const RayQuery& r, const AABB& b, float tMax);
+
+// ------------------------------------------------------------------
+// Bounding volume hierarchy over boxes (binned SAH build, flat node array).
+// Leaves reference a range of primitiveOrder(); the caller stores whatever
+// primitives it likes in that order.
+// ------------------------------------------------------------------
+    class BVH {
+    public:
+        struct Node {
+            AABB bounds;
+            uint32_t first = 0;   // leaf: first primitive slot; inner: left child (right = left + 1)
+            uint32_t count = 0;   // > 0 for leaves
+        };
+
+        void build(const std::vector<AABB>& primitiveBounds, uint32_t maxLeafSize = 4);
+        // Recompute node bounds after primitives moved, keeping the topology.
+        void refit(const std::vector<AABB>& primitiveBounds);
+
+        bool empty() const;
+        const std::vector<Node>& nodes() const;
+        const std::vector<uint32_t>& primitiveOrder() const;
+
+        // Visits leaves front to back; hitLeaf(first, count, tMax&) may shrink tMax.
+        template <class LeafFn>
+        void traverse(const RayQuery& r, float tMax, LeafFn&& hitLeaf) const;
+
+    private:
+        void subdivide_(uint32_t nodeIndex, const std::vector<AABB>& prims,
+                        const std::vector<glm::vec3>& centers, uint32_t maxLeafSize);
+
+        std::vector<Node> nodeList;
+        std::vector<uint32_t> order;
+    };
+
+    template <class LeafFn>
+    void BVH::traverse(const RayQuery& r, float tMax, LeafFn&& hitLeaf) const
+    {
+        if (nodeList.empty() || intersectAABB(r, nodeList[0].bounds, tMax) > tMax)
+            return;
+
+        uint32_t stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& node = nodeList[stack[--top]];
+            if (node.count > 0) {
+                hitLeaf(node.first, node.count, tMax);
+                continue;
+            }
+            uint32_t a = node.first, b = node.first + 1;
+            float ta = intersectAABB(r, nodeList[a].bounds, tMax);
+            float tb = intersectAABB(r, nodeList[b].bounds, tMax);
+            if (ta > tb) { std::swap(a, b); std::swap(ta, tb); }
+            // Push the far child first so the near one is visited next
+            if (tb <= tMax) stack[top++] = b;
+            if (ta <= tMax) stack[top++] = a;
+        }
+    }
+
+// ------------------------------------------------------------------
+// Triangle BVH for exact ray hits, built from interleaved vertex data.
+// ------------------------------------------------------------------
+    struct TriangleHit {
+        float t = std::numeric_limits<float>::max();
+        uint32_t triangle = 0;   // index into the source index buffer / 3
+        float u = 0.0f, v = 0.0f;
+    };
+
+    class TriangleBVH {
+    public:
+        void build(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices);
+
+        bool intersect(const RayQuery& r, float tMax, TriangleHit& hit) const;
+
+        const AABB& bounds() const;
+        size_t triangleCount() const;
+        glm::vec3 normal(uint32_t triangle) const;
+
+    private:
+        // Stored in BVH leaf order, pre-digested for Moller-Trumbore.
+        struct Triangle {
+            glm::vec3 v0, e1, e2;
+            uint32_t source;
+        };
+
+        BVH bvh;
+        std::vector<Triangle> triangles;
+        std::vector<uint32_t> sourceToSlot;
+        AABB meshBounds;
+    };
+
+} // namespace gfx
+
+#endif //DEMO_BVH_H
@@ -0,0 +1,43 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_ENV_PREFILTER_H
+#define DEMO_ENV_PREFILTER_H
+#include <string>
+#include <vector>
+
+#include "image_loader.h"
+#include "ktx.h"
+#include "thread_pool.h"
+
+namespace gfx {
+
+// ------------------------------------------------------------------
+// Specular environment prefiltering (split-sum, GGX).
+// Level L of the output cube holds the sky convolved with the GGX lobe of
+// roughness L / (levels - 1), under the usual N = V = R assumption, so a
+// shader reflects with one textureLod(env, R, roughness * (levels - 1)).
+// ------------------------------------------------------------------
+    struct PrefilterSettings {
+        int size = 256;         // face size of level 0 (mirror-like)
+        int levels = 6;         // roughness 0 .. 1 across these levels
+        int samples = 128;      // GGX samples per texel for rough levels
+    };
+
+    // Bakes on the CPU: faces (+X -X +Y -Y +Z -Z) are sRGB-decoded, lobes are
+    // importance-sampled from the source mip that matches each sample's footprint,
+    // and results are stored as RGBA8 sRGB. Rows of every face run on the pool.
+    KtxSource prefilterCubeMap(const std::vector<Image>& faces, const PrefilterSettings& settings = {},
+                               ThreadPool& pool = ThreadPool::shared());
+
+    // Path of a .ktx holding the prefiltered cube for these face files, baked
+    // into cacheDir on the first call and reused while the faces and settings
+    // are unchanged. Empty if the faces cannot be read.
+    std::string prefilterEnvironment(const std::vector<std::string>& faces, const std::string& cacheDir,
+                                     const PrefilterSettings& settings = {},
+                                     ThreadPool& pool = ThreadPool::shared());
+
+} // namespace gfx
+
+#endif //DEMO_ENV_PREFILTER_H
@@ -0,0 +1,129 @@
+//
+// Created by dengq on 10/19/26.
+//
+// The bundled glad loader is generated for GL 3.3 core only. This header adds
+// the handful of newer entry points the optional render paths use, in the same
+// style as glad.h, and loads them after gladLoadGLLoader() has run. Every
+// pointer stays null when the context does not provide it, so callers gate on
+// gfx::hasGLVersion() before touching them.
+
+#ifndef DEMO_GL_EXT_H
+#define DEMO_GL_EXT_H
+
+#include "glad/glad.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef GL_VERSION_4_0
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+#ifndef GL_VERSION_4_1
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+GLAPI PFNGLGETPROGRAMBINARYPROC glext_glGetProgramBinary;
+#define glGetProgramBinary glext_glGetProgramBinary
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+GLAPI PFNGLPROGRAMBINARYPROC glext_glProgramBinary;
+#define glProgramBinary glext_glProgramBinary
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+GLAPI PFNGLPROGRAMPARAMETERIPROC glext_glProgramParameteri;
+#define glProgramParameteri glext_glProgramParameteri
+#define GL_VERTEX_SHADER_BIT 0x00000001
+#define GL_FRAGMENT_SHADER_BIT 0x00000002
+#define GL_PROGRAM_SEPARABLE 0x8258
+typedef void (APIENTRYP PFNGLGENPROGRAMPIPELINESPROC)(GLsizei n, GLuint *pipelines);
+GLAPI PFNGLGENPROGRAMPIPELINESPROC glext_glGenProgramPipelines;
+#define glGenProgramPipelines glext_glGenProgramPipelines
+typedef void (APIENTRYP PFNGLDELETEPROGRAMPIPELINESPROC)(GLsizei n, const GLuint *pipelines);
+GLAPI PFNGLDELETEPROGRAMPIPELINESPROC glext_glDeleteProgramPipelines;
+#define glDeleteProgramPipelines glext_glDeleteProgramPipelines
+typedef void (APIENTRYP PFNGLBINDPROGRAMPIPELINEPROC)(GLuint pipeline);
+GLAPI PFNGLBINDPROGRAMPIPELINEPROC glext_glBindProgramPipeline;
+#define glBindProgramPipeline glext_glBindProgramPipeline
+typedef void (APIENTRYP PFNGLUSEPROGRAMSTAGESPROC)(GLuint pipeline, GLbitfield stages, GLuint program);
+GLAPI PFNGLUSEPROGRAMSTAGESPROC glext_glUseProgramStages;
+#define glUseProgramStages glext_glUseProgramStages
+typedef void (APIENTRYP PFNGLACTIVESHADERPROGRAMPROC)(GLuint pipeline, GLuint program);
+GLAPI PFNGLACTIVESHADERPROGRAMPROC glext_glActiveShaderProgram;
+#define glActiveShaderProgram glext_glActiveShaderProgram
+typedef void (APIENTRYP PFNGLVALIDATEPROGRAMPIPELINEPROC)(GLuint pipeline);
+GLAPI PFNGLVALIDATEPROGRAMPIPELINEPROC glext_glValidateProgramPipeline;
+#define glValidateProgramPipeline glext_glValidateProgramPipeline
+typedef void (APIENTRYP PFNGLGETPROGRAMPIPELINEIVPROC)(GLuint pipeline, GLenum pname, GLint *params);
+GLAPI PFNGLGETPROGRAMPIPELINEIVPROC glext_glGetProgramPipelineiv;
+#define glGetProgramPipelineiv glext_glGetProgramPipelineiv
+typedef void (APIENTRYP PFNGLGETPROGRAMPIPELINEINFOLOGPROC)(GLuint pipeline, GLsizei bufSize, GLsizei *length, GLchar *infoLog);
+GLAPI PFNGLGETPROGRAMPIPELINEINFOLOGPROC glext_glGetProgramPipelineInfoLog;
+#define glGetProgramPipelineInfoLog glext_glGetProgramPipelineInfoLog
+#endif
+
+#ifndef GL_VERSION_4_2
+#define GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT 0x00000001
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT 0x00000020
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+#define GL_BUFFER_UPDATE_BARRIER_BIT 0x00000200
+#define GL_ALL_BARRIER_BITS 0xFFFFFFFF
+typedef void (APIENTRYP PFNGLMEMORYBARRIERPROC)(GLbitfield barriers);
+GLAPI PFNGLMEMORYBARRIERPROC glext_glMemoryBarrier;
+#define glMemoryBarrier glext_glMemoryBarrier
+typedef void (APIENTRYP PFNGLBINDIMAGETEXTUREPROC)(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format);
+GLAPI PFNGLBINDIMAGETEXTUREPROC glext_glBindImageTexture;
+#define glBindImageTexture glext_glBindImageTexture
+typedef void (APIENTRYP PFNGLTEXSTORAGE2DPROC)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height);
+GLAPI PFNGLTEXSTORAGE2DPROC glext_glTexStorage2D;
+#define glTexStorage2D glext_glTexStorage2D
+#endif
+
+#ifndef GL_VERSION_4_3
+#define GL_COMPUTE_SHADER 0x91B9
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEPROC)(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+GLAPI PFNGLDISPATCHCOMPUTEPROC glext_glDispatchCompute;
+#define glDispatchCompute glext_glDispatchCompute
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void *indirect, GLsizei drawcount, GLsizei stride);
+GLAPI PFNGLMULTIDRAWELEMENTSINDIRECTPROC glext_glMultiDrawElementsIndirect;
+#define glMultiDrawElementsIndirect glext_glMultiDrawElementsIndirect
+#endif
+
+#ifndef GL_KHR_parallel_shader_compile
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+GLAPI PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glext_glMaxShaderCompilerThreadsKHR;
+#define glMaxShaderCompilerThreadsKHR glext_glMaxShaderCompilerThreadsKHR
+#endif
+
+#ifndef GL_EXT_texture_compression_s3tc
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+namespace gfx {
+
+    // Loads the post-3.3 entry points declared above. Call once, right after
+    // gladLoadGLLoader() succeeded on the current context. With
+    // KHR/ARB_parallel_shader_compile it also lets the driver compile on as
+    // many threads as it likes (some compile serially until asked to).
+    void loadGLExtensions(GLADloadproc load);
+
+    // True if the current context reports at least major.minor.
+    bool hasGLVersion(int major, int minor);
+    // True if the current context advertises the named extension.
+    bool hasGLExtension(const char* name);
+
+} // namespace gfx
+
+#endif //DEMO_GL_EXT_H
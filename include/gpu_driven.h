@@ -0,0 +1,114 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_GPU_DRIVEN_H
+#define DEMO_GPU_DRIVEN_H
+#include <vector>
+#include <glm.hpp>
+
+#include "gl_ext.h"
+#include "bounds.h"
+#include "mesh.h"
+#include "shaderprogram.h"
+
+namespace gfx {
+
+    // Layout mandated by glMultiDrawElementsIndirect.
+    struct DrawElementsIndirectCommand {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint  baseVertex;
+        GLuint baseInstance;
+    };
+
+// ------------------------------------------------------------------
+// GPU-driven submission (GL 4.3+).
+// Meshes are merged into one VBO/EBO, instances live in an SSBO, and a
+// compute pass frustum/Hi-Z culls them into DrawElementsIndirectCommands.
+// The scene is then drawn with a single glMultiDrawElementsIndirect.
+// Programs drawn through it must use cube_vertex_indirect.vert's inputs.
+// ------------------------------------------------------------------
+    class GpuDrivenRenderer {
+    public:
+        GpuDrivenRenderer();
+        ~GpuDrivenRenderer();
+        GpuDrivenRenderer(const GpuDrivenRenderer&) = delete;
+        GpuDrivenRenderer& operator=(const GpuDrivenRenderer&) = delete;
+
+        // True if the current context can run this path.
+        static bool isSupported();
+
+        // Registration; ids are dense and stable.
+        int addMesh(const Mesh& mesh);
+        int addInstance(int meshId, const glm::mat4& model);
+        void setInstanceTransform(int instanceId, const glm::mat4& model);
+        // Packed gfx::ObjectLights, read by cube_vertex_indirect.vert
+        void setInstanceLights(int instanceId, const glm::uvec3& packedLights);
+        // gfx::MaterialLibrary::Slot::params(); every instance must live on the bound page
+        void setInstanceMaterial(int instanceId, const glm::vec2& materialParams);
+
+        // Per frame: cull() before draw(), updateOcclusion() once the frame's
+        // depth is complete so the next cull can test against it.
+        void cull(const glm::mat4& view, const glm::mat4& projection);
+        void draw() const;
+        void updateOcclusion(int width, int height);
+
+        void setOcclusionCulling(bool enabled);
+        size_t instanceCount() const;
+
+        void cleanup();
+
+    private:
+        // std430 mirror of `Instance` in instance_cull.comp
+        struct GpuInstance {
+            glm::mat4 model;
+            glm::vec4 sphere;
+            glm::uvec4 meta;
+            glm::vec4 material { 0.0f, 32.0f, 0.0f, 0.0f };
+        };
+
+        struct MeshRange {
+            AABB bounds;
+            GLuint indexCount = 0;
+            GLuint firstIndex = 0;
+            GLint  baseVertex = 0;
+        };
+
+        void markDirty_(size_t instance);
+        void uploadGeometry_();
+        void rebuildCommands_();
+        void uploadInstances_();
+        void resizeHiZ_(int width, int height);
+
+        ShaderProgram cullProgram;
+        ShaderProgram hizProgram;
+
+        Mesh::Vertices vertices;
+        std::vector<unsigned int> indices;
+        std::vector<MeshRange> meshes;
+        std::vector<GpuInstance> instances;
+
+        bool geometryDirty = false;
+        bool commandsDirty = false;
+        size_t dirtyBegin = 0, dirtyEnd = 0;   // instance range awaiting upload
+        size_t instanceCapacity = 0;
+
+        GLuint VAO = 0, VBO = 0, EBO = 0;
+        GLuint instanceBuffer = 0;   // SSBO of GpuInstance
+        GLuint visibleBuffer = 0;    // culled instance indices, also attribute 3
+        GLuint commandBuffer = 0;    // written by the cull pass
+        GLuint commandTemplate = 0;  // same commands with instanceCount = 0
+
+        GLuint depthTexture = 0, hizTexture = 0;
+        int hizWidth = 0, hizHeight = 0, hizLevels = 0;
+        bool hizValid = false;
+        bool occlusionEnabled = true;
+        glm::mat4 frameViewProj { 1.0f };
+        glm::mat4 hizViewProj { 1.0f };
+    };
+
+} // namespace gfx
+
+#endif //DEMO_GPU_DRIVEN_H
@@ -0,0 +1,41 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_HASH_H
+#define DEMO_HASH_H
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace gfx {
+
+    // 64-bit FNV-1a. Chain calls by passing the previous result as the seed.
+    inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0)
+    {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        uint64_t h = 0xcbf29ce484222325ull ^ seed;
+        for (size_t i = 0; i < size; ++i) {
+            h ^= bytes[i];
+            h *= 0x100000001b3ull;
+        }
+        return h;
+    }
+
+    inline uint64_t hashString(const std::string& text, uint64_t seed = 0)
+    {
+        return hashBytes(text.data(), text.size(), seed);
+    }
+
+    // Sixteen hex digits, for cache file names
+    inline std::string hashName(uint64_t hash)
+    {
+        char name[17];
+        std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+        return name;
+    }
+
+} // namespace gfx
+
+#endif //DEMO_HASH_H
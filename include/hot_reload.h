@@ -0,0 +1,112 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_HOT_RELOAD_H
+#define DEMO_HOT_RELOAD_H
+#include <atomic>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glad/glad.h>
+
+#include "mesh.h"
+#include "thread_pool.h"
+
+class ShaderProgram;
+
+namespace gfx {
+
+    class MaterialLibrary;
+    class TextureManager;
+    class UploadThread;
+
+// ------------------------------------------------------------------
+// Live reload of files edited while the demo runs (inotify, Linux only;
+// elsewhere start() fails and nothing is watched).
+// A watcher thread sleeps on inotify and records which files changed. Each
+// frame, update() starts the rebuild of every watch those files touch on the
+// pool, then runs the finished rebuilds' GL halves, so a new version is
+// swapped in between frames. A rebuild that fails keeps the old version.
+// With no changes and nothing in flight, update() is one atomic load.
+// ------------------------------------------------------------------
+    class HotReload {
+    public:
+        // What a rebuild hands back to the GL thread
+        struct Rebuilt {
+            // Swaps the new version in; false to be called again next frame (e.g. a
+            // program still compiling). Empty when the rebuild failed.
+            std::function<bool()> apply;
+            // The files to watch from now on, when they changed (say a new #include)
+            std::vector<std::string> files;
+        };
+        // Runs on the pool: reads and decodes, no GL
+        using Rebuild = std::function<Rebuilt()>;
+
+        explicit HotReload(ThreadPool& pool = ThreadPool::shared());
+        ~HotReload();
+        HotReload(const HotReload&) = delete;
+        HotReload& operator=(const HotReload&) = delete;
+
+        // Watches the directories (and their subdirectories). False if none could be.
+        bool start(const std::vector<std::string>& directories);
+        void stop();
+        bool running() const;
+
+        void watch(const std::string& name, const std::vector<std::string>& files, Rebuild rebuild);
+
+        // Call once per frame on the GL thread, before drawing.
+        void update();
+
+    private:
+        enum class State { Idle, Loading, Applying };
+        struct Watch {
+            std::string name;
+            std::vector<std::string> files;     // normalized
+            Rebuild rebuild;
+            State state = State::Idle;
+            std::future<Rebuilt> loading;
+            std::function<bool()> apply;
+            bool again = false;                 // changed again while in flight
+        };
+
+        void start_(Watch& watch);
+        void finish_(Watch& watch);
+        void watchThread_();
+
+        ThreadPool& pool;
+        std::vector<Watch> watches;
+        int inFlight = 0;
+
+        std::mutex mutex;
+        std::set<std::string> changed;          // normalized paths, guarded by mutex
+        std::atomic<bool> dirty{ false };
+
+        int notifyFd = -1;
+        int wakeFd[2] = { -1, -1 };             // stop() writes here to end the watcher
+        std::vector<std::pair<int, std::string>> directoryOf;   // watch descriptor -> directory
+        std::thread watcher;
+    };
+
+    // Ready-made watches. Each reads the current files on disk, bypassing the asset
+    // pack and the shaders built into the binary.
+
+    // Stage files and everything they #include. A pipeline has only its own stage
+    // here: watch the shared vertex stage program too.
+    void watchProgram(HotReload& reload, ShaderProgram& program, const std::string& name);
+    // `options` as the mesh was loaded with. With `uploads` the new buffers are
+    // filled on the upload thread.
+    void watchMesh(HotReload& reload, Mesh& mesh, const std::string& path, UploadThread* uploads = nullptr,
+                   const Mesh::LoadOptions& options = {});
+    // A TextureManager texture (its handle stays valid across reloads)
+    void watchTexture(HotReload& reload, TextureManager& textures, GLuint texture, const std::string& name);
+    // Rebuilds the whole library when any map changes; onRebuilt rebinds pages
+    void watchMaterials(HotReload& reload, MaterialLibrary& materials, std::function<void()> onRebuilt);
+
+} // namespace gfx
+
+#endif //DEMO_HOT_RELOAD_H
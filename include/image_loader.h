@@ -0,0 +1,50 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_IMAGE_LOADER_H
+#define DEMO_IMAGE_LOADER_H
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "thread_pool.h"
+
+namespace gfx {
+
+// ------------------------------------------------------------------
+// Decoded 8-bit image. Pixels are tightly packed rows of `channels` bytes.
+// ------------------------------------------------------------------
+    struct Image {
+        struct PixelDeleter { void operator()(unsigned char* p) const; };
+
+        std::string path;
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+        std::unique_ptr<unsigned char, PixelDeleter> pixels;
+
+        bool valid() const { return pixels != nullptr; }
+        size_t byteSize() const { return static_cast<size_t>(width) * height * channels; }
+    };
+
+// ------------------------------------------------------------------
+// Thread-safe decoding. The flip flag is applied per call (stb's
+// thread-local override), so concurrent loads never race on stb's global.
+// Upload stays on the GL thread: decode here, hand the Image to GL later.
+// ------------------------------------------------------------------
+    Image loadImage(const std::string& path, bool flipVertical);
+    // Decodes an encoded file already in memory; `name` is only used for messages.
+    Image decodeImage(const unsigned char* bytes, size_t size, bool flipVertical, const std::string& name);
+
+    std::future<Image> loadImageAsync(const std::string& path, bool flipVertical,
+                                      ThreadPool& pool = ThreadPool::shared());
+
+    // Decodes all paths concurrently; results are in input order.
+    std::vector<Image> loadImages(const std::vector<std::string>& paths, bool flipVertical,
+                                  ThreadPool& pool = ThreadPool::shared());
+
+} // namespace gfx
+
+#endif //DEMO_IMAGE_LOADER_H
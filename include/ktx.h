@@ -0,0 +1,75 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_KTX_H
+#define DEMO_KTX_H
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include <glad/glad.h>
+
+#include "asset_vfs.h"
+
+namespace gfx {
+
+// ------------------------------------------------------------------
+// KTX 1.1 textures: 2D or cube map, any number of mip levels, raw or
+// block-compressed. Reading maps the file (or its raw entry in the asset
+// pack) and points straight into it, so uploading a level is one copy from
+// the page cache.
+// ------------------------------------------------------------------
+    class KtxTexture {
+    public:
+        bool load(const std::string& path);
+
+        int width() const { return pixelWidth; }
+        int height() const { return pixelHeight; }
+        int levels() const { return levelCount; }
+        int faces() const { return faceCount; }
+        bool isCube() const { return faceCount == 6; }
+        bool isCompressed() const { return glType == 0; }
+
+        GLenum internalFormat() const { return glInternalFormat; }
+        GLenum format() const { return glFormat; }
+        GLenum type() const { return glType; }
+
+        // Face order is +X, -X, +Y, -Y, +Z, -Z
+        const uint8_t* imageData(int level, int face) const;
+        size_t imageSize(int level) const;
+
+        // Value for a key/value entry, or an empty string
+        std::string value(const std::string& key) const;
+
+    private:
+        AssetData file;
+        uint32_t glType = 0, glFormat = 0, glInternalFormat = 0;
+        int pixelWidth = 0, pixelHeight = 0, levelCount = 0, faceCount = 0;
+        std::vector<std::pair<std::string, std::string>> keyValues;
+        std::vector<const uint8_t*> images;     // [level * faces + face]
+        std::vector<size_t> sizes;              // per level, one face
+    };
+
+    struct KtxSource {
+        GLenum internalFormat = 0;        // e.g. GL_RGBA8 or a compressed format
+        GLenum format = 0;                // 0 for compressed formats
+        GLenum type = 0;                  // 0 for compressed formats
+        GLenum baseInternalFormat = 0;
+        int width = 0;
+        int height = 0;
+        int faces = 1;
+        std::vector<std::pair<std::string, std::string>> keyValues;
+        std::vector<std::vector<uint8_t>> images;   // [level * faces + face]
+    };
+
+    bool writeKtx(const std::string& path, const KtxSource& source);
+
+    inline bool isKtxPath(const std::string& path)
+    {
+        return path.size() > 4 && path.compare(path.size() - 4, 4, ".ktx") == 0;
+    }
+
+} // namespace gfx
+
+#endif //DEMO_KTX_H
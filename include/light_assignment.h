@@ -0,0 +1,91 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_LIGHT_ASSIGNMENT_H
+#define DEMO_LIGHT_ASSIGNMENT_H
+#include <vector>
+#include <glm.hpp>
+
+#include "bounds.h"
+#include "light_config.h"
+
+namespace gfx {
+
+    // A light stops influencing a surface once its brightest channel times
+    // attenuation falls below this (one 8-bit step).
+    constexpr float kLightCutoff = 1.0f / 256.0f;
+
+    // Per-object cap for each light type; matches the 8-bit packing below
+    // and the loops in container_fragment.frag.
+    constexpr int kMaxLightsPerObject = 4;
+    // Largest light index a slot can hold. setLights() only assigns lights the
+    // shader has (kMaxPointLights / kMaxSpotLights), which all fit.
+    constexpr int kMaxPackedLightIndex = 255;
+    static_assert(kMaxPointLights - 1 <= kMaxPackedLightIndex && kMaxSpotLights - 1 <= kMaxPackedLightIndex,
+                  "light indices must fit the 8-bit slots");
+
+// ------------------------------------------------------------------
+// Influence volumes derived from constant/linear/quadratic attenuation
+// ------------------------------------------------------------------
+    float attenuationRange(float constant, float linear, float quadratic,
+                           float intensity, float cutoff = kLightCutoff);
+    float pointLightRange(const PointLightConfig& L, float cutoff = kLightCutoff);
+    float spotLightRange(const SpotLightConfig& L, float cutoff = kLightCutoff);
+    // Sphere enclosing the spot light's cone out to its range.
+    BoundingSphere spotLightBounds(const SpotLightConfig& L, float cutoff = kLightCutoff);
+
+// ------------------------------------------------------------------
+// Lights chosen for one object, most significant first.
+// packed(): x = point indices, y = spot indices (8 bits each, slot 0 in the
+// low byte), z = point count | spot count << 8. Four slots per type and
+// indices up to kMaxPackedLightIndex: anything beyond is dropped (and
+// asserts in debug builds) rather than wrapped into another light.
+// Shaders receive it as the `objectLights` uniform or through the
+// GPU-driven instance buffer.
+// ------------------------------------------------------------------
+    struct ObjectLights {
+        int pointCount = 0;
+        int spotCount  = 0;
+        int point[kMaxLightsPerObject] = {};
+        int spot[kMaxLightsPerObject]  = {};
+
+        glm::uvec3 packed() const;
+    };
+
+    class LightAssigner {
+    public:
+        explicit LightAssigner(float cutoff = kLightCutoff);
+
+        // Rebuild light volumes; call whenever a light moves or changes.
+        void setLights(const SceneConfig& cfg);
+
+        ObjectLights assign(const AABB& objectBounds) const;
+        void assign(const std::vector<AABB>& objectBounds, std::vector<ObjectLights>& out) const;
+
+    private:
+        struct PointVolume {
+            glm::vec3 position;
+            float range;
+            float intensity;
+            float constant, linear, quadratic;
+        };
+
+        struct SpotVolume {
+            glm::vec3 position;
+            glm::vec3 direction;
+            float range;
+            float intensity;
+            float constant, linear, quadratic;
+            float cosOuter, sinOuter;
+            BoundingSphere bounds;
+        };
+
+        float cutoff;
+        std::vector<PointVolume> points;
+        std::vector<SpotVolume> spots;
+    };
+
+} // namespace gfx
+
+#endif //DEMO_LIGHT_ASSIGNMENT_H
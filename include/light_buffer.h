@@ -0,0 +1,54 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_LIGHT_BUFFER_H
+#define DEMO_LIGHT_BUFFER_H
+#include <vector>
+#include <glad/glad.h>
+
+#include "light_config.h"
+#include "shaderprogram.h"
+
+namespace gfx {
+
+    // Binding points of the PointLights / SpotLights blocks in container_fragment.frag
+    constexpr GLuint kPointLightBinding = 0;
+    constexpr GLuint kSpotLightBinding  = 1;
+
+// ------------------------------------------------------------------
+// Point and spot lights of the scene in two std140 uniform buffers, one
+// upload per change for every lit program. The per-object slots
+// (gfx::ObjectLights::packed) index straight into them, so a fragment pays
+// for the lights assigned to its object, not for how many the scene holds.
+// Lights past kMaxPointLights / kMaxSpotLights are dropped with a warning.
+// ------------------------------------------------------------------
+    class LightBuffer {
+    public:
+        LightBuffer() = default;
+        ~LightBuffer();
+        LightBuffer(const LightBuffer&) = delete;
+        LightBuffer& operator=(const LightBuffer&) = delete;
+
+        // GL thread. The first call creates the buffers and binds them to their points.
+        void setPointLights(const std::vector<PointLightConfig>& lights);
+        void setSpotLights(const std::vector<SpotLightConfig>& lights);
+
+        // Points the program's light blocks at the binding points (hot reload carries
+        // the bindings over to the replacement program).
+        static void attach(const ShaderProgram& program);
+
+        void cleanup();
+
+    private:
+        void create_();
+
+        GLuint pointBuffer = 0;
+        GLuint spotBuffer = 0;
+        bool warnedPoints = false;
+        bool warnedSpots = false;
+    };
+
+} // namespace gfx
+
+#endif //DEMO_LIGHT_BUFFER_H
@@ -4,6 +4,8 @@
 
 #ifndef DEMO_LIGHTS_CONFIG_H
 #define DEMO_LIGHTS_CONFIG_H
+#include <algorithm>
+#include <iostream>
 #include <string>
 #include <vector>
 #include <glm.hpp>
@@ -13,9 +15,15 @@
 
 namespace gfx {
 
+    // Capacity of the light arrays in lighting.glsl (MAX_*_LIGHTS); lights past
+    // these are not lit. The point and spot blocks are sized to fit the 16 KB
+    // uniform block every GL implementation supports.
+    constexpr int kMaxDirLights   = 4;
+    constexpr int kMaxPointLights = 255;
+    constexpr int kMaxSpotLights  = 128;
+
     struct DirLightConfig {
         glm::vec3 direction { -0.2f, -1.0f, -0.3f };
-        glm::vec3 ambient   { 0.05f, 0.05f, 0.05f };
         glm::vec3 diffuse   { 0.6f,  0.6f,  0.6f  };
         glm::vec3 specular  { 0.8f,  0.8f,  0.8f  };
     };
@@ -27,7 +35,6 @@ namespace gfx {
         float linear    = 0.09f;
         float quadratic = 0.032f;
 
-        glm::vec3 ambient  { 0.05f, 0.05f, 0.05f };
         glm::vec3 diffuse  { 0.8f,  0.8f,  0.8f  };
         glm::vec3 specular { 1.0f,  1.0f,  1.0f  };
     };
@@ -43,7 +50,6 @@ namespace gfx {
         float linear    = 0.09f;
         float quadratic = 0.032f;
 
-        glm::vec3 ambient  { 0.0f, 0.0f, 0.0f };
         glm::vec3 diffuse  { 1.0f, 1.0f, 1.0f };
         glm::vec3 specular { 1.0f, 1.0f, 1.0f };
     };
@@ -69,8 +75,8 @@ namespace gfx {
     }
 
 // ------------------------------------------------------------------
-// Lights: array-style helpers (variable count via vector::size())
-// GLSL side: dirLights[i], pointLights[i], spotLights[i]
+// Directional lights are plain uniform arrays: dirLights[i], numDirLights.
+// Point and spot lights live in gfx::LightBuffer.
 // ------------------------------------------------------------------
 
     inline void applyDirLights(ShaderProgram& shader,
@@ -79,60 +85,19 @@ namespace gfx {
                                const std::string& countName = "numDirLights")
     {
         shader.use();
-        int n = static_cast<int>(L.size());
+        int n = std::min(static_cast<int>(L.size()), kMaxDirLights);
+        if (n < static_cast<int>(L.size()))
+            std::cerr << "applyDirLights: " << L.size() << " directional lights, only the first "
+                      << kMaxDirLights << " are lit\n";
         shader.setUniform(countName, n);      // can be 0
         for (int i = 0; i < n; ++i) {
             std::string base = arrayName + "[" + std::to_string(i) + "]";
             shader.setUniform(base + ".direction", L[i].direction);
-            shader.setUniform(base + ".ambient",   L[i].ambient);
             shader.setUniform(base + ".diffuse",   L[i].diffuse);
             shader.setUniform(base + ".specular",  L[i].specular);
         }
     }
 
-    inline void applyPointLights(ShaderProgram& shader,
-                                 const std::vector<PointLightConfig>& L,
-                                 const std::string& arrayName = "pointLights",
-                                 const std::string& countName = "numPointLights")
-    {
-        shader.use();
-        int n = static_cast<int>(L.size());
-        shader.setUniform(countName, n);      // can be 0
-        for (int i = 0; i < n; ++i) {
-            std::string base = arrayName + "[" + std::to_string(i) + "]";
-            shader.setUniform(base + ".position",  L[i].position);
-            shader.setUniform(base + ".constant",  L[i].constant);
-            shader.setUniform(base + ".linear",    L[i].linear);
-            shader.setUniform(base + ".quadratic", L[i].quadratic);
-            shader.setUniform(base + ".ambient",   L[i].ambient);
-            shader.setUniform(base + ".diffuse",   L[i].diffuse);
-            shader.setUniform(base + ".specular",  L[i].specular);
-        }
-    }
-
-    inline void applySpotLights(ShaderProgram& shader,
-                                const std::vector<SpotLightConfig>& L,
-                                const std::string& arrayName = "spotLights",
-                                const std::string& countName = "numSpotLights")
-    {
-        shader.use();
-        int n = static_cast<int>(L.size());
-        shader.setUniform(countName, n);      // can be 0
-        for (int i = 0; i < n; ++i) {
-            std::string base = arrayName + "[" + std::to_string(i) + "]";
-            shader.setUniform(base + ".position",    L[i].position);
-            shader.setUniform(base + ".direction",   L[i].direction);
-            shader.setUniform(base + ".cutOff",      L[i].cutOff);
-            shader.setUniform(base + ".outerCutOff", L[i].outerCutOff);
-            shader.setUniform(base + ".constant",    L[i].constant);
-            shader.setUniform(base + ".linear",      L[i].linear);
-            shader.setUniform(base + ".quadratic",   L[i].quadratic);
-            shader.setUniform(base + ".ambient",     L[i].ambient);
-            shader.setUniform(base + ".diffuse",     L[i].diffuse);
-            shader.setUniform(base + ".specular",    L[i].specular);
-        }
-    }
-
 } // namespace gfx
 
 #endif //DEMO_LIGHTS_CONFIG_H
@@ -0,0 +1,31 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_LZ4_BLOCK_H
+#define DEMO_LZ4_BLOCK_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gfx {
+
+// ------------------------------------------------------------------
+// LZ4 block format (no frame header): what the asset pack stores its index
+// and compressible entries in. The compressor is a single-pass greedy
+// matcher, fine for offline packing; decompression is the fast path.
+// ------------------------------------------------------------------
+    std::vector<uint8_t> lz4Compress(const uint8_t* data, size_t size);
+
+    // Decodes exactly `size` bytes into `out`. False on malformed input
+    // instead of reading or writing out of bounds.
+    bool lz4Decompress(const uint8_t* data, size_t dataSize, uint8_t* out, size_t size);
+
+    // Upper bound on what `dataSize` bytes of LZ4 can decode to (each extra
+    // length byte adds at most 255): sizes read from a file are checked against
+    // it before anything is allocated for them.
+    uint64_t lz4MaxDecodedSize(uint64_t dataSize);
+
+} // namespace gfx
+
+#endif //DEMO_LZ4_BLOCK_H
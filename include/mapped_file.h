@@ -0,0 +1,43 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_MAPPED_FILE_H
+#define DEMO_MAPPED_FILE_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gfx {
+
+// ------------------------------------------------------------------
+// Read-only view of a whole file: mmap'd on POSIX, read into memory elsewhere.
+// ------------------------------------------------------------------
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const std::string& path);
+        ~MappedFile();
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool open(const std::string& path);
+        void close();
+
+        bool isOpen() const { return bytes != nullptr; }
+        const uint8_t* data() const { return bytes; }
+        size_t size() const { return length; }
+
+    private:
+        const uint8_t* bytes = nullptr;
+        size_t length = 0;
+        bool mapped = false;
+        std::vector<uint8_t> fallback;
+    };
+
+} // namespace gfx
+
+#endif //DEMO_MAPPED_FILE_H
@@ -0,0 +1,113 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_MATERIAL_LIBRARY_H
+#define DEMO_MATERIAL_LIBRARY_H
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <glad/glad.h>
+#include <glm.hpp>
+
+#include "thread_pool.h"
+
+namespace gfx {
+
+    class TextureResidency;
+
+// ------------------------------------------------------------------
+// Material maps packed into GL_TEXTURE_2D_ARRAYs.
+// Materials whose maps share size, format and mip count land in the same
+// "page": one diffuse array and one specular array, a layer per material.
+// Objects address their material by (layer, shininess), so any number of
+// differently textured objects on one page draw without rebinding.
+// ------------------------------------------------------------------
+    class MaterialLibrary {
+    public:
+        MaterialLibrary();
+        ~MaterialLibrary();
+        MaterialLibrary(const MaterialLibrary&) = delete;
+        MaterialLibrary& operator=(const MaterialLibrary&) = delete;
+
+        // Block-compress decoded maps (cached in cacheDir), as TextureManager does.
+        bool enableCompression(const std::string& cacheDir);
+
+        // Upload only each page's coarse tail at build(); finer mips stream in
+        // through `residency` as request() asks for them. Call before build().
+        void enableResidency(TextureResidency* residency);
+
+        // Maps may be images or 2D .ktx files. A missing specular map reads black.
+        // Materials with the same maps share one layer; identical adds return the same id.
+        int add(const std::string& diffusePath, const std::string& specularPath = {}, float shininess = 32.0f);
+
+        // The CPU half of build(): reads and decodes every map on the pool without
+        // any GL calls, so it can run on a worker while the context does other work.
+        // False if any map failed to load (build() still falls back to white for it).
+        bool load(ThreadPool& pool = ThreadPool::shared());
+
+        // Uploads the arrays, loading the maps first unless load() already did.
+        // Maps that fail to load fall back to a plain white layer so ids stay valid.
+        bool build(ThreadPool& pool = ThreadPool::shared());
+
+        struct Slot {
+            int page = -1;
+            int layer = 0;
+            float shininess = 32.0f;
+
+            // What cube_vertex*.vert expect per draw/instance: (layer, shininess)
+            glm::vec2 params() const { return { static_cast<float>(layer), shininess }; }
+        };
+        const Slot& slot(int material) const;
+        // Every map file the materials use
+        std::vector<std::string> mapFiles() const;
+        size_t pageCount() const;
+        void bindPage(int page, GLint diffuseUnit, GLint specularUnit) const;
+
+        // An object using `material` covers about `pixels` on screen this frame (see projectedSize)
+        void request(int material, float pixels);
+
+        struct Stats {
+            size_t materials = 0;
+            size_t pages = 0;
+            size_t layers = 0;
+            size_t bytes = 0;   // estimated VRAM, mips included
+        };
+        const Stats& stats() const;
+        void printStats(std::ostream& out) const;
+
+        void cleanup();
+
+    private:
+        struct Material {
+            std::string diffuse;
+            std::string specular;
+            Slot slot;
+        };
+
+        struct Page {
+            GLuint diffuse = 0;
+            GLuint specular = 0;
+            int width = 0;
+            int diffuseHandle = -1;
+            int specularHandle = -1;
+        };
+
+        std::vector<Material> materials;
+        std::map<std::tuple<std::string, std::string, float>, int> idOf;
+        std::vector<Page> pages;
+        std::string compressionCache;
+        bool compression = false;
+        TextureResidency* residency = nullptr;
+        Stats statistics;
+
+        struct LoadedMaps;
+        std::unique_ptr<LoadedMaps> loaded;     // from load(), consumed by build()
+    };
+
+} // namespace gfx
+
+#endif //DEMO_MATERIAL_LIBRARY_H
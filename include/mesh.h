@@ -10,21 +10,45 @@
 #include <gtc/type_ptr.hpp>
 #include <cstddef>
 #include <shaderprogram.h>
+#include "bounds.h"
+#include "vertex_layout.h"
 
-struct VertexAttribute {
-    GLuint pos;         // attribute location (index) in the shader
-    GLint size;         // number of components (e.g., 3 for vec3)
-    GLenum type;        // GL_FLOAT, etc.
-    GLboolean normalized;
-    GLsizei stride;     // byte stride of the vertex
-    size_t offset;      // byte offset to the first component
+// How a file is turned into geometry; part of gfx::MeshCache's key
+struct MeshLoadOptions {
+    float scale = 1.0f;         // applied to positions
+    bool flipTexCoords = false; // v -> 1 - v
 };
 
 class Mesh {
 public:
-    Mesh(std::vector<float> v, std::vector<unsigned int> idx, GLuint id);
-    Mesh(const std::string& path, GLuint id);
+    // 20 bytes per vertex: float position, octahedral snorm16 normal, half-float uv
+    using VertexFormat = gfx::VertexLayout<gfx::Position3f, gfx::NormalOct16, gfx::UV2h>;
+    using Vertices = gfx::VertexData<VertexFormat>;
+
+    // CPU-side result of parsing a model, ready to upload
+    struct Geometry {
+        Vertices vertices;
+        std::vector<unsigned int> indices;
+        gfx::AABB bounds;
+    };
+    using LoadOptions = MeshLoadOptions;
+    // Reads and triangulates an OBJ file without touching GL, so it can run on a worker.
+    static Geometry parseOBJ(const std::string& path, const LoadOptions& options = {});
+
+    // Attributes sit at the engine-wide locations (vertex_attributes.h): any program draws it
+    Mesh(const std::string& path, const LoadOptions& options = {});
+    explicit Mesh(Geometry geometry);
     ~Mesh();
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+
+    // Replaces the geometry and its GPU buffers in place (hot reload)
+    void setGeometry(Geometry geometry);
+    // Same, with buffers createBuffers() filled on another context (gfx::UploadThread).
+    // The mesh takes them over; only the VAO, which contexts don't share, is built here.
+    void setGeometry(Geometry geometry, GLuint vertexBuffer, GLuint indexBuffer);
+    // Vertex and index buffers for `geometry` on the current context
+    static void createBuffers(const Geometry& geometry, GLuint& vertexBuffer, GLuint& indexBuffer);
 
     // Drawing
     void draw() const;
@@ -34,17 +58,23 @@ public:
 
     // Resource cleanup (safe to call multiple times)
     void cleanup();
-    bool loadOBJ_(const std::string& path);
+    bool loadOBJ_(const std::string& path, const LoadOptions& options = {});
+
+    // CPU-side copy of the interleaved geometry (see VertexFormat) and its local bounds
+    const Vertices& getVertices() const;
+    const std::vector<unsigned int>& getIndices() const;
+    const gfx::AABB& getBounds() const;
 private:
     // Buffer setup helpers
     void createBuffers_();
+    void createVertexArray_();
 
     GLuint VAO = 0, VBO = 0, EBO = 0;
     GLsizei indexCount = 0;
 
-    GLuint shaderProgramID;
-    std::vector<float> vertices = {};
+    Vertices vertices;
     std::vector<unsigned int> indices = {};
+    gfx::AABB bounds;
 
 };
 
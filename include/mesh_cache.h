@@ -0,0 +1,75 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_MESH_CACHE_H
+#define DEMO_MESH_CACHE_H
+#include <future>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "mesh.h"
+
+namespace gfx {
+
+// ------------------------------------------------------------------
+// Shared meshes keyed by path and Mesh::LoadOptions. However many objects
+// ask for a file, it is parsed once and uploaded once; since attribute
+// locations are engine-wide, every program draws that one GPU copy.
+// Every acquire adds a reference; the mesh is deleted when the last
+// reference is released.
+// ------------------------------------------------------------------
+    class MeshCache {
+    public:
+        MeshCache() = default;
+        ~MeshCache();
+        MeshCache(const MeshCache&) = delete;
+        MeshCache& operator=(const MeshCache&) = delete;
+
+        // Parses on the calling thread for a later acquire (startup graph CPU tasks).
+        // Any thread; a file already parsed or being parsed is not parsed again.
+        void load(const std::string& path, const Mesh::LoadOptions& options = {});
+        // Same, on the pool
+        void prefetch(const std::string& path, const Mesh::LoadOptions& options = {});
+
+        // GL thread. Uploads on the first acquire of a key (parsing first if nothing
+        // loaded it), later ones share it. Null if the file has no geometry.
+        Mesh* acquire(const std::string& path, const Mesh::LoadOptions& options = {});
+        void release(const Mesh* mesh);
+
+        struct Stats {
+            size_t hits = 0;
+            size_t misses = 0;
+            size_t meshes = 0;
+            size_t residentBytes = 0;  // vertex and index buffers of live meshes
+            size_t savedBytes = 0;     // uploads avoided by cache hits
+        };
+        const Stats& stats() const;
+        void printStats(std::ostream& out) const;
+
+        void clear();
+
+    private:
+        using Parsed = std::shared_future<std::shared_ptr<Mesh::Geometry>>;
+        struct Entry {
+            std::unique_ptr<Mesh> mesh;
+            int refs = 0;
+            size_t bytes = 0;
+        };
+
+        static std::string key_(const std::string& path, const Mesh::LoadOptions& options);
+
+        std::unordered_map<std::string, Entry> entries;
+        std::unordered_map<const Mesh*, std::string> keyOf;
+        Stats statistics;
+
+        std::mutex mutex;                               // guards parsed
+        std::unordered_map<std::string, Parsed> parsed; // loaded, not acquired yet
+    };
+
+} // namespace gfx
+
+#endif //DEMO_MESH_CACHE_H
@@ -0,0 +1,41 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_MIPMAP_H
+#define DEMO_MIPMAP_H
+#include <cstdint>
+#include <vector>
+
+#include "image_loader.h"
+#include "thread_pool.h"
+
+namespace gfx {
+
+    struct MipLevel {
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> rgba;
+    };
+
+    // RGBA8 copy of a 1-4 channel image (gray is replicated, missing alpha is opaque).
+    std::vector<uint8_t> expandToRGBA(const Image& image);
+
+    // Color images are sRGB-encoded and filtered in linear light; gray images
+    // (specular masks and other data) are filtered as stored.
+    bool prefersSrgbMips(const Image& image);
+
+    // Halves an RGBA8 level with a 2x2 box filter; odd edges reuse the last row/column.
+    // With `srgb` RGB is averaged in linear light, alpha always linearly. Rows are split
+    // across the pool; the inner loop uses SSE2 (linear) or AVX2 gathers (sRGB) when present.
+    MipLevel downsampleRGBA(const MipLevel& source, bool srgb = false, ThreadPool& pool = ThreadPool::shared());
+
+    // Level 0 followed by every smaller level down to 1x1.
+    std::vector<MipLevel> buildMipChain(const Image& image, bool srgb = false, ThreadPool& pool = ThreadPool::shared());
+    // One chain per face (cube maps: +X -X +Y -Y +Z -Z), faces built concurrently.
+    std::vector<std::vector<MipLevel>> buildMipChains(const std::vector<Image>& faces, bool srgb = false,
+                                                      ThreadPool& pool = ThreadPool::shared());
+
+} // namespace gfx
+
+#endif //DEMO_MIPMAP_H
@@ -0,0 +1,103 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_MPMC_QUEUE_H
+#define DEMO_MPMC_QUEUE_H
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace gfx {
+
+// ------------------------------------------------------------------
+// Bounded lock-free queue, any number of producers and consumers
+// (D. Vyukov's array queue). Each cell carries a sequence number that says
+// whether it is free for the producer of that lap or full for the consumer
+// of that lap, so push and pop claim a cell with one CAS and never block.
+// Capacity is rounded up to a power of two; push fails when full.
+// ------------------------------------------------------------------
+    template <class T>
+    class MpmcQueue {
+    public:
+        explicit MpmcQueue(size_t capacity)
+        {
+            size_t size = 2;
+            while (size < capacity)
+                size <<= 1;
+            mask = size - 1;
+            cells = std::make_unique<Cell[]>(size);
+            for (size_t i = 0; i < size; ++i)
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        MpmcQueue(const MpmcQueue&) = delete;
+        MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+        // Moves from `value` only when there was room
+        template <class U>
+        bool push(U&& value)
+        {
+            size_t position = tail.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell& cell = cells[position & mask];
+                const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                const std::ptrdiff_t lap = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+                if (lap == 0) {
+                    if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        cell.value = std::forward<U>(value);
+                        cell.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (lap < 0) {
+                    return false;   // full: the consumer of the previous lap hasn't got here yet
+                } else {
+                    position = tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool pop(T& value)
+        {
+            size_t position = head.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell& cell = cells[position & mask];
+                const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                const std::ptrdiff_t lap = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+                if (lap == 0) {
+                    if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        value = std::move(cell.value);
+                        cell.value = T();
+                        cell.sequence.store(position + mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (lap < 0) {
+                    return false;   // empty
+                } else {
+                    position = head.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // A snapshot; exact only when no one is pushing or popping
+        bool empty() const
+        {
+            return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+        }
+
+    private:
+        struct Cell {
+            std::atomic<size_t> sequence{ 0 };
+            T value{};
+        };
+
+        std::unique_ptr<Cell[]> cells;
+        size_t mask = 0;
+        // Separate cache lines: producers and consumers don't slow each other down
+        alignas(64) std::atomic<size_t> tail{ 0 };
+        alignas(64) std::atomic<size_t> head{ 0 };
+    };
+
+} // namespace gfx
+
+#endif //DEMO_MPMC_QUEUE_H
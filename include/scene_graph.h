@@ -0,0 +1,77 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_SCENE_GRAPH_H
+#define DEMO_SCENE_GRAPH_H
+#include <cstdint>
+#include <vector>
+#include <glm.hpp>
+#include <gtc/quaternion.hpp>
+
+namespace gfx {
+
+    using NodeHandle = uint32_t;
+    constexpr NodeHandle kInvalidNode = 0xFFFFFFFFu;
+
+// ------------------------------------------------------------------
+// Transform hierarchy, the one place object transforms live.
+// Nodes are stored structure-of-arrays in breadth-first order: every level
+// is contiguous and the children of a node are contiguous within the next
+// level. Dirty nodes therefore map to one slot range per level, and
+// update() walks just those ranges top-down in a single linear pass.
+// Handles stay valid across the reorders done when nodes are added.
+// ------------------------------------------------------------------
+    class SceneGraph {
+    public:
+        NodeHandle createNode(NodeHandle parent = kInvalidNode,
+                              const glm::vec3& translation = glm::vec3(0.0f),
+                              const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                              const glm::vec3& scale = glm::vec3(1.0f));
+
+        void setLocal(NodeHandle node, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale);
+        void setTranslation(NodeHandle node, const glm::vec3& translation);
+        void setRotation(NodeHandle node, const glm::quat& rotation);
+        void setScale(NodeHandle node, const glm::vec3& scale);
+
+        // Recomputes world matrices below dirty nodes. Returns how many changed;
+        // does no work at all when nothing was touched.
+        size_t update();
+
+        // Valid after update()
+        const glm::mat4& world(NodeHandle node) const;
+        // Nodes whose world matrix changed during the last update()
+        const std::vector<NodeHandle>& changed() const;
+
+        size_t size() const;
+
+    private:
+        void markDirty_(uint32_t slot);
+        void rebuildOrder_();
+
+        // Per slot (breadth-first order)
+        std::vector<uint32_t>  parent;       // slot of the parent, kInvalidNode for roots
+        std::vector<uint32_t>  childBegin;   // children occupy [childBegin[s], childBegin[s + 1])
+        std::vector<uint16_t>  depth;
+        std::vector<glm::vec3> translation;
+        std::vector<glm::quat> rotation;
+        std::vector<glm::vec3> scale;
+        std::vector<glm::mat4> worldMatrix;
+        std::vector<uint8_t>   dirty;
+        std::vector<NodeHandle> slotToHandle;
+
+        std::vector<uint32_t> handleToSlot;
+        std::vector<NodeHandle> parentHandle;   // by handle; drives rebuildOrder_()
+
+        // Per depth level: dirty slot bounds [min, max]
+        std::vector<uint32_t> levelDirtyMin, levelDirtyMax;
+
+        std::vector<NodeHandle> changedList;
+        std::vector<uint32_t> updatedSlots;
+        size_t dirtyCount = 0;
+        bool orderDirty = false;
+    };
+
+} // namespace gfx
+
+#endif //DEMO_SCENE_GRAPH_H
@@ -0,0 +1,83 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_SCENE_QUERY_H
+#define DEMO_SCENE_QUERY_H
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+#include <glm.hpp>
+
+#include "bvh.h"
+#include "camera.h"
+#include "mesh.h"
+#include "thread_pool.h"
+
+namespace gfx {
+
+    struct RayHit {
+        int object = -1;          // -1 when nothing was hit
+        uint32_t triangle = 0;    // triangle index within the object's mesh
+        float distance = std::numeric_limits<float>::max();
+        glm::vec3 position { 0.0f };
+        glm::vec3 normal { 0.0f };
+    };
+
+    // World-space ray through a cursor position (pixels, origin top-left).
+    Ray screenRay(const Camera& camera, double cursorX, double cursorY, int width, int height);
+
+// ------------------------------------------------------------------
+// Ray queries for picking and hit-testing.
+// Objects are instances of meshes; a top-level BVH over their world bounds
+// leads to per-mesh triangle BVHs for the exact hit. Queries may run from
+// any thread, concurrently with each other and with updates. Added objects
+// and new transforms are staged and only become visible to queries, all at
+// once, in commit().
+// ------------------------------------------------------------------
+    class SceneQuery {
+    public:
+        int addMesh(const Mesh& mesh);
+        // -1 (and nothing staged) if meshId is not a mesh added earlier.
+        int addObject(int meshId, const glm::mat4& model);
+        // False (and nothing staged) if objectId was never returned by addObject.
+        bool setObjectTransform(int objectId, const glm::mat4& model);
+        // Rebuilds (objects added) or refits (objects moved) the top-level BVH.
+        void commit();
+
+        bool raycast(const Ray& ray, RayHit& hit,
+                     float maxDistance = std::numeric_limits<float>::max()) const;
+        // Rays are split across the pool; hits[i] answers rays[i].
+        void raycastBatch(const std::vector<Ray>& rays, std::vector<RayHit>& hits,
+                          float maxDistance = std::numeric_limits<float>::max(),
+                          ThreadPool& pool = ThreadPool::shared()) const;
+
+        size_t objectCount() const;   // committed objects
+
+    private:
+        struct Object {
+            int mesh;
+            glm::mat4 model;
+            glm::mat4 invModel;
+        };
+
+        bool raycastLocked_(const Ray& ray, RayHit& hit, float maxDistance) const;
+
+        mutable std::shared_mutex mutex;    // guards the committed state below
+        std::vector<std::unique_ptr<TriangleBVH>> meshes;
+        std::vector<Object> objects;
+        std::vector<AABB> objectBounds;
+        BVH topLevel;
+
+        std::mutex pendingMutex;            // guards the staged updates
+        int pendingObjectCount = 0;         // committed plus staged objects
+        std::vector<Object> pendingObjects; // ids from objects.size() on
+        std::unordered_map<int, glm::mat4> pendingTransforms;
+    };
+
+} // namespace gfx
+
+#endif //DEMO_SCENE_QUERY_H
@@ -0,0 +1,34 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_SHADER_SOURCE_H
+#define DEMO_SHADER_SOURCE_H
+#include <string>
+#include <vector>
+
+namespace gfx {
+
+// ------------------------------------------------------------------
+// GLSL sources with #include support.
+// `#include "file"` is resolved against the including file's directory and
+// pasted in once per program (a second include of the same file is dropped,
+// so shared headers need no guards). #line directives keep compiler errors
+// pointing at the right file: "N:line" where N is the file's number in the
+// comment on its first #line.
+// ------------------------------------------------------------------
+
+    // Reads `path` and expands its includes. Every file read (path first) is
+    // appended to `dependencies` when given. Empty if any file is missing.
+    std::string preprocessShader(const std::string& path, std::vector<std::string>* dependencies = nullptr);
+
+    // Source for a shader under SHADER_DIR as preprocessed at build time
+    // (tools/shader_embed.cpp), so startup reads no shader files. Paths outside
+    // SHADER_DIR, and every path when built with GFX_SHADERS_FROM_DISK (the
+    // SHADERS_FROM_DISK CMake option, for editing shaders without rebuilding),
+    // go through preprocessShader.
+    std::string shaderSource(const std::string& path);
+
+} // namespace gfx
+
+#endif //DEMO_SHADER_SOURCE_H
@@ -2,28 +2,87 @@
 #define SHADERPROGRAM_H
 
 #include <string>
+#include <utility>
+#include <vector>
 #include "glad/glad.h"
 #include "GLFW/glfw3.h"
 #include <glm.hpp>
 #include <gtc/matrix_transform.hpp>
 #include <gtc/type_ptr.hpp>
 #include "stb_image.h"
+#include "image_loader.h"
 
 class ShaderProgram {
 public:
     ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath);
+    // Starts compiling and returns at once. Build several programs this way before
+    // loading assets and the driver overlaps the work (GL_KHR_parallel_shader_compile
+    // runs it on its own threads, which gfx::loadGLExtensions() asks for). Any use() /
+    // setUniform() / getID() waits for it, so startup still blocks until every program
+    // it draws with has linked; only hot reload polls isReady() and keeps drawing with
+    // the old program meanwhile.
+    struct Deferred {};
+    ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath, Deferred);
+    // Compute-only program (requires a GL 4.3 context)
+    explicit ShaderProgram(const std::string& computePath);
+    // Stages whose sources are already in memory, e.g. preprocessed on a worker
+    struct Stage {
+        GLenum type;
+        std::string source;
+    };
+    ShaderProgram(const std::vector<Stage>& stages, Deferred, bool separable = false);
+
+    // Separate shader objects (GL 4.1 / ARB_separate_shader_objects): one stage
+    // compiled and linked on its own, deferred, so several pipelines can share it.
+    struct Separable {};
+    ShaderProgram(GLenum stageType, const std::string& path, Separable);
+    // Pipeline of the shared `vertexStage` and this program's own fragment stage.
+    // It behaves like any other program: use() binds the pipeline, setUniform()
+    // sets the uniform on whichever stage declares it (so vertex stage uniforms
+    // are shared by every pipeline using that stage), and getID() is the vertex
+    // stage, where attribute locations live. `vertexStage` must outlive it.
+    ShaderProgram(const ShaderProgram& vertexStage, const std::string& fragmentPath, Deferred);
+    static bool supportsPipelines();
     ~ShaderProgram();
 
+    // Linked programs are saved (glGetProgramBinary) under cacheDir, keyed by the
+    // stage sources and the driver, and later runs load them instead of compiling.
+    // Stays off without GL 4.1 / ARB_get_program_binary. Call before creating programs.
+    static void enableBinaryCache(const std::string& cacheDir);
+
     void use() const;
     GLuint getID() const;
 
     void destroy();
 
+    // False while a deferred program is still compiling; never blocks.
+    bool isReady() const;
+    // Waits for a deferred program and reports compile/link errors; true if linked.
+    bool finish() const;
+
+    // The files each stage was read from (empty for in-memory stages)
+    const std::vector<std::pair<GLenum, std::string>>& stageFiles() const;
+    bool isSeparable() const;
+    // Hot reload: takes over `replacement`'s program so this object, and every
+    // reference to it, runs the new code. Uniform values and uniform block bindings
+    // carry over. Returns false and keeps the current program if the replacement
+    // failed to compile or link, or moved a vertex attribute meshes already use.
+    bool adopt(ShaderProgram& replacement);
+
     // Set uniform variables of various types
     void setUniform(const std::string& name, int value) const;
     void setUniform(const std::string& name, float value) const;
+    void setUniform(const std::string& name, const glm::vec2& value) const;
+    void setUniform(const std::string& name, const glm::ivec2& value) const;
     void setUniform(const std::string& name, const glm::vec3& value) const;
+    void setUniform(const std::string& name, const glm::vec4& value) const;
+    void setUniform(const std::string& name, const glm::uvec3& value) const;
     void setUniform(const std::string& name, const glm::mat4& value) const;
+    // Uniform array `name[count]`
+    void setUniform(const std::string& name, const glm::vec3* values, int count) const;
+    // Reads uniform block `name` from buffer binding point `binding`
+    void bindUniformBlock(const std::string& name, GLuint binding) const;
+    // Uncached: every call creates a new texture. Shared assets belong in gfx::TextureManager.
     GLuint bindTexture2D(const std::string& samplerName,
                          const std::string& filePath,
                          GLint textureUnit,
@@ -32,6 +91,14 @@ public:
                          GLint minFilter = GL_LINEAR_MIPMAP_LINEAR,
                          GLint magFilter = GL_LINEAR,
                          bool generateMipmaps = true) const;
+    // Upload an image decoded ahead of time (see gfx::loadImageAsync)
+    GLuint bindTexture2D(const std::string& samplerName,
+                         const gfx::Image& image,
+                         GLint textureUnit,
+                         GLint wrap = GL_REPEAT,
+                         GLint minFilter = GL_LINEAR_MIPMAP_LINEAR,
+                         GLint magFilter = GL_LINEAR,
+                         bool generateMipmaps = true) const;
 
 
     GLuint bindCubeMap(const std::string& samplerName,
@@ -39,7 +106,13 @@ public:
                        GLint textureUnit,
                        bool flipVertical = false,
                        GLint wrap = GL_CLAMP_TO_EDGE,
-                       GLint minFilter = GL_LINEAR,
+                       GLint minFilter = GL_LINEAR_MIPMAP_LINEAR,
+                       GLint magFilter = GL_LINEAR) const;
+    GLuint bindCubeMap(const std::string& samplerName,
+                       const std::vector<gfx::Image>& faces,
+                       GLint textureUnit,
+                       GLint wrap = GL_CLAMP_TO_EDGE,
+                       GLint minFilter = GL_LINEAR_MIPMAP_LINEAR,
                        GLint magFilter = GL_LINEAR) const;
 
 
@@ -48,10 +121,33 @@ public:
 private:
     GLuint ID;
     bool isDeleted = false;
+    bool separable = false;
+
+    //Pipeline state: the shared stage and the program it was last attached as
+    GLuint pipeline = 0;
+    const ShaderProgram* sharedStage = nullptr;
+    mutable GLuint attachedStage = 0;
+
+    std::vector<std::pair<GLenum, std::string>> stagePaths;
 
     std::string loadShaderSource(const std::string& filePath);
     static GLuint compileShader(const std::string& source, GLenum shaderType);
-    void linkProgram(GLuint vertexShader, GLuint fragmentShader);
+    void linkProgram(const std::vector<GLuint>& shaders, bool retrievable = false);
+    void build(const std::vector<Stage>& stages);
+    GLint uniformLocation(const std::string& name) const;
+    void attachStages() const;
+    void copyUniformsTo(GLuint program) const;
+
+    static std::string binaryCachePath(const std::vector<Stage>& stages, bool separable);
+    bool loadBinary(const std::string& path);
+    void saveBinary(const std::string& path) const;
+    static std::string binaryCacheDir;
+
+    // Deferred compile state, settled by the first finish()
+    mutable bool pending = false;
+    mutable bool linked = false;
+    mutable std::vector<GLuint> pendingShaders;
+    mutable std::string pendingCachePath;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,47 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_SPHERICAL_HARMONICS_H
+#define DEMO_SPHERICAL_HARMONICS_H
+#include <array>
+#include <string>
+#include <vector>
+#include <glm.hpp>
+
+#include "image_loader.h"
+#include "thread_pool.h"
+
+class ShaderProgram;
+
+namespace gfx {
+
+// ------------------------------------------------------------------
+// Order-2 (9 coefficient) spherical harmonics of RGB radiance, in the
+// usual l/m order: (0,0) (1,-1) (1,0) (1,1) (2,-2) (2,-1) (2,0) (2,1) (2,2).
+// ------------------------------------------------------------------
+    struct SH9 {
+        std::array<glm::vec3, 9> c {};
+    };
+
+    // Projects a cube map (faces +X -X +Y -Y +Z -Z, rows top-down as GL takes
+    // them) onto SH9. Every texel contributes by its solid angle; texels are
+    // sRGB-decoded first, so the result is linear radiance. Rows of all faces
+    // are split across the pool.
+    SH9 projectCubeMap(const std::vector<Image>& faces, ThreadPool& pool = ThreadPool::shared());
+
+    // Convolves radiance with the clamped cosine lobe and folds in 1/pi and the
+    // basis constants, so a shader gets diffuse irradiance for normal n as
+    //   c0 + c1*y + c2*z + c3*x + c4*xy + c5*yz + c6*(3z^2-1) + c7*xz + c8*(x^2-y^2)
+    SH9 irradianceCoefficients(const SH9& radiance);
+
+    // Evaluates the polynomial above on the CPU (what the shader computes).
+    glm::vec3 evaluateIrradiance(const SH9& coefficients, const glm::vec3& normal);
+
+    // Uploads irradiance coefficients scaled by `intensity` to `uniform vec3 name[9]`.
+    void applyAmbientSH(ShaderProgram& shader, const SH9& coefficients, float intensity = 1.0f,
+                        const std::string& name = "ambientSH");
+
+} // namespace gfx
+
+#endif //DEMO_SPHERICAL_HARMONICS_H
@@ -0,0 +1,69 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_STARTUP_GRAPH_H
+#define DEMO_STARTUP_GRAPH_H
+#include <chrono>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "thread_pool.h"
+
+namespace gfx {
+
+// ------------------------------------------------------------------
+// Dependency graph for startup work.
+// CPU tasks (file reads, decodes, parsing) run on the pool as soon as
+// their inputs are done; GL tasks (uploads, links) run on the thread that
+// calls run(), which owns the context, in the order they become ready.
+// Tasks hand results to each other through state the caller owns.
+// A task that throws still counts as finished: its dependents are skipped
+// rather than run on missing inputs, and run() reports the failure.
+// Each task is timed so the startup breakdown and critical path can be
+// printed afterwards.
+// ------------------------------------------------------------------
+    class StartupGraph {
+    public:
+        using TaskId = int;
+
+        // Dependencies must be tasks added earlier, so the graph has no cycles.
+        TaskId cpu(const std::string& name, std::function<void()> fn, const std::vector<TaskId>& after = {});
+        TaskId gl(const std::string& name, std::function<void()> fn, const std::vector<TaskId>& after = {});
+
+        // Runs every task and returns when all have finished (or been skipped).
+        // False if any task threw; each failure is logged to std::cerr.
+        bool run(ThreadPool& pool = ThreadPool::shared());
+
+        // Per-task start and duration (ms from run()), the wall time, the summed
+        // task time and the longest dependency chain.
+        void printTimings(std::ostream& out) const;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Task {
+            std::string name;
+            bool onContext = false;
+            std::function<void()> fn;
+            std::vector<TaskId> after;
+            std::vector<TaskId> dependents;
+            int waiting = 0;
+            Clock::time_point start, end;
+            // Set when fn threw, or when a dependency failed and fn was skipped
+            std::string error;
+        };
+
+        TaskId add_(const std::string& name, bool onContext, std::function<void()> fn, const std::vector<TaskId>& after);
+        void execute_(TaskId id);
+        double ms_(Clock::time_point t) const;
+
+        std::vector<Task> tasks;
+        Clock::time_point started, finished;
+    };
+
+} // namespace gfx
+
+#endif //DEMO_STARTUP_GRAPH_H
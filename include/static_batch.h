@@ -0,0 +1,88 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_STATIC_BATCH_H
+#define DEMO_STATIC_BATCH_H
+#include <functional>
+#include <iosfwd>
+#include <vector>
+#include <glad/glad.h>
+#include <glm.hpp>
+
+#include "bounds.h"
+#include "mesh.h"
+#include "thread_pool.h"
+
+namespace gfx {
+
+// ------------------------------------------------------------------
+// Static batching for geometry that never moves once placed.
+// Objects are pre-transformed on the CPU and merged into one VBO/EBO per
+// material, ordered by a spatial grid so every grid cell ("chunk") is a
+// contiguous index range with its own bounds for culling. Draw with the
+// material's program bound and `model` set to identity.
+// ------------------------------------------------------------------
+    class StaticBatcher {
+    public:
+        explicit StaticBatcher(float chunkSize = 8.0f);
+        ~StaticBatcher();
+        StaticBatcher(const StaticBatcher&) = delete;
+        StaticBatcher& operator=(const StaticBatcher&) = delete;
+
+        // A material is whatever program and state the caller binds before drawing
+        // its batch (attributes are at the engine-wide locations); returns its id.
+        int addMaterial();
+        void add(const Mesh& mesh, const glm::mat4& model, int material);
+
+        // Transforms and merges everything added so far, then uploads it.
+        void build(ThreadPool& pool = ThreadPool::shared());
+
+        // Draws the material's chunks that intersect the frustum. With a
+        // perChunk callback (e.g. to upload chunk lights) each chunk is its
+        // own draw; without, visible chunks go out in one glMultiDrawElements.
+        // Returns the number of chunks drawn.
+        int draw(int material, const Frustum& frustum,
+                 const std::function<void(const AABB&)>& perChunk = {}) const;
+
+        struct Stats {
+            size_t objects = 0;
+            size_t batches = 0;
+            size_t chunks = 0;
+            size_t sourceBytes = 0;    // unique source meshes, as they would be drawn unbatched
+            size_t batchedBytes = 0;   // merged vertex + index buffers
+        };
+        const Stats& stats() const;
+        void printStats(std::ostream& out) const;
+
+        void cleanup();
+
+    private:
+        struct Placement {
+            const Mesh* mesh;
+            glm::mat4 model;
+            int material;
+        };
+
+        struct Chunk {
+            AABB bounds;
+            GLsizei indexCount = 0;
+            size_t firstIndex = 0;
+        };
+
+        struct Batch {
+            GLuint VAO = 0, VBO = 0, EBO = 0;
+            std::vector<Chunk> chunks;
+        };
+
+        void upload_(Batch& batch, const Mesh::Vertices& vertices, const std::vector<unsigned int>& indices);
+
+        float chunkSize;
+        std::vector<Placement> pending;
+        std::vector<Batch> batches;
+        Stats statistics;
+    };
+
+} // namespace gfx
+
+#endif //DEMO_STATIC_BATCH_H
@@ -0,0 +1,57 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_TEXTURE_COMPRESS_H
+#define DEMO_TEXTURE_COMPRESS_H
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+#include "image_loader.h"
+#include "thread_pool.h"
+
+namespace gfx {
+
+    // BC1 = DXT1 (opaque RGB, 4 bpp), BC3 = DXT5 (RGBA, 8 bpp), BC4 = RGTC1 (one channel, 4 bpp)
+    enum class BlockFormat { BC1, BC3, BC4 };
+
+    struct CompressedTexture {
+        struct Level {
+            int width = 0;
+            int height = 0;
+            size_t offset = 0;
+            size_t size = 0;
+        };
+
+        BlockFormat format = BlockFormat::BC1;
+        bool grayscale = false;           // BC4 holding a gray image: sample red into rgb
+        std::vector<Level> levels;        // level 0 first
+        std::vector<uint8_t> data;
+
+        bool valid() const { return !levels.empty(); }
+        GLenum glFormat() const;
+    };
+
+    // BC4 for single-channel or gray images, BC3 when any alpha is below 255, BC1 otherwise.
+    BlockFormat chooseBlockFormat(const Image& image);
+
+    // Block-compresses the image and (optionally) a box-filtered mip chain,
+    // filtered in linear light for the color formats (see mipmap.h).
+    // Block rows are encoded in parallel; inner loops use SSE2 where available.
+    CompressedTexture compressImage(const Image& image, BlockFormat format, bool mipmaps,
+                                    ThreadPool& pool = ThreadPool::shared());
+
+    // Compressed texture for a file, cached on disk under the hash of the file's
+    // bytes (plus flip): a hit skips both decode and compression.
+    CompressedTexture loadCompressedTexture(const std::string& path, bool flipVertical,
+                                            const std::string& cacheDir,
+                                            ThreadPool& pool = ThreadPool::shared());
+
+    // True when the context can sample BC1/BC3 (BC4/RGTC is core since 3.0).
+    bool supportsBlockCompression();
+
+} // namespace gfx
+
+#endif //DEMO_TEXTURE_COMPRESS_H
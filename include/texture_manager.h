@@ -0,0 +1,144 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_TEXTURE_MANAGER_H
+#define DEMO_TEXTURE_MANAGER_H
+#include <functional>
+#include <future>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+
+#include "image_loader.h"
+#include "texture_compress.h"
+#include "ktx.h"
+#include "texture_streamer.h"
+
+namespace gfx {
+
+    struct SamplerParams {
+        GLint wrap = GL_REPEAT;
+        GLint minFilter = GL_LINEAR_MIPMAP_LINEAR;
+        GLint magFilter = GL_LINEAR;
+        bool generateMipmaps = true;
+
+        static SamplerParams cubeDefaults() { return { GL_CLAMP_TO_EDGE, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, true }; }
+    };
+
+    // Upload decoded images to a new texture bound on the active unit.
+    // Mips are built on the CPU (mipmap.h), sRGB-correct for color images.
+    // Returns 0 if any image failed to decode.
+    GLuint uploadTexture2D(const Image& image, const SamplerParams& sampler);
+    GLuint uploadCubeMap(const std::vector<Image>& faces, const SamplerParams& sampler);
+    // Uploads pre-compressed levels; mips are used only if the sampler asks for them.
+    GLuint uploadCompressedTexture2D(const CompressedTexture& texture, const SamplerParams& sampler);
+    // 2D or cube KTX straight from the mapped file: immutable storage on 4.2+,
+    // then one sub-image upload per level and face.
+    GLuint uploadKtx(const KtxTexture& texture, const SamplerParams& sampler);
+
+// ------------------------------------------------------------------
+// Shared GL textures keyed by source path(s), sampler parameters and flip.
+// Every acquire adds a reference; the texture is deleted when the last
+// reference is released. Programs only point samplers at units (bind()).
+// The name acquire returns is a handle: streaming and reload swap the GL
+// texture behind it, and bind() binds whichever is current.
+// ------------------------------------------------------------------
+    class TextureManager {
+    public:
+        TextureManager() = default;
+        ~TextureManager();
+        TextureManager(const TextureManager&) = delete;
+        TextureManager& operator=(const TextureManager&) = delete;
+
+        // Block-compress 2D textures from now on (BC1/BC3/BC4, cached in cacheDir).
+        // Returns false and leaves textures uncompressed if the context lacks S3TC.
+        bool enableCompression(const std::string& cacheDir);
+
+        // Stream loads through `streamer` from now on: acquire returns at once and the
+        // texture reads black until its last band is uploaded. Prefetch is ignored then.
+        // Cube KTX files must go through acquireCube, the target is fixed up front.
+        void setStreamer(TextureStreamer* streamer);
+
+        // Start loading on the pool; a later acquire of the same file picks it up.
+        void prefetch(const std::string& path, bool flipVertical = false);
+        void prefetchCube(const std::vector<std::string>& faces, bool flipVertical = false);
+
+        // A ".ktx" path (or a single-entry face list) loads the pre-baked file as is.
+        GLuint acquire2D(const std::string& path, const SamplerParams& sampler = {}, bool flipVertical = false);
+        GLuint acquireCube(const std::vector<std::string>& faces,
+                           const SamplerParams& sampler = SamplerParams::cubeDefaults(),
+                           bool flipVertical = false);
+        void release(GLuint texture);
+
+        // Binds a managed texture (with its own target) to a texture unit.
+        void bind(GLuint texture, GLint unit) const;
+
+        // The files a managed texture was loaded from
+        std::vector<std::string> sources(GLuint texture) const;
+        // Hot reload (needs a streamer): loads the files again into a new texture and,
+        // once it is resident, swaps it in for `texture` and rebinds every unit bind()
+        // put the old one on. The old texture stays in use until then, and for good if
+        // the files no longer load. `texture` stays the handle to use: onDone gets it
+        // back once swapped, or 0 on failure.
+        bool reload(GLuint texture, std::function<void(GLuint)> onDone = {});
+
+        struct Stats {
+            size_t hits = 0;
+            size_t misses = 0;
+            size_t textures = 0;
+            size_t residentBytes = 0;  // estimated VRAM for live textures, mips included
+            size_t savedBytes = 0;     // uploads avoided by cache hits
+        };
+        const Stats& stats() const;
+        void printStats(std::ostream& out) const;
+
+        void clear();
+
+    private:
+        struct Entry {
+            GLuint texture = 0;     // what bind() binds
+            GLuint handle = 0;      // what acquire returned; names `texture` across swaps
+            GLenum target = GL_TEXTURE_2D;
+            int refs = 0;
+            size_t bytes = 0;
+            // What reload() needs to load it again
+            std::vector<std::string> paths;
+            SamplerParams sampler;
+            bool flipVertical = false;
+            bool compressed = false;
+        };
+
+        // Decoded pixels, or compressed blocks when compression is on for 2D
+        struct Source {
+            Image image;
+            CompressedTexture compressed;
+        };
+        using PendingKey = std::tuple<std::string, bool, bool>;  // path, flip, compressed
+
+        void prefetch_(const std::string& path, bool flipVertical, bool compressed);
+        Source load_(const std::string& path, bool flipVertical, bool compressed);
+        GLuint acquire_(const std::string& key, GLenum target, const std::vector<std::string>& paths,
+                        const SamplerParams& sampler, bool flipVertical);
+        GLuint stream_(const std::string& key, GLenum target, const std::vector<std::string>& paths,
+                       const SamplerParams& sampler, bool flipVertical, bool compressed);
+        std::future<StreamSource> loadStreamSource_(const Entry& entry) const;
+        bool swap_(const std::string& key, GLuint previous, GLuint texture, const StreamSource& source);
+
+        std::unordered_map<std::string, Entry> entries;
+        std::unordered_map<GLuint, std::string> keyOf;
+        std::map<PendingKey, std::future<Source>> pending;
+        std::string compressionCache;
+        bool compression = false;
+        TextureStreamer* streamer = nullptr;
+        Stats statistics;
+        mutable std::vector<GLuint> unitTextures;   // what bind() last put on each unit
+    };
+
+} // namespace gfx
+
+#endif //DEMO_TEXTURE_MANAGER_H
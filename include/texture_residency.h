@@ -0,0 +1,109 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_TEXTURE_RESIDENCY_H
+#define DEMO_TEXTURE_RESIDENCY_H
+#include <functional>
+#include <iosfwd>
+#include <vector>
+#include <glad/glad.h>
+#include <glm.hpp>
+
+#include "bounds.h"
+#include "texture_streamer.h"
+#include "thread_pool.h"
+
+namespace gfx {
+
+    // Height in pixels of a world-space sphere on screen. Spheres around the eye
+    // report an unbounded size (they want level 0).
+    float projectedSize(const BoundingSphere& sphere, const glm::vec3& eye, const glm::mat4& projection,
+                        float viewportHeight);
+
+    // Mip level whose resolution matches `pixels` of screen coverage for a texture
+    // `textureSize` texels across (one UV period over the covered area).
+    int mipForCoverage(int textureSize, float pixels);
+
+    struct ResidencyDesc {
+        GLuint texture = 0;
+        GLenum target = GL_TEXTURE_2D;       // GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP or GL_TEXTURE_2D_ARRAY
+        GLenum internalFormat = 0;
+        GLenum format = 0;
+        GLenum type = 0;                     // 0 = compressed
+        int width = 0;
+        int height = 0;
+        int layers = 0;                      // array depth
+        std::vector<size_t> levelBytes;      // VRAM per level over every face/layer; size() = level count
+        int residentBase = 0;                // finest level already uploaded at track()
+        // Runs on the pool: a keepLevels source holding levels [first, last]
+        std::function<StreamSource(int first, int last)> load;
+    };
+
+// ------------------------------------------------------------------
+// Keeps only the mip levels each texture needs resident.
+// Every frame callers request the finest level a visible use wants; update()
+// streams missing levels in the background (pool load, PBO upload) and lowers
+// GL_TEXTURE_BASE_LEVEL once they land. When the budget would be exceeded the
+// least recently used textures give up their finest levels first; a coarse
+// tail (tailSize texels and below) is never evicted.
+// ------------------------------------------------------------------
+    class TextureResidency {
+    public:
+        TextureResidency(size_t budgetBytes, TextureStreamer& streamer, int tailSize = 64,
+                         ThreadPool& pool = ThreadPool::shared());
+        TextureResidency(const TextureResidency&) = delete;
+        TextureResidency& operator=(const TextureResidency&) = delete;
+
+        // Finest level that stays resident for a texture of this size.
+        int tailLevel(int width, int height, int levels) const;
+
+        int track(ResidencyDesc desc);
+        void untrack(int handle);
+
+        // Per frame, any number of times per texture: the finest wins.
+        void request(int handle, int level);
+        void requestCoverage(int handle, float pixels);
+
+        // Once per frame after the frame's draws have made their requests (and
+        // before the next TextureStreamer::update()).
+        void update();
+
+        void setBudget(size_t budgetBytes);
+
+        struct Stats {
+            size_t budget = 0;
+            size_t residentBytes = 0;   // includes levels still streaming in
+            size_t loads = 0;
+            size_t evictions = 0;       // levels dropped
+            size_t loadingBytes = 0;
+        };
+        const Stats& stats() const;
+        void printStats(std::ostream& out) const;
+
+    private:
+        struct Tracked {
+            ResidencyDesc desc;
+            int base = 0;              // finest resident level (storage + BASE_LEVEL)
+            int loadingBase = -1;      // finest level of the load in flight, -1 if none
+            int wanted = 0;            // this frame's request
+            int tail = 0;
+            unsigned lastUsed = 0;
+            bool live = false;
+        };
+
+        size_t bytesBetween_(const Tracked& t, int first, int last) const;
+        bool evictOne_(int keep);
+        void freeLevel_(Tracked& t);
+
+        ThreadPool& pool;
+        TextureStreamer& streamer;
+        int tailSize;
+        unsigned frame = 1;
+        std::vector<Tracked> textures;
+        Stats statistics;
+    };
+
+} // namespace gfx
+
+#endif //DEMO_TEXTURE_RESIDENCY_H
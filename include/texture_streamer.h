@@ -0,0 +1,155 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_TEXTURE_STREAMER_H
+#define DEMO_TEXTURE_STREAMER_H
+#include <deque>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <vector>
+#include <glad/glad.h>
+
+#include "image_loader.h"
+#include "ktx.h"
+#include "texture_compress.h"
+#include "thread_pool.h"
+
+namespace gfx {
+
+    class UploadThread;
+
+    // One level (or one cube face / array layer of a level) as tightly packed rows.
+    // For block-compressed data a "row" is a row of 4x4 blocks.
+    struct StreamUpload {
+        GLenum target = GL_TEXTURE_2D;        // GL_TEXTURE_2D, a cube face or GL_TEXTURE_2D_ARRAY
+        GLint level = 0;
+        int layer = 0;                        // array layer (GL_TEXTURE_2D_ARRAY only)
+        int width = 0;
+        int height = 0;
+        GLint internalFormat = 0;
+        GLenum format = 0;                    // client format; unused when compressed
+        GLenum type = 0;                      // 0 = compressed, internalFormat names the blocks
+        size_t rowBytes = 0;
+        int rowHeight = 1;                    // pixel rows per stored row (4 for blocks)
+        GLint alignment = 1;                  // GL_UNPACK_ALIGNMENT of the rows
+        const uint8_t* data = nullptr;
+    };
+
+    struct StreamSource {
+        std::vector<StreamUpload> uploads;
+        std::shared_ptr<void> owner;          // keeps every upload's data alive
+        bool swizzleRed = false;              // gray stored in red: sample .rgb as red
+        size_t bytes = 0;                     // estimated VRAM once complete
+        int layers = 0;                       // array depth when uploads target GL_TEXTURE_2D_ARRAY
+        // Only (re)define the levels uploaded and leave base/max level and swizzle to the
+        // caller, so a texture stays sampleable while finer levels arrive (see TextureResidency)
+        bool keepLevels = false;
+
+        bool empty() const { return uploads.empty(); }
+    };
+
+    // Builders for the loaders the texture manager knows about; all run on workers.
+    // Image mips are built on the CPU (mipmap.h), so every source arrives complete.
+    StreamSource streamSourceFromImages(std::vector<Image> faces, bool mipmaps);
+    StreamSource streamSourceFromCompressed(CompressedTexture texture, bool useMipmaps);
+    StreamSource streamSourceFromKtx(const std::string& path, bool useMipmaps);
+
+// ------------------------------------------------------------------
+// Asynchronous texture uploads through a ring of pixel unpack buffers.
+// Loading happens on the pool; the GL thread maps a free PBO, a worker
+// copies a band of rows into it, and the next update() unmaps it and issues
+// the sub-image upload, fenced with glFenceSync. At most frameBudget bytes
+// are handed to GL per update(), so streaming never spikes a frame.
+// With an UploadThread, whole textures skip the PBOs and the frame budget:
+// its context allocates and fills them and update() only flips them complete.
+// ------------------------------------------------------------------
+    class TextureStreamer {
+    public:
+        explicit TextureStreamer(size_t frameBudget = 4u << 20, size_t slotBytes = 1u << 20, int slotCount = 4,
+                                 ThreadPool& pool = ThreadPool::shared());
+        ~TextureStreamer();
+        TextureStreamer(const TextureStreamer&) = delete;
+        TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+        // `texture` already exists (bound to `bindTarget`); its storage is (re)specified
+        // once the source arrives. onReady runs on the GL thread after the last band lands.
+        // With an upload thread the loader's context writes it: don't sample it before then.
+        void stream(GLuint texture, GLenum bindTarget, std::future<StreamSource> source,
+                    std::function<void(GLuint, const StreamSource&)> onReady = {});
+        // Drops queued work for a texture that is about to be deleted.
+        void cancel(GLuint texture);
+
+        // Loads that define a whole texture go to `uploads` from now on. Loads adding
+        // levels to a texture already in use (keepLevels) stay on the PBO path: another
+        // context must not redefine a texture this one is sampling.
+        void setUploadThread(UploadThread* uploads);
+
+        // Call once per frame on the GL thread.
+        void update();
+        // Blocks until everything queued is resident (loading screens, shutdown).
+        void finish();
+        bool busy() const;
+
+        struct Stats {
+            size_t lastFrameBytes = 0;
+            size_t peakFrameBytes = 0;
+            size_t totalBytes = 0;
+            size_t completed = 0;
+            size_t threadBytes = 0;   // handed to the upload thread instead
+        };
+        const Stats& stats() const;
+
+        void cleanup();
+
+    private:
+        struct Job {
+            GLuint texture = 0;
+            GLenum bindTarget = GL_TEXTURE_2D;
+            std::future<StreamSource> loading;
+            StreamSource source;
+            std::function<void(GLuint, const StreamSource&)> onReady;
+            size_t bandsLeft = 0;
+            bool started = false;
+            bool cancelled = false;
+        };
+
+        struct Band {
+            Job* job = nullptr;
+            size_t upload = 0;
+            int firstRow = 0;     // in stored rows
+            int rows = 0;
+        };
+
+        enum class SlotState { Free, Filling, InFlight };
+        struct Slot {
+            GLuint pbo = 0;
+            size_t capacity = 0;
+            SlotState state = SlotState::Free;
+            uint8_t* mapped = nullptr;
+            std::future<void> copy;
+            GLsync fence = nullptr;
+            Band band;
+        };
+
+        void startJob_(Job& job);
+        void startThreadJob_(Job& job);
+        void submit_(Slot& slot);
+        void bandDone_(Job& job);
+
+        ThreadPool& pool;
+        size_t frameBudget;
+        size_t slotBytes;
+        std::vector<Slot> slots;
+        std::list<Job> jobs;
+        std::deque<Band> bands;
+        std::deque<Slot*> filling;   // submission order
+        Stats statistics;
+        UploadThread* uploads = nullptr;
+    };
+
+} // namespace gfx
+
+#endif //DEMO_TEXTURE_STREAMER_H
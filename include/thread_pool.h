@@ -0,0 +1,63 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_THREAD_POOL_H
+#define DEMO_THREAD_POOL_H
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gfx {
+
+// ------------------------------------------------------------------
+// Fixed-size worker pool for CPU-side work (no GL calls on workers).
+// ------------------------------------------------------------------
+    class ThreadPool {
+    public:
+        // 0 = one worker per hardware thread, minus the caller's
+        explicit ThreadPool(unsigned threads = 0);
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Process-wide pool shared by loaders and query code.
+        static ThreadPool& shared();
+
+        unsigned size() const;
+
+        template <class F>
+        auto submit(F&& fn) -> std::future<decltype(fn())>
+        {
+            using R = decltype(fn());
+            auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(fn));
+            std::future<R> result = task->get_future();
+            enqueue_([task]() { (*task)(); });
+            return result;
+        }
+
+        // Runs body(chunkBegin, chunkEnd) over [begin, end) in chunks of
+        // `grain` and returns when all are done. The caller works too, so it
+        // is safe to call from inside a pool task.
+        void parallelFor(size_t begin, size_t end, size_t grain,
+                         const std::function<void(size_t, size_t)>& body);
+
+    private:
+        void enqueue_(std::function<void()> job);
+        void workerLoop_();
+
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> jobs;
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool stopping = false;
+    };
+
+} // namespace gfx
+
+#endif //DEMO_THREAD_POOL_H
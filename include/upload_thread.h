@@ -0,0 +1,82 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_UPLOAD_THREAD_H
+#define DEMO_UPLOAD_THREAD_H
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <glad/glad.h>
+
+#include "mpmc_queue.h"
+
+struct GLFWwindow;
+
+namespace gfx {
+
+// ------------------------------------------------------------------
+// GL uploads off the render thread. A loader thread owns a hidden window
+// whose context shares objects with the main one; jobs reach it through a
+// lock-free queue and run there (buffer data, texture levels...). Each is
+// followed by a fence, and the render thread's update() runs the job's
+// completion once the fence has signalled: that is where it swaps the new
+// buffer or texture in. Objects are shared between the contexts; VAOs and
+// framebuffers are not, so jobs only create buffers and textures.
+// ------------------------------------------------------------------
+    class UploadThread {
+    public:
+        explicit UploadThread(size_t capacity = 256);
+        ~UploadThread();
+        UploadThread(const UploadThread&) = delete;
+        UploadThread& operator=(const UploadThread&) = delete;
+
+        // Creates the shared context next to `window`'s and starts the thread. Call on
+        // the main thread (GLFW creates windows there only). False if the context
+        // can't be created; callers then keep uploading on the render thread.
+        bool start(GLFWwindow* window);
+        // Runs what is queued, completes it and joins. Call before glfwTerminate.
+        void stop();
+        bool running() const;
+
+        // From any thread. `upload` runs on the loader thread with its context current;
+        // `onComplete` runs on the render thread, in update(), once the GPU has executed
+        // everything `upload` issued. False when not running or the queue is full, and
+        // the caller uploads itself.
+        bool submit(std::function<void()> upload, std::function<void()> onComplete = {});
+
+        // Render thread, once per frame: completes uploads whose fences have signalled.
+        void update();
+        // Submitted uploads not completed yet
+        bool busy() const;
+
+    private:
+        struct Job {
+            std::function<void()> upload;
+            std::function<void()> onComplete;
+            GLsync fence = nullptr;
+        };
+
+        void run_();
+
+        MpmcQueue<Job> jobs;          // any thread -> loader
+        MpmcQueue<Job> done;          // loader -> render thread, fenced
+        std::deque<Job> waiting;      // render thread: popped, fence not signalled yet
+        std::atomic<int> outstanding{ 0 };
+
+        std::mutex mutex;             // only to sleep on: the queues themselves take no lock
+        std::condition_variable wake;
+        std::atomic<bool> sleeping{ false };
+        std::atomic<bool> stopping{ false };
+        std::atomic<bool> exited{ false };
+
+        GLFWwindow* context = nullptr;
+        std::thread thread;
+    };
+
+} // namespace gfx
+
+#endif //DEMO_UPLOAD_THREAD_H
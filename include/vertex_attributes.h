@@ -0,0 +1,35 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_VERTEX_ATTRIBUTES_H
+#define DEMO_VERTEX_ATTRIBUTES_H
+#include <glad/glad.h>
+
+namespace gfx {
+
+// ------------------------------------------------------------------
+// Engine-wide vertex attribute locations. ShaderProgram binds these names
+// before every link (a layout(location) in the shader must agree), so a VAO
+// set up once against the locations works with any program: meshes never
+// ask a program where their attributes are.
+// ------------------------------------------------------------------
+    constexpr GLuint kPositionAttribute = 0;
+    constexpr GLuint kNormalAttribute   = 1;
+    constexpr GLuint kTexCoordAttribute = 2;
+    constexpr GLuint kInstanceAttribute = 3;   // GPU-driven path: index into the instance buffer
+
+    struct AttributeBinding {
+        GLuint location;
+        const char* name;   // the vertex shader input
+    };
+    constexpr AttributeBinding kAttributeBindings[] = {
+        { kPositionAttribute, "aPos" },
+        { kNormalAttribute,   "aNor" },
+        { kTexCoordAttribute, "aTexCoord" },
+        { kInstanceAttribute, "aInstance" },
+    };
+
+} // namespace gfx
+
+#endif //DEMO_VERTEX_ATTRIBUTES_H
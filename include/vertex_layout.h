@@ -0,0 +1,310 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#ifndef DEMO_VERTEX_LAYOUT_H
+#define DEMO_VERTEX_LAYOUT_H
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include <glad/glad.h>
+#include <glm.hpp>
+
+#include "vertex_attributes.h"
+
+namespace gfx {
+
+    // Encoders behind the packed attribute formats
+    inline uint16_t packHalf(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        const uint32_t sign = (bits >> 16) & 0x8000u;
+        const uint32_t magnitude = bits & 0x7FFFFFFFu;
+        if (magnitude >= 0x7F800000u)                   // inf, NaN
+            return static_cast<uint16_t>(sign | 0x7C00u | (magnitude > 0x7F800000u ? 0x200u : 0u));
+        if (magnitude >= 0x477FF000u)                   // rounds past 65504
+            return static_cast<uint16_t>(sign | 0x7C00u);
+        if (magnitude < 0x38800000u) {                  // below the smallest normal half
+            if (magnitude < 0x33000000u)
+                return static_cast<uint16_t>(sign);
+            const uint32_t mantissa = (magnitude & 0x007FFFFFu) | 0x00800000u;
+            const int shift = 126 - static_cast<int>(magnitude >> 23);
+            uint32_t half = mantissa >> shift;
+            const uint32_t rest = mantissa & ((1u << shift) - 1), halfway = 1u << (shift - 1);
+            if (rest > halfway || (rest == halfway && (half & 1u)))
+                ++half;
+            return static_cast<uint16_t>(sign | half);
+        }
+        // Rebias the exponent, round the mantissa to nearest even (a carry bumps the exponent)
+        uint32_t half = (magnitude - 0x38000000u) >> 13;
+        const uint32_t rest = magnitude & 0x1FFFu;
+        if (rest > 0x1000u || (rest == 0x1000u && (half & 1u)))
+            ++half;
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    inline float unpackHalf(uint16_t half)
+    {
+        const uint32_t exponent = (half >> 10) & 0x1Fu, mantissa = half & 0x3FFu;
+        float magnitude;
+        if (exponent == 0)
+            magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+        else if (exponent == 31)
+            magnitude = mantissa ? std::numeric_limits<float>::quiet_NaN() : std::numeric_limits<float>::infinity();
+        else
+            magnitude = std::ldexp(static_cast<float>(mantissa | 0x400u), static_cast<int>(exponent) - 25);
+        return (half & 0x8000u) ? -magnitude : magnitude;
+    }
+
+    inline int16_t packSnorm16(float value)
+    {
+        return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    inline float unpackSnorm16(int16_t value)
+    {
+        return std::max(static_cast<float>(value) / 32767.0f, -1.0f);
+    }
+
+    // Unit vector -> point on the octahedron unfolded onto [-1, 1]^2. Two numbers
+    // instead of three, with error spread evenly over the sphere.
+    inline glm::vec2 octEncode(const glm::vec3& n)
+    {
+        const float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        if (l1 == 0.0f)
+            return glm::vec2(0.0f, 0.0f);
+        float x = n.x / l1, y = n.y / l1;
+        if (n.z < 0.0f) {
+            const float foldedX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            const float foldedY = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = foldedX;
+            y = foldedY;
+        }
+        return glm::vec2(x, y);
+    }
+
+    // Same as octDecode in shaders/vertex_packing.glsl
+    inline glm::vec3 octDecode(const glm::vec2& e)
+    {
+        glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+        if (n.z < 0.0f) {
+            const float x = n.x;
+            n.x = (1.0f - std::abs(n.y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            n.y = (1.0f - std::abs(x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+        }
+        return glm::normalize(n);
+    }
+
+// ------------------------------------------------------------------
+// Vertex attribute formats. Each names its location (vertex_attributes.h),
+// how GL reads it, the bytes it occupies (Stored) and the value loaders
+// write and read (Value), converting between the two.
+// ------------------------------------------------------------------
+    struct Position3f {
+        static constexpr GLuint location = kPositionAttribute;
+        static constexpr GLint components = 3;
+        static constexpr GLenum type = GL_FLOAT;
+        static constexpr GLboolean normalized = GL_FALSE;
+        using Value = glm::vec3;
+        struct Stored { float v[3]; };
+        static Stored pack(const Value& p) { return { { p.x, p.y, p.z } }; }
+        static Value unpack(const Stored& s) { return Value(s.v[0], s.v[1], s.v[2]); }
+    };
+
+    struct Normal3f {
+        static constexpr GLuint location = kNormalAttribute;
+        static constexpr GLint components = 3;
+        static constexpr GLenum type = GL_FLOAT;
+        static constexpr GLboolean normalized = GL_FALSE;
+        using Value = glm::vec3;
+        struct Stored { float v[3]; };
+        static Stored pack(const Value& n) { return { { n.x, n.y, n.z } }; }
+        static Value unpack(const Stored& s) { return Value(s.v[0], s.v[1], s.v[2]); }
+    };
+
+    // Octahedral unit normal in two snorm16s; the shader sees a vec2 and calls octDecode
+    struct NormalOct16 {
+        static constexpr GLuint location = kNormalAttribute;
+        static constexpr GLint components = 2;
+        static constexpr GLenum type = GL_SHORT;
+        static constexpr GLboolean normalized = GL_TRUE;
+        using Value = glm::vec3;
+        struct Stored { int16_t v[2]; };
+        static Stored pack(const Value& n)
+        {
+            const glm::vec2 e = octEncode(n);
+            return { { packSnorm16(e.x), packSnorm16(e.y) } };
+        }
+        static Value unpack(const Stored& s) { return octDecode(glm::vec2(unpackSnorm16(s.v[0]), unpackSnorm16(s.v[1]))); }
+    };
+
+    struct UV2f {
+        static constexpr GLuint location = kTexCoordAttribute;
+        static constexpr GLint components = 2;
+        static constexpr GLenum type = GL_FLOAT;
+        static constexpr GLboolean normalized = GL_FALSE;
+        using Value = glm::vec2;
+        struct Stored { float v[2]; };
+        static Stored pack(const Value& uv) { return { { uv.x, uv.y } }; }
+        static Value unpack(const Stored& s) { return Value(s.v[0], s.v[1]); }
+    };
+
+    // Half floats: exact to 1/2048 across [0, 1], enough for texture coordinates
+    // that don't tile far outside it
+    struct UV2h {
+        static constexpr GLuint location = kTexCoordAttribute;
+        static constexpr GLint components = 2;
+        static constexpr GLenum type = GL_HALF_FLOAT;
+        static constexpr GLboolean normalized = GL_FALSE;
+        using Value = glm::vec2;
+        struct Stored { uint16_t v[2]; };
+        static Stored pack(const Value& uv) { return { { packHalf(uv.x), packHalf(uv.y) } }; }
+        static Value unpack(const Stored& s) { return Value(unpackHalf(s.v[0]), unpackHalf(s.v[1])); }
+    };
+
+    namespace detail {
+        template <class... Attributes>
+        constexpr size_t attributeOffset(size_t index)
+        {
+            constexpr size_t sizes[] = { sizeof(typename Attributes::Stored)..., 0 };
+            size_t offset = 0;
+            for (size_t i = 0; i < index; ++i)
+                offset += sizes[i];
+            return offset;
+        }
+
+        template <class A, class... Attributes>
+        constexpr size_t attributeIndex()
+        {
+            constexpr bool matches[] = { std::is_same_v<A, Attributes>..., false };
+            size_t i = 0;
+            while (i < sizeof...(Attributes) && !matches[i])
+                ++i;
+            return i;
+        }
+
+        template <class... Attributes>
+        constexpr bool attributesAligned()
+        {
+            constexpr size_t alignments[] = { alignof(typename Attributes::Stored)..., 1 };
+            for (size_t i = 0; i < sizeof...(Attributes); ++i) {
+                const size_t offset = attributeOffset<Attributes...>(i);
+                if (offset % 4 != 0 || offset % alignments[i] != 0)
+                    return false;
+            }
+            return true;
+        }
+
+        template <class... Attributes>
+        constexpr bool locationsUnique()
+        {
+            constexpr GLuint locations[] = { Attributes::location..., 0 };
+            for (size_t i = 0; i < sizeof...(Attributes); ++i)
+                for (size_t j = i + 1; j < sizeof...(Attributes); ++j)
+                    if (locations[i] == locations[j])
+                        return false;
+            return true;
+        }
+    }
+
+// ------------------------------------------------------------------
+// Interleaved vertex layout, fixed at compile time: stride and offsets are
+// constexpr, a misaligned or duplicated attribute fails to compile, and
+// setupAttributes() issues the matching glVertexAttribPointer calls, so the
+// bytes loaders write and what GL reads can't drift apart.
+// ------------------------------------------------------------------
+    template <class... Attributes>
+    struct VertexLayout {
+        static constexpr size_t count = sizeof...(Attributes);
+        static constexpr size_t stride = detail::attributeOffset<Attributes...>(count);
+
+        static_assert(count > 0, "a vertex layout needs at least one attribute");
+        static_assert(detail::attributesAligned<Attributes...>(), "every attribute must start on a 4-byte boundary");
+        static_assert(stride % 4 == 0, "the stride must be a multiple of 4 bytes");
+        static_assert(detail::locationsUnique<Attributes...>(), "two attributes share a location");
+
+        template <class A>
+        static constexpr bool contains = detail::attributeIndex<A, Attributes...>() < count;
+
+        template <class A>
+        static constexpr size_t offset()
+        {
+            static_assert(contains<A>, "attribute is not part of this layout");
+            return detail::attributeOffset<Attributes...>(detail::attributeIndex<A, Attributes...>());
+        }
+
+        // Points the bound VAO's attributes into the bound GL_ARRAY_BUFFER, from `baseOffset`
+        static void setupAttributes(size_t baseOffset = 0)
+        {
+            (setupAttribute_<Attributes>(baseOffset), ...);
+        }
+
+    private:
+        template <class A>
+        static void setupAttribute_(size_t baseOffset)
+        {
+            glVertexAttribPointer(A::location, A::components, A::type, A::normalized, static_cast<GLsizei>(stride),
+                                  reinterpret_cast<const void*>(baseOffset + offset<A>()));
+            glEnableVertexAttribArray(A::location);
+        }
+    };
+
+    // Typed access to `count` vertices of `Layout` at `data`. Byte is const for
+    // read-only views. Values go through memcpy: the bytes have no C++ type.
+    template <class Layout, class Byte = unsigned char>
+    class VertexSpan {
+    public:
+        VertexSpan(Byte* data, size_t count) : bytes(data), vertices(count) {}
+
+        size_t size() const { return vertices; }
+
+        template <class A>
+        void set(size_t vertex, const typename A::Value& value) const
+        {
+            static_assert(!std::is_const_v<Byte>, "read-only vertex span");
+            const typename A::Stored stored = A::pack(value);
+            std::memcpy(bytes + vertex * Layout::stride + Layout::template offset<A>(), &stored, sizeof(stored));
+        }
+
+        template <class A>
+        typename A::Value get(size_t vertex) const
+        {
+            typename A::Stored stored;
+            std::memcpy(&stored, bytes + vertex * Layout::stride + Layout::template offset<A>(), sizeof(stored));
+            return A::unpack(stored);
+        }
+
+    private:
+        Byte* bytes;
+        size_t vertices;
+    };
+
+    // Interleaved vertices in one allocation: resize() to the final count first,
+    // then fill it through span()
+    template <class Layout>
+    class VertexData {
+    public:
+        void resize(size_t count) { bytes.resize(count * Layout::stride); }
+        void append(const VertexData& other) { bytes.insert(bytes.end(), other.bytes.begin(), other.bytes.end()); }
+
+        size_t size() const { return bytes.size() / Layout::stride; }
+        bool empty() const { return bytes.empty(); }
+        size_t byteSize() const { return bytes.size(); }
+        const unsigned char* data() const { return bytes.data(); }
+
+        VertexSpan<Layout> span() { return { bytes.data(), size() }; }
+        VertexSpan<Layout, const unsigned char> span() const { return { bytes.data(), size() }; }
+
+    private:
+        std::vector<unsigned char> bytes;
+    };
+
+} // namespace gfx
+
+#endif //DEMO_VERTEX_LAYOUT_H
@@ -1,5 +1,8 @@
+#include <algorithm>
 #include <iostream>
 #include <random>
+#include <memory>
+#include <optional>
 #include "glad/glad.h"
 #include "GLFW/glfw3.h"
 #include "shaderprogram.h"
@@ -7,6 +10,24 @@
 #include "mesh.h"
 #include "camera.h"
 #include "light_config.h"
+#include "light_buffer.h"
+#include "gl_ext.h"
+#include "gpu_driven.h"
+#include "light_assignment.h"
+#include "scene_query.h"
+#include "scene_graph.h"
+#include "static_batch.h"
+#include "texture_manager.h"
+#include "material_library.h"
+#include "texture_residency.h"
+#include "spherical_harmonics.h"
+#include "env_prefilter.h"
+#include "ktx.h"
+#include "startup_graph.h"
+#include "asset_vfs.h"
+#include "hot_reload.h"
+#include "mesh_cache.h"
+#include "upload_thread.h"
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xposIn, double yposIn);
@@ -14,6 +35,14 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// The static batching sample (a floor of crates) is built with the STATIC_FLOOR
+// CMake option; the default scene is just the containers, lights and sky
+#ifdef GFX_STATIC_FLOOR
+constexpr bool kStaticFloor = true;
+#else
+constexpr bool kStaticFloor = false;
+#endif
+
 int SCR_WIDTH = 720;
 int SCR_HEIGHT = 720;
 Camera camera(glm::vec3(0.0f, 2.0f, 8.0f), glm::vec3(0.0f, 1.0f, 0.0f));  // Better starting position
@@ -24,14 +53,22 @@ int main() {
         return -1;
     }
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+    const char* title = "Lighting Scene - Hailemariam";
+    GLFWwindow *window = nullptr;
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#else
+    // Try for 4.3 so the GPU-driven path is available; 4.1 remains the baseline.
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, title, nullptr, nullptr);
 #endif
-
-    GLFWwindow *window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Lighting Scene - Hailemariam", nullptr, nullptr);
+    if (!window) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+        window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, title, nullptr, nullptr);
+    }
     if (!window) {
         std::cerr << "Failed to create GLFW window\n";
         glfwTerminate();
@@ -47,6 +84,22 @@ int main() {
         std::cerr << "Failed to initialize GLAD\n";
         return -1;
     }
+    gfx::loadGLExtensions((GLADloadproc)glfwGetProcAddress);
+    // Warm starts load linked programs instead of compiling GLSL
+    ShaderProgram::enableBinaryCache(std::string(CACHE_DIR) + "programs/");
+
+    // GPU-driven culling + multi-draw indirect on 4.3+, per-object draws otherwise
+    const bool gpuDriven = gfx::GpuDrivenRenderer::isSupported();
+    std::cout << "OpenGL " << GLVersion.major << "." << GLVersion.minor
+              << (gpuDriven ? ": GPU-driven path\n" : ": per-draw path\n");
+
+    // Cube maps carry full mip chains; filter across face edges at the small levels
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+    // Startup assets come out of one mapped pack (built next to the binary) when it
+    // exists; anything it lacks, or everything without it, loads from the loose files
+    if (gfx::mountAssetPack(ASSET_PACK, ASSETS_DIR))
+        gfx::mountAssetPack(ASSET_PACK, BAKED_DIR, "baked/");
 
     // Skybox faces
     std::vector<std::string> faces{
@@ -58,31 +111,205 @@ int main() {
         std::string(ASSETS_DIR) + "skybox/back.jpg"
     };
 
-    // Container shader
-    std::string vertPath = std::string(SHADER_DIR) + "cube_vertex.vert";
-    std::string fragPath = std::string(SHADER_DIR) + "container_fragment.frag";
-    ShaderProgram containerShaderProgram(vertPath, fragPath);
-    GLuint cube_diffuse = containerShaderProgram.bindTexture2D("material.diffuse", std::string(ASSETS_DIR) + "container2.png", 0, false);
-    GLuint cube_specular = containerShaderProgram.bindTexture2D("material.specular", std::string(ASSETS_DIR) + "container2_specular.png", 1, false);
-    containerShaderProgram.bindCubeMap("skybox", faces, 2);
-    containerShaderProgram.setUniform("material.shininess", 32.0f);
-    containerShaderProgram.setUniform("material.alpha", 1.0f);
-
-    // Light-cube shader (for visualizing point lights)
-    vertPath = std::string(SHADER_DIR) + "cube_vertex.vert";
-    fragPath = std::string(SHADER_DIR) + "light_fragment.frag";
-    ShaderProgram lightShaderProgram(vertPath, fragPath);
-
-    // Skybox shader
-    vertPath = std::string(SHADER_DIR) + "skybox_vertex.vert";
-    fragPath = std::string(SHADER_DIR) + "skybox_fragment.frag";
-    ShaderProgram skyboxShaderProgram(vertPath, fragPath);
-    skyboxShaderProgram.bindCubeMap("skybox", faces, 0);
-
-    // Load meshes
-    Mesh container(std::string(ASSETS_DIR) + "box.obj", containerShaderProgram.getID());
-    Mesh lightMesh(std::string(ASSETS_DIR) + "box.obj", lightShaderProgram.getID());
-    Mesh skybox(std::string(ASSETS_DIR) + "skybox.obj", skyboxShaderProgram.getID());
+    // Pre-baked KTX files (tools/ktx_convert, run by the build) load without decoding;
+    // the source images remain the fallback
+    const bool baked = gfx::assetExists(std::string(BAKED_DIR) + "skybox.ktx") && gfx::supportsBlockCompression();
+    const std::string diffusePath = baked ? std::string(BAKED_DIR) + "container2.ktx" : std::string(ASSETS_DIR) + "container2.png";
+    const std::string specularPath = baked ? std::string(BAKED_DIR) + "container2_specular.ktx" : std::string(ASSETS_DIR) + "container2_specular.png";
+    const std::vector<std::string> skyboxSource = baked ? std::vector<std::string>{ std::string(BAKED_DIR) + "skybox.ktx" } : faces;
+
+    // Textures stream in over the first frames instead of stalling startup
+    gfx::TextureStreamer textureStreamer;
+    gfx::TextureManager textures;
+    textures.enableCompression(std::string(CACHE_DIR) + "textures/");
+    textures.setStreamer(&textureStreamer);
+    // Whole textures and reloaded meshes are uploaded by a loader thread on a shared
+    // context; the render thread only swaps them in once their fences signal
+    gfx::UploadThread uploadThread;
+    if (uploadThread.start(window))
+        textureStreamer.setUploadThread(&uploadThread);
+
+    // Material maps live in texture arrays; objects pick a layer, not a texture.
+    // Only the mips visible objects need stay resident, within a VRAM budget.
+    gfx::TextureResidency residency(256u << 20, textureStreamer);
+    gfx::MaterialLibrary materials;
+    materials.enableCompression(std::string(CACHE_DIR) + "textures/");
+    materials.enableResidency(&residency);
+    int crateMaterial = materials.add(diffusePath, specularPath, 32.0f);
+
+    // Everything startup loads, as a task graph: reads, decodes and parsing run on the
+    // pool, uploads and links run here as soon as their inputs are in. Results land in
+    // the storage below, which the rest of main uses once the graph has run.
+    gfx::StartupGraph startup;
+    std::optional<ShaderProgram> cubeVertexStage;
+    std::optional<ShaderProgram> containerProgramStorage, lightProgramStorage, skyboxProgramStorage;
+    std::optional<ShaderProgram> staticProgramStorage;
+    // One parse and one upload per mesh file, drawn by any program: the light cubes
+    // share the containers' box
+    gfx::MeshCache meshes;
+    const std::string boxPath = std::string(ASSETS_DIR) + "box.obj";
+    const std::string skyboxPath = std::string(ASSETS_DIR) + "skybox.obj";
+    Mesh* containerMesh = nullptr;
+    Mesh* lightMeshStorage = nullptr;
+    Mesh* skyboxMesh = nullptr;
+    gfx::SH9 ambientSH;
+    std::string environmentPath;
+    GLuint skyboxCube = 0, environmentTexture = 0;
+    const gfx::PrefilterSettings environmentSettings;
+    // Levels the bake actually holds: prefilterCubeMap caps them at log2(size) + 1
+    int environmentLevels = environmentSettings.levels;
+    gfx::StaticBatcher staticBatcher(4.0f);
+    int floorMaterial = -1;
+
+    // Every program starts compiling first and the driver finishes them while the rest
+    // loads; the first setUniform/use on each one waits for whatever is left.
+    // Static level geometry always goes through the per-draw vertex shader; on the
+    // GPU-driven path that needs its own program sharing the container's texture units.
+    // Where separate shader objects are supported, cube_vertex.vert is compiled once and
+    // every program drawing with it is a pipeline over that one vertex stage.
+    auto compilePrograms = startup.gl("compile programs", [&] {
+        const ShaderProgram::Deferred deferred;
+        const std::string cubeVertPath = std::string(SHADER_DIR) + "cube_vertex.vert";
+        if (ShaderProgram::supportsPipelines())
+            cubeVertexStage.emplace(GL_VERTEX_SHADER, cubeVertPath, ShaderProgram::Separable{});
+        auto cubeProgram = [&](std::optional<ShaderProgram>& program, const std::string& fragPath) {
+            if (cubeVertexStage)
+                program.emplace(*cubeVertexStage, fragPath, deferred);
+            else
+                program.emplace(cubeVertPath, fragPath, deferred);
+        };
+        const std::string fragPath = std::string(SHADER_DIR) + "container_fragment.frag";
+        if (gpuDriven) {
+            containerProgramStorage.emplace(std::string(SHADER_DIR) + "cube_vertex_indirect.vert", fragPath, deferred);
+            if (kStaticFloor)
+                cubeProgram(staticProgramStorage, fragPath);
+        } else {
+            cubeProgram(containerProgramStorage, fragPath);
+        }
+        // Light cubes (for visualizing point lights) and the skybox
+        cubeProgram(lightProgramStorage, std::string(SHADER_DIR) + "light_fragment.frag");
+        skyboxProgramStorage.emplace(std::string(SHADER_DIR) + "skybox_vertex.vert",
+                                     std::string(SHADER_DIR) + "skybox_fragment.frag", deferred);
+    });
+    auto parseBox = startup.cpu("parse box.obj", [&] { meshes.load(boxPath); });
+    auto parseSkybox = startup.cpu("parse skybox.obj", [&] { meshes.load(skyboxPath); });
+    auto loadMaterials = startup.cpu("load material maps", [&] { materials.load(); });
+    // Diffuse ambient comes from the sky projected onto SH
+    auto projectSky = startup.cpu("sky SH projection", [&] {
+        ambientSH = gfx::irradianceCoefficients(gfx::projectCubeMap(gfx::loadImages(faces, false)));
+    });
+    // Glossy reflections read a GGX-prefiltered copy of the sky, baked once into the cache
+    auto bakeEnvironment = startup.cpu("environment prefilter", [&] {
+        environmentPath = gfx::prefilterEnvironment(faces, std::string(CACHE_DIR) + "environment/", environmentSettings);
+        gfx::KtxTexture baked;
+        if (!environmentPath.empty() && baked.load(environmentPath))
+            environmentLevels = baked.levels();
+    });
+
+    startup.gl("upload materials", [&] {
+        materials.build();
+        materials.printStats(std::cout);
+        materials.bindPage(materials.slot(crateMaterial).page, 0, 1);
+    }, { loadMaterials });
+    // The sky itself at full resolution (it is also the reflection fallback when no bake exists)
+    auto uploadSkybox = startup.gl("skybox texture", [&] {
+        skyboxCube = textures.acquireCube(skyboxSource);
+        textures.bind(skyboxCube, 3);
+    });
+    auto linkPrograms = startup.gl("link programs", [&] {
+        for (ShaderProgram* program : { &*containerProgramStorage, staticProgramStorage ? &*staticProgramStorage : nullptr }) {
+            if (!program)
+                continue;
+            program->use();
+            program->setUniform("material.diffuse", 0);
+            program->setUniform("material.specular", 1);
+            program->setUniform("environment", 2);
+            program->setUniform("material.alpha", 1.0f);
+        }
+        skyboxProgramStorage->use();
+        skyboxProgramStorage->setUniform("skybox", 3);
+        lightProgramStorage->finish();
+    }, { compilePrograms });
+
+    // Attribute locations are engine-wide: meshes upload without waiting for programs
+    auto uploadBox = startup.gl("box meshes", [&] {
+        containerMesh = meshes.acquire(boxPath);
+        lightMeshStorage = meshes.acquire(boxPath);
+    }, { parseBox });
+    startup.gl("skybox mesh", [&] {
+        skyboxMesh = meshes.acquire(skyboxPath);
+    }, { parseSkybox });
+
+    // Static floor of crates: pre-transformed and merged into chunked batches
+    if (kStaticFloor) {
+        startup.gl("static floor", [&] {
+            floorMaterial = staticBatcher.addMaterial();
+            for (int x = 0; x < 16; x++)
+                for (int z = 0; z < 16; z++)
+                    staticBatcher.add(*containerMesh, glm::translate(glm::mat4(1.0f), glm::vec3(x - 7.5f, -3.5f, z - 11.5f)), floorMaterial);
+            staticBatcher.build();
+            staticBatcher.printStats(std::cout);
+        }, { uploadBox });
+    }
+
+    startup.gl("ambient SH", [&] {
+        gfx::applyAmbientSH(*containerProgramStorage, ambientSH, 0.3f);
+        if (staticProgramStorage)
+            gfx::applyAmbientSH(*staticProgramStorage, ambientSH, 0.3f);
+    }, { projectSky, linkPrograms });
+    // Without a bake the plain sky mips stand in for the roughness levels
+    startup.gl("environment texture", [&] {
+        environmentTexture = textures.acquireCube(environmentPath.empty() ? skyboxSource
+                                                                                 : std::vector<std::string>{ environmentPath });
+        textures.bind(environmentTexture, 2);
+    }, { bakeEnvironment, uploadSkybox });
+
+    if (!startup.run()) {
+        std::cerr << "Startup failed\n";
+        uploadThread.stop();
+        materials.cleanup();
+        textures.clear();
+        meshes.clear();
+        textureStreamer.cleanup();
+        glfwTerminate();
+        return -1;
+    }
+    startup.printTimings(std::cout);
+    meshes.printStats(std::cout);
+
+    // Edited shaders, meshes and textures are rebuilt in the background and swapped
+    // in between frames. The static floor and the GPU-driven renderer keep the
+    // geometry they copied at startup.
+    gfx::HotReload hotReload;
+    if (hotReload.start({ SHADER_DIR, ASSETS_DIR, BAKED_DIR })) {
+        if (cubeVertexStage)
+            gfx::watchProgram(hotReload, *cubeVertexStage, "cube vertex stage");
+        gfx::watchProgram(hotReload, *containerProgramStorage, "container program");
+        if (staticProgramStorage)
+            gfx::watchProgram(hotReload, *staticProgramStorage, "static program");
+        gfx::watchProgram(hotReload, *lightProgramStorage, "light program");
+        gfx::watchProgram(hotReload, *skyboxProgramStorage, "skybox program");
+        gfx::watchMesh(hotReload, *containerMesh, boxPath, &uploadThread);
+        gfx::watchMesh(hotReload, *skyboxMesh, skyboxPath, &uploadThread);
+        gfx::watchTexture(hotReload, textures, skyboxCube, "skybox texture");
+        if (environmentTexture != skyboxCube)
+            gfx::watchTexture(hotReload, textures, environmentTexture, "environment texture");
+        gfx::watchMaterials(hotReload, materials, [&] {
+            materials.bindPage(materials.slot(crateMaterial).page, 0, 1);
+        });
+    }
+
+    ShaderProgram& containerShaderProgram = *containerProgramStorage;
+    ShaderProgram& lightShaderProgram = *lightProgramStorage;
+    ShaderProgram& skyboxShaderProgram = *skyboxProgramStorage;
+    ShaderProgram& staticShaderProgram = staticProgramStorage ? *staticProgramStorage : containerShaderProgram;
+    std::vector<ShaderProgram*> litPrograms{ &containerShaderProgram };
+    if (staticProgramStorage) litPrograms.push_back(&staticShaderProgram);
+    Mesh& container = *containerMesh;
+    Mesh& lightMesh = *lightMeshStorage;
+    Mesh& skybox = *skyboxMesh;
+    const glm::vec2 crateParams = materials.slot(crateMaterial).params();
+    bool texturesStreaming = true;
 
     // Cube positions
     glm::vec3 cubePositions[] = {
@@ -98,13 +325,39 @@ int main() {
         glm::vec3(-2.5f,  0.0f, -3.5f)
     };
 
+    // Scene graph: the single source of object transforms
+    gfx::SceneGraph sceneGraph;
+    gfx::NodeHandle containerRoot = sceneGraph.createNode();
+    std::vector<gfx::NodeHandle> containerNodes;
+    for (int i = 0; i < 10; i++)
+        containerNodes.push_back(sceneGraph.createNode(containerRoot, cubePositions[i]));
+    const glm::vec3 spinAxis = glm::normalize(glm::vec3(1.0f, 0.3f, 0.5f));
+    sceneGraph.update();
+
+    std::unique_ptr<gfx::GpuDrivenRenderer> gpuRenderer;
+    if (gpuDriven) {
+        gpuRenderer = std::make_unique<gfx::GpuDrivenRenderer>();
+        int boxMesh = gpuRenderer->addMesh(container);
+        for (int i = 0; i < 10; i++) {
+            int instance = gpuRenderer->addInstance(boxMesh, sceneGraph.world(containerNodes[i]));
+            gpuRenderer->setInstanceMaterial(instance, crateParams);
+        }
+    }
+
+    // Ray queries (picking) against the containers
+    gfx::SceneQuery sceneQuery;
+    int boxQueryMesh = sceneQuery.addMesh(container);
+    for (int i = 0; i < 10; i++)
+        sceneQuery.addObject(boxQueryMesh, sceneGraph.world(containerNodes[i]));
+    sceneQuery.commit();
+    bool pickHeld = false;
+
     gfx::SceneConfig cfg = gfx::makeDefaultSceneConfig();
 
     // Directional light
     cfg.dirLights.clear();
     cfg.dirLights.resize(1);
     cfg.dirLights[0].direction = glm::vec3(-0.2f, -1.0f, -0.3f);
-    cfg.dirLights[0].ambient = glm::vec3(0.08f, 0.08f, 0.08f);
     cfg.dirLights[0].diffuse = glm::vec3(0.3f, 0.3f, 0.3f);
     cfg.dirLights[0].specular = glm::vec3(0.4f, 0.4f, 0.4f);
 
@@ -114,7 +367,6 @@ int main() {
     // Purple
     cfg.pointLights[0].position = glm::vec3(4.0f, 3.0f, -2.0f);
     cfg.pointLights[0].diffuse  = glm::vec3(0.6f, 0.2f, 0.8f);
-    cfg.pointLights[0].ambient  = cfg.pointLights[0].diffuse * 0.1f;
     cfg.pointLights[0].specular = cfg.pointLights[0].diffuse;
     cfg.pointLights[0].constant = 1.0f;
     cfg.pointLights[0].linear   = 0.07f;
@@ -123,7 +375,6 @@ int main() {
    // pink
     cfg.pointLights[1].position = glm::vec3(-4.0f, 3.0f, -5.0f);
     cfg.pointLights[1].diffuse  = glm::vec3(1.0f, 0.4f, 0.7f);
-    cfg.pointLights[1].ambient  = cfg.pointLights[1].diffuse * 0.1f;
     cfg.pointLights[1].specular = cfg.pointLights[1].diffuse;
     cfg.pointLights[1].constant = 1.0f;
     cfg.pointLights[1].linear   = 0.07f;
@@ -132,7 +383,6 @@ int main() {
     // Orange
     cfg.pointLights[2].position = glm::vec3(0.0f, 4.0f, -8.0f);
     cfg.pointLights[2].diffuse  = glm::vec3(1.0f, 0.55f, 0.1f);  // Orange
-    cfg.pointLights[2].ambient  = cfg.pointLights[2].diffuse * 0.1f;
     cfg.pointLights[2].specular = cfg.pointLights[2].diffuse;
     cfg.pointLights[2].constant = 1.0f;
     cfg.pointLights[2].linear   = 0.07f;
@@ -141,7 +391,6 @@ int main() {
     // Spotlight (flashlight)
     cfg.spotLights.clear();
     cfg.spotLights.resize(1);
-    cfg.spotLights[0].ambient  = glm::vec3(0.0f);
     cfg.spotLights[0].diffuse  = glm::vec3(2.0f, 2.0f, 2.0f);
     cfg.spotLights[0].specular = glm::vec3(2.5f, 2.5f, 2.5f);
     cfg.spotLights[0].constant = 1.0f;
@@ -150,10 +399,32 @@ int main() {
     cfg.spotLights[0].cutOff   = glm::cos(glm::radians(12.5f));
     cfg.spotLights[0].outerCutOff = glm::cos(glm::radians(17.5f));
 
-    // Upload static lights to shader (we will update the spotlight each frame)
-    gfx::applyDirLights(containerShaderProgram, cfg.dirLights);
-    gfx::applyPointLights(containerShaderProgram, cfg.pointLights);
-    gfx::applySpotLights(containerShaderProgram, cfg.spotLights);
+    // Point and spot lights go into shared uniform buffers (the spotlight is
+    // updated every frame); directional lights are per-program uniforms
+    gfx::LightBuffer lightBuffer;
+    lightBuffer.setPointLights(cfg.pointLights);
+    lightBuffer.setSpotLights(cfg.spotLights);
+    for (ShaderProgram* program : litPrograms) {
+        gfx::applyDirLights(*program, cfg.dirLights);
+        gfx::LightBuffer::attach(*program);
+    }
+    for (ShaderProgram* program : litPrograms) {
+        program->use();
+        program->setUniform("environmentMaxLod", static_cast<float>(std::max(0, environmentLevels - 1)));
+    }
+
+    // Per-object light lists from attenuation-derived ranges
+    gfx::LightAssigner lightAssigner;
+
+    // Light cubes live in the graph too
+    std::vector<gfx::NodeHandle> lightNodes;
+    for (const auto& L : cfg.pointLights)
+        lightNodes.push_back(sceneGraph.createNode(gfx::kInvalidNode, L.position));
+
+    // Graph node -> container index, for routing changed transforms
+    std::vector<int> containerIndex(sceneGraph.size(), -1);
+    for (int i = 0; i < 10; i++)
+        containerIndex[containerNodes[i]] = i;
 
     // Main loop
     while (!glfwWindowShouldClose(window)) {
@@ -162,6 +433,16 @@ int main() {
         lastFrame = currentFrame;
         camera.ProcessKeyboard(window, deltaTime);
 
+        hotReload.update();
+        uploadThread.update();
+        textureStreamer.update();
+        if (texturesStreaming && !textureStreamer.busy()) {
+            texturesStreaming = false;
+            textures.printStats(std::cout);
+            std::cout << "Texture streaming: peak " << textureStreamer.stats().peakFrameBytes / 1024
+                      << " KB per frame\n";
+        }
+
         // Clear
         glClearColor(0.05f, 0.05f, 0.08f, 1.0f);
         glEnable(GL_DEPTH_TEST);
@@ -170,8 +451,8 @@ int main() {
         // Update spotlight to follow camera
         cfg.spotLights[0].position = camera.Position;
         cfg.spotLights[0].direction = camera.Front;
-        // Re-apply the spotlight uniforms every frame
-        gfx::applySpotLights(containerShaderProgram, cfg.spotLights);
+        lightBuffer.setSpotLights(cfg.spotLights);
+        lightAssigner.setLights(cfg);
 
         // Matrices and view setup
         containerShaderProgram.use();
@@ -181,16 +462,64 @@ int main() {
         containerShaderProgram.setUniform("projection", projection);
         containerShaderProgram.setUniform("viewPos", camera.Position);
 
-        // Draw containers (with small rotation animation)
+        // Animate (small rotation on the containers, pulsing light cubes)
         for (int i = 0; i < 10; i++) {
-            containerShaderProgram.setUniform("material.alpha", 1.0f);
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, cubePositions[i]);
             float angle = 20.0f * i + currentFrame * 15.0f;
-            model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
+            sceneGraph.setRotation(containerNodes[i], glm::angleAxis(glm::radians(angle), spinAxis));
+        }
+        float pulseScale = 0.3f + 0.1f * sin(currentFrame * 2.0f);
+        for (gfx::NodeHandle node : lightNodes)
+            sceneGraph.setScale(node, glm::vec3(pulseScale));
+
+        // Push only the transforms that changed to instancing and picking
+        sceneGraph.update();
+        for (gfx::NodeHandle node : sceneGraph.changed()) {
+            int i = containerIndex[node];
+            if (i < 0) continue;
+            const glm::mat4& model = sceneGraph.world(node);
+            sceneQuery.setObjectTransform(i, model);
+            if (gpuRenderer) gpuRenderer->setInstanceTransform(i, model);
+        }
+        sceneQuery.commit();
+
+        // Draw containers
+        for (int i = 0; i < 10; i++) {
+            const glm::mat4& model = sceneGraph.world(containerNodes[i]);
+            glm::uvec3 lights = lightAssigner.assign(gfx::transformAABB(container.getBounds(), model)).packed();
+            materials.request(crateMaterial, gfx::projectedSize(gfx::transformSphere(container.getBounds(), model),
+                                                                camera.Position, projection, (float)SCR_HEIGHT));
+            if (gpuRenderer) {
+                gpuRenderer->setInstanceLights(i, lights);
+                continue;
+            }
+            containerShaderProgram.setUniform("material.alpha", 1.0f);
             containerShaderProgram.setUniform("model", model);
+            containerShaderProgram.setUniform("objectLights", lights);
+            containerShaderProgram.setUniform("materialParams", crateParams);
             container.draw();
         }
+        if (gpuRenderer) {
+            gpuRenderer->cull(view, projection);
+            containerShaderProgram.use();
+            gpuRenderer->draw();
+        }
+
+        // Static floor: frustum-culled chunks, lights assigned per chunk
+        if (kStaticFloor) {
+            staticShaderProgram.use();
+            staticShaderProgram.setUniform("view", view);
+            staticShaderProgram.setUniform("projection", projection);
+            staticShaderProgram.setUniform("viewPos", camera.Position);
+            staticShaderProgram.setUniform("model", glm::mat4(1.0f));
+            staticShaderProgram.setUniform("materialParams", crateParams);
+            staticBatcher.draw(floorMaterial, gfx::Frustum::fromMatrix(projection * view), [&](const gfx::AABB& chunk) {
+                staticShaderProgram.setUniform("objectLights", lightAssigner.assign(chunk).packed());
+                // The texture spans one crate: size it for the crate nearest the camera
+                gfx::BoundingSphere nearest = gfx::transformSphere(container.getBounds(), glm::mat4(1.0f));
+                nearest.center = glm::clamp(camera.Position, chunk.min, chunk.max);
+                materials.request(crateMaterial, gfx::projectedSize(nearest, camera.Position, projection, (float)SCR_HEIGHT));
+            });
+        }
 
         // Skybox
         glDepthFunc(GL_LEQUAL);
@@ -205,25 +534,46 @@ int main() {
         lightShaderProgram.setUniform("view", view);
         lightShaderProgram.setUniform("projection", projection);
 
-        float pulseScale = 0.3f + 0.1f * sin(currentFrame * 2.0f);
-
         for (int i = 0; i < (int)cfg.pointLights.size(); ++i) {
-            glm::vec3 pos = cfg.pointLights[i].position;
             glm::vec3 lightColor = cfg.pointLights[i].diffuse;
 
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, pos);
-            model = glm::scale(model, glm::vec3(pulseScale));
-
-            lightShaderProgram.setUniform("model", model);
+            lightShaderProgram.setUniform("model", sceneGraph.world(lightNodes[i]));
             lightShaderProgram.setUniform("lightColor", lightColor);
             lightMesh.draw();
         }
 
+        // Left click picks whatever is under the crosshair (cursor is captured)
+        bool pickDown = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+        if (pickDown && !pickHeld) {
+            gfx::RayHit hit;
+            gfx::Ray ray = gfx::screenRay(camera, SCR_WIDTH * 0.5, SCR_HEIGHT * 0.5, SCR_WIDTH, SCR_HEIGHT);
+            if (sceneQuery.raycast(ray, hit))
+                std::cout << "Picked container " << hit.object << " at distance " << hit.distance << "\n";
+        }
+        pickHeld = pickDown;
+
+        // Every draw has asked for its mip levels by now
+        residency.update();
+
+        // Depth is final: build next frame's occlusion pyramid from it
+        if (gpuRenderer) {
+            int fbWidth = 0, fbHeight = 0;
+            glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+            gpuRenderer->updateOcclusion(fbWidth, fbHeight);
+        }
+
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
+    uploadThread.stop();
+    gpuRenderer.reset();
+    staticBatcher.cleanup();
+    lightBuffer.cleanup();
+    materials.cleanup();
+    textures.clear();
+    meshes.clear();
+    textureStreamer.cleanup();
     glfwTerminate();
     return 0;
 }
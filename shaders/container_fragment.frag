@@ -5,78 +5,48 @@ out vec4 FragColor;
 in vec3 Normal;
 in vec3 FragPos;
 in vec2 TexCoords;
+// gfx::MaterialLibrary::Slot::params(): array layer in .x, shininess in .y
+flat in vec2 MaterialParams;
+// Lights assigned to this object (gfx::ObjectLights::packed): 8-bit indices
+// into pointLights/spotLights in .x/.y, counts in .z
+flat in uvec3 LightSlots;
 
 // ---------------------------------------------------------------------
 // Structs
 // ---------------------------------------------------------------------
+// Diffuse/specular arrays of the bound material page, indexed by MaterialParams.x
 struct Material {
-    sampler2D diffuse;
-    sampler2D specular;
-    float shininess;
+    sampler2DArray diffuse;
+    sampler2DArray specular;
     float alpha;
 };
 
 uniform Material material;
 
-struct DirLight {
-    vec3 direction;
+#include "lighting.glsl"
 
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
-
-struct PointLight {
-    vec3 position;
+uniform int numDirLights;
+// GGX-prefiltered sky (gfx::prefilterEnvironment): roughness r lives at lod r * environmentMaxLod
+uniform samplerCube environment;
+uniform float environmentMaxLod;
 
-    float constant;
-    float linear;
-    float quadratic;
+uniform DirLight dirLights[MAX_DIR_LIGHTS];
 
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
+// Every light of the scene (gfx::LightBuffer); objects only visit their own
+layout(std140) uniform PointLights {
+    int numPointLights;
+    PointLight pointLights[MAX_POINT_LIGHTS];
 };
-
-struct SpotLight {
-    vec3 position;
-    vec3 direction;
-    float cutOff;
-    float outerCutOff;
-
-    float constant;
-    float linear;
-    float quadratic;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
+layout(std140) uniform SpotLights {
+    int numSpotLights;
+    SpotLight spotLights[MAX_SPOT_LIGHTS];
 };
 
-// ---------------------------------------------------------------------
-// MAX LIGHTS
-// ---------------------------------------------------------------------
-#define MAX_DIR_LIGHTS   4
-#define MAX_POINT_LIGHTS 8
-#define MAX_SPOT_LIGHTS  4
-
-uniform int numDirLights;
-uniform int numPointLights;
-uniform int numSpotLights;
-uniform samplerCube skybox;
-
-uniform DirLight   dirLights[MAX_DIR_LIGHTS];
-uniform PointLight pointLights[MAX_POINT_LIGHTS];
-uniform SpotLight  spotLights[MAX_SPOT_LIGHTS];
-
 uniform vec3 viewPos;
 
-// ---------------------------------------------------------------------
-// Function declarations
-// ---------------------------------------------------------------------
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+// Diffuse ambient from the skybox: L2 spherical-harmonic irradiance
+// (gfx::irradianceCoefficients), already scaled by the ambient intensity
+uniform vec3 ambientSH[9];
 
 // ---------------------------------------------------------------------
 // MAIN
@@ -86,112 +56,47 @@ void main()
     vec3 norm    = normalize(Normal);
     vec3 viewDir = normalize(viewPos - FragPos);
 
-    vec3 result = vec3(0.0);
+    Surface surface;
+    surface.normal    = norm;
+    surface.position  = FragPos;
+    surface.viewDir   = viewDir;
+    surface.diffuse   = texture(material.diffuse, vec3(TexCoords, MaterialParams.x)).rgb;
+    surface.specular  = texture(material.specular, vec3(TexCoords, MaterialParams.x)).rgb;
+    surface.shininess = MaterialParams.y;
+
+    vec3 result = CalcAmbient(ambientSH, norm) * surface.diffuse;
 
     // Directional
     for (int i = 0; i < numDirLights; ++i)
-        result += CalcDirLight(dirLights[i], norm, viewDir);
-
-    // Point lights
-    for (int i = 0; i < numPointLights; ++i)
-        result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);
-
-    // Spot lights
-    for (int i = 0; i < numSpotLights; ++i)
-        result += CalcSpotLight(spotLights[i], norm, FragPos, viewDir);
+        result += CalcDirLight(dirLights[i], surface);
+
+    // Point lights (only those whose range reaches this object)
+    int numPoint = int(LightSlots.z & 0xFFu);
+    for (int i = 0; i < numPoint; ++i) {
+        int idx = int((LightSlots.x >> (8 * i)) & 0xFFu);
+        if (idx < numPointLights)
+            result += CalcPointLight(pointLights[idx], surface);
+    }
+
+    // Spot lights (only those whose cone reaches this object)
+    int numSpot = int((LightSlots.z >> 8) & 0xFFu);
+    for (int i = 0; i < numSpot; ++i) {
+        int idx = int((LightSlots.y >> (8 * i)) & 0xFFu);
+        if (idx < numSpotLights)
+            result += CalcSpotLight(spotLights[idx], surface);
+    }
 
     // ---------------------------------------------------------------------
     // FIXED: Reduce skybox reflection (no longer overrides your light colors)
     // ---------------------------------------------------------------------
-    float maskValue = texture(material.specular, TexCoords).r;
+    float maskValue = surface.specular.r;
     float reflectionStrength = 0.2;    // <-- adjust if you want stronger reflection
     vec3 R = reflect(-viewDir, norm);
-    vec3 envColor = texture(skybox, R).rgb;
+    // Phong exponent -> GGX roughness (alpha = sqrt(2 / (n + 2)), roughness = sqrt(alpha))
+    float roughness = pow(2.0 / (MaterialParams.y + 2.0), 0.25);
+    vec3 envColor = textureLod(environment, R, roughness * environmentMaxLod).rgb;
 
     vec3 finalColor = mix(result, envColor, maskValue * reflectionStrength);
 
     FragColor = vec4(finalColor, material.alpha);
 }
-
-// ---------------------------------------------------------------------
-// LIGHT CALCULATIONS
-// ---------------------------------------------------------------------
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
-{
-    vec3 lightDir = normalize(-light.direction);
-
-    float diff = max(dot(normal, lightDir), 0.0);
-
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-
-    vec3 texDiffuse = texture(material.diffuse, TexCoords).rgb;
-    vec3 texSpec    = texture(material.specular, TexCoords).rgb;
-
-    vec3 ambient  = light.ambient  * texDiffuse;
-    vec3 diffuse  = light.diffuse  * diff * texDiffuse;
-    vec3 specular = light.specular * spec * texSpec;
-
-    return ambient + diffuse + specular;
-}
-
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
-{
-    vec3 lightDir = normalize(light.position - fragPos);
-    float diff = max(dot(normal, lightDir), 0.0);
-
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-
-    float distance    = length(light.position - fragPos);
-    float attenuation = 1.0 /
-        (light.constant +
-         light.linear * distance +
-         light.quadratic * distance * distance);
-
-    vec3 texDiffuse = texture(material.diffuse, TexCoords).rgb;
-    vec3 texSpec    = texture(material.specular, TexCoords).rgb;
-
-    vec3 ambient  = light.ambient  * texDiffuse;
-    vec3 diffuse  = light.diffuse  * diff * texDiffuse;
-    vec3 specular = light.specular * spec * texSpec;
-
-    ambient  *= attenuation;
-    diffuse  *= attenuation;
-    specular *= attenuation;
-
-    return ambient + diffuse + specular;
-}
-
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
-{
-    vec3 lightDir = normalize(light.position - fragPos);
-
-    float diff = max(dot(normal, lightDir), 0.0);
-
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-
-    float distance    = length(light.position - fragPos);
-    float attenuation = 1.0 /
-        (light.constant +
-         light.linear * distance +
-         light.quadratic * distance * distance);
-
-    float theta   = dot(lightDir, normalize(-light.direction));
-    float epsilon = light.cutOff - light.outerCutOff;
-    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
-
-    vec3 texDiffuse = texture(material.diffuse, TexCoords).rgb;
-    vec3 texSpec    = texture(material.specular, TexCoords).rgb;
-
-    vec3 ambient  = light.ambient  * texDiffuse;
-    vec3 diffuse  = light.diffuse  * diff * texDiffuse;
-    vec3 specular = light.specular * spec * texSpec;
-
-    ambient  *= attenuation * intensity;
-    diffuse  *= attenuation * intensity;
-    specular *= attenuation * intensity;
-
-    return ambient + diffuse + specular;
-}
@@ -1,19 +1,27 @@
 #version 410 core
 in vec3 aPos;
-in vec3 aNor;
+in vec2 aNor;   // octahedral (gfx::NormalOct16)
 in vec2 aTexCoord;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform uvec3 objectLights;   // packed gfx::ObjectLights for this draw
+uniform vec2 materialParams;  // gfx::MaterialLibrary::Slot::params() for this draw
 
 out vec3 Normal;
 out vec3 FragPos;
 out vec2 TexCoords;
+flat out uvec3 LightSlots;
+flat out vec2 MaterialParams;
+
+#include "vertex_packing.glsl"
 
 void main(){
     gl_Position = projection * view * model * vec4(aPos, 1.0);
     FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNor;
+    Normal = mat3(transpose(inverse(model))) * octDecode(aNor);
     TexCoords = aTexCoord;
+    LightSlots = objectLights;
+    MaterialParams = materialParams;
 }
\ No newline at end of file
@@ -0,0 +1,39 @@
+#version 430 core
+// GPU-driven variant of cube_vertex.vert: the model matrix comes from the
+// instance buffer, indexed through the visible list the cull pass wrote.
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aNor;   // octahedral (gfx::NormalOct16)
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in uint aInstance;
+
+struct Instance {
+    mat4 model;
+    vec4 sphere;
+    uvec4 meta;   // x = mesh, yzw = packed gfx::ObjectLights
+    vec4 material; // xy = gfx::MaterialLibrary::Slot::params()
+};
+
+layout (std430, binding = 0) readonly buffer Instances {
+    Instance instances[];
+};
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 Normal;
+out vec3 FragPos;
+out vec2 TexCoords;
+flat out uvec3 LightSlots;
+flat out vec2 MaterialParams;
+
+#include "vertex_packing.glsl"
+
+void main(){
+    mat4 model = instances[aInstance].model;
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    Normal = mat3(transpose(inverse(model))) * octDecode(aNor);
+    TexCoords = aTexCoord;
+    LightSlots = instances[aInstance].meta.yzw;
+    MaterialParams = instances[aInstance].material.xy;
+}
@@ -0,0 +1,110 @@
+// ---------------------------------------------------------------------
+// Shared light model: the structs gfx::apply*Lights (light_config.h) fill and the
+// Phong terms for each light type. Include after #version.
+// ---------------------------------------------------------------------
+// Array sizes: gfx::kMaxDirLights / kMaxPointLights / kMaxSpotLights (light_config.h)
+#define MAX_DIR_LIGHTS   4
+#define MAX_POINT_LIGHTS 255
+#define MAX_SPOT_LIGHTS  128
+
+struct DirLight {
+    vec3 direction;
+
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct PointLight {
+    vec3 position;
+
+    float constant;
+    float linear;
+    float quadratic;
+
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct SpotLight {
+    vec3 position;
+    vec3 direction;
+    float cutOff;
+    float outerCutOff;
+
+    float constant;
+    float linear;
+    float quadratic;
+
+    vec3 diffuse;
+    vec3 specular;
+};
+
+// What the light functions need to know about the shaded point
+struct Surface {
+    vec3 normal;        // normalized
+    vec3 position;      // world space
+    vec3 viewDir;       // normalized, towards the eye
+    vec3 diffuse;       // diffuse map sample
+    vec3 specular;      // specular map sample
+    float shininess;    // Phong exponent
+};
+
+// ---------------------------------------------------------------------
+// LIGHT CALCULATIONS
+// ---------------------------------------------------------------------
+// Diffuse irradiance from L2 spherical harmonics (gfx::irradianceCoefficients)
+vec3 CalcAmbient(vec3 sh[9], vec3 n)
+{
+    return max(sh[0]
+             + sh[1] * n.y + sh[2] * n.z + sh[3] * n.x
+             + sh[4] * (n.x * n.y) + sh[5] * (n.y * n.z)
+             + sh[6] * (3.0 * n.z * n.z - 1.0)
+             + sh[7] * (n.x * n.z) + sh[8] * (n.x * n.x - n.y * n.y), 0.0);
+}
+
+vec3 CalcPhong(vec3 lightDir, vec3 lightDiffuse, vec3 lightSpecular, Surface s)
+{
+    float diff = max(dot(s.normal, lightDir), 0.0);
+
+    vec3 reflectDir = reflect(-lightDir, s.normal);
+    float spec = pow(max(dot(s.viewDir, reflectDir), 0.0), s.shininess);
+
+    vec3 diffuse  = lightDiffuse  * diff * s.diffuse;
+    vec3 specular = lightSpecular * spec * s.specular;
+
+    return diffuse + specular;
+}
+
+float CalcAttenuation(float constant, float linear, float quadratic, float distance)
+{
+    return 1.0 / (constant + linear * distance + quadratic * distance * distance);
+}
+
+vec3 CalcDirLight(DirLight light, Surface s)
+{
+    return CalcPhong(normalize(-light.direction), light.diffuse, light.specular, s);
+}
+
+vec3 CalcPointLight(PointLight light, Surface s)
+{
+    vec3 lightDir = normalize(light.position - s.position);
+
+    float distance    = length(light.position - s.position);
+    float attenuation = CalcAttenuation(light.constant, light.linear, light.quadratic, distance);
+
+    return CalcPhong(lightDir, light.diffuse, light.specular, s) * attenuation;
+}
+
+vec3 CalcSpotLight(SpotLight light, Surface s)
+{
+    vec3 lightDir = normalize(light.position - s.position);
+
+    float distance    = length(light.position - s.position);
+    float attenuation = CalcAttenuation(light.constant, light.linear, light.quadratic, distance);
+
+    float theta   = dot(lightDir, normalize(-light.direction));
+    float epsilon = light.cutOff - light.outerCutOff;
+    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+
+    return CalcPhong(lightDir, light.diffuse, light.specular, s) * (attenuation * intensity);
+}
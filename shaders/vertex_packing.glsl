@@ -0,0 +1,12 @@
+// ---------------------------------------------------------------------
+// Decoders for the packed vertex formats in vertex_layout.h. Include after #version.
+// ---------------------------------------------------------------------
+
+// gfx::NormalOct16: the unit normal from its octahedral projection
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
@@ -0,0 +1,199 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "asset_pack.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "lz4_block.h"
+
+namespace gfx {
+
+    namespace {
+        constexpr uint32_t kPackMagic = 0x4B415047;   // "GPAK"
+        constexpr uint32_t kPackVersion = 1;
+        constexpr uint64_t kPageSize = 4096;
+        constexpr uint32_t kFlagCompressed = 1;
+
+        struct Header {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t entryCount;
+            uint32_t indexStoredSize;   // the index follows the header as one LZ4 block
+            uint64_t indexSize;
+            uint64_t dataOffset;        // page-aligned; entry offsets are relative to it
+        };
+
+        uint64_t alignPage(uint64_t n) { return (n + kPageSize - 1) & ~(kPageSize - 1); }
+
+        template <class T> void put(std::vector<uint8_t>& out, T v)
+        {
+            const auto* p = reinterpret_cast<const uint8_t*>(&v);
+            out.insert(out.end(), p, p + sizeof(T));
+        }
+
+        template <class T> bool get(const std::vector<uint8_t>& in, size_t& at, T& v)
+        {
+            if (in.size() - at < sizeof(T))
+                return false;
+            std::memcpy(&v, in.data() + at, sizeof(T));
+            at += sizeof(T);
+            return true;
+        }
+
+        void writePadding(std::ostream& out, uint64_t n)
+        {
+            static const char zeros[kPageSize] = {};
+            out.write(zeros, static_cast<std::streamsize>(n));
+        }
+    }
+
+    bool AssetPack::open(const std::string& path)
+    {
+        index.clear();
+        lookup.clear();
+        if (!file.open(path))
+            return false;
+
+        Header header{};
+        if (file.size() < sizeof(Header))
+            return false;
+        std::memcpy(&header, file.data(), sizeof(Header));
+        if (header.magic != kPackMagic || header.version != kPackVersion) {
+            std::cerr << "Not an asset pack (or an older version): " << path << "\n";
+            return false;
+        }
+
+        // Sizes come from the file: bound them before allocating anything. Every
+        // record holds at least its name length, offset, sizes and flags.
+        constexpr uint64_t kMinRecordSize = 4 + 3 * 8 + 4;
+        if (header.indexStoredSize > file.size() - sizeof(Header) || header.dataOffset > file.size() ||
+            header.indexSize > lz4MaxDecodedSize(header.indexStoredSize) ||
+            header.entryCount > header.indexSize / kMinRecordSize) {
+            std::cerr << "Corrupt asset pack index: " << path << "\n";
+            return false;
+        }
+        std::vector<uint8_t> records(header.indexSize);
+        if (!lz4Decompress(file.data() + sizeof(Header), header.indexStoredSize, records.data(), records.size())) {
+            std::cerr << "Corrupt asset pack index: " << path << "\n";
+            return false;
+        }
+
+        size_t at = 0;
+        index.resize(header.entryCount);
+        for (Entry& entry : index) {
+            uint32_t nameLength = 0, flags = 0;
+            if (!get(records, at, nameLength) || records.size() - at < nameLength) {
+                std::cerr << "Corrupt asset pack index: " << path << "\n";
+                index.clear();
+                return false;
+            }
+            entry.name.assign(reinterpret_cast<const char*>(records.data() + at), nameLength);
+            at += nameLength;
+            if (!get(records, at, entry.offset) || !get(records, at, entry.storedSize) ||
+                !get(records, at, entry.size) || !get(records, at, flags) ||
+                entry.offset > file.size() - header.dataOffset ||
+                entry.storedSize > file.size() - header.dataOffset - entry.offset ||
+                ((flags & kFlagCompressed) && entry.size > lz4MaxDecodedSize(entry.storedSize))) {
+                std::cerr << "Corrupt asset pack index: " << path << "\n";
+                index.clear();
+                return false;
+            }
+            entry.offset += header.dataOffset;
+            entry.compressed = (flags & kFlagCompressed) != 0;
+            if (!entry.compressed)
+                entry.size = entry.storedSize;
+        }
+        for (size_t i = 0; i < index.size(); ++i)
+            lookup.emplace(index[i].name, i);
+        return true;
+    }
+
+    const AssetPack::Entry* AssetPack::find(const std::string& name) const
+    {
+        auto it = lookup.find(name);
+        return it == lookup.end() ? nullptr : &index[it->second];
+    }
+
+    const uint8_t* AssetPack::view(const Entry& entry) const
+    {
+        return entry.compressed ? nullptr : file.data() + entry.offset;
+    }
+
+    bool AssetPack::read(const Entry& entry, uint8_t* out) const
+    {
+        if (!entry.compressed) {
+            std::memcpy(out, file.data() + entry.offset, entry.size);
+            return true;
+        }
+        if (!lz4Decompress(file.data() + entry.offset, entry.storedSize, out, entry.size)) {
+            std::cerr << "Corrupt asset pack entry: " << entry.name << "\n";
+            return false;
+        }
+        return true;
+    }
+
+    bool writeAssetPack(const std::string& path, const std::vector<AssetPackInput>& inputs)
+    {
+        // Lay entries out first: compressed ones back to back, raw ones on page boundaries
+        std::vector<std::vector<uint8_t>> compressed(inputs.size());
+        std::vector<uint8_t> records;
+        std::vector<uint64_t> offsets(inputs.size());
+        uint64_t cursor = 0;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            const AssetPackInput& input = inputs[i];
+            if (input.allowCompression && !input.bytes.empty()) {
+                compressed[i] = lz4Compress(input.bytes.data(), input.bytes.size());
+                // Not worth a decode (or losing zero-copy) for less than an eighth
+                if (compressed[i].size() > input.bytes.size() - input.bytes.size() / 8)
+                    compressed[i].clear();
+            }
+            const bool packed = !compressed[i].empty();
+            const uint64_t storedSize = packed ? compressed[i].size() : input.bytes.size();
+            offsets[i] = packed ? cursor : alignPage(cursor);
+            cursor = offsets[i] + storedSize;
+
+            put(records, static_cast<uint32_t>(input.name.size()));
+            records.insert(records.end(), input.name.begin(), input.name.end());
+            put(records, offsets[i]);
+            put(records, storedSize);
+            put(records, static_cast<uint64_t>(input.bytes.size()));
+            put(records, packed ? kFlagCompressed : 0u);
+        }
+        const std::vector<uint8_t> storedIndex = lz4Compress(records.data(), records.size());
+
+        Header header{};
+        header.magic = kPackMagic;
+        header.version = kPackVersion;
+        header.entryCount = static_cast<uint32_t>(inputs.size());
+        header.indexStoredSize = static_cast<uint32_t>(storedIndex.size());
+        header.indexSize = records.size();
+        header.dataOffset = alignPage(sizeof(Header) + storedIndex.size());
+
+        // Write then rename so a running demo never maps a partial pack
+        const std::string temp = path + ".tmp";
+        {
+            std::ofstream out(temp, std::ios::binary);
+            if (!out)
+                return false;
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(storedIndex.data()), static_cast<std::streamsize>(storedIndex.size()));
+            uint64_t written = sizeof(Header) + storedIndex.size();
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                const std::vector<uint8_t>& bytes = compressed[i].empty() ? inputs[i].bytes : compressed[i];
+                const uint64_t at = header.dataOffset + offsets[i];
+                writePadding(out, at - written);
+                out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+                written = at + bytes.size();
+            }
+            if (!out)
+                return false;
+        }
+        std::error_code ec;
+        std::filesystem::rename(temp, path, ec);
+        return !ec;
+    }
+
+} // namespace gfx
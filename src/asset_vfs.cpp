@@ -0,0 +1,150 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "asset_vfs.h"
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_set>
+
+#include "asset_pack.h"
+
+namespace gfx {
+
+    namespace {
+        struct Mount {
+            std::string directory;      // normalized, ends in '/'
+            std::string prefix;
+            std::shared_ptr<const AssetPack> pack;
+        };
+
+        struct Mounts {
+            std::shared_mutex mutex;
+            std::vector<Mount> mounts;
+            std::vector<std::pair<std::string, std::shared_ptr<const AssetPack>>> packs;  // by normalized path
+            std::unordered_set<std::string> bypassed;
+        };
+
+        Mounts& mountTable()
+        {
+            static Mounts table;
+            return table;
+        }
+
+        std::string normalize(const std::string& path)
+        {
+            return std::filesystem::path(path).lexically_normal().generic_string();
+        }
+
+        // Pack entry for `path`, searching the most recently mounted directory first
+        const AssetPack::Entry* findPacked(const std::string& path, const AssetPack*& pack)
+        {
+            Mounts& table = mountTable();
+            std::shared_lock<std::shared_mutex> lock(table.mutex);
+            if (table.mounts.empty())
+                return nullptr;
+            const std::string normalized = normalize(path);
+            if (!table.bypassed.empty() && table.bypassed.count(normalized))
+                return nullptr;
+            for (auto it = table.mounts.rbegin(); it != table.mounts.rend(); ++it) {
+                if (normalized.compare(0, it->directory.size(), it->directory) != 0)
+                    continue;
+                if (const AssetPack::Entry* entry = it->pack->find(it->prefix + normalized.substr(it->directory.size()))) {
+                    pack = it->pack.get();
+                    return entry;
+                }
+            }
+            return nullptr;
+        }
+    }
+
+    bool mountAssetPack(const std::string& packPath, const std::string& directory, const std::string& prefix)
+    {
+        Mounts& table = mountTable();
+        std::unique_lock<std::shared_mutex> lock(table.mutex);
+
+        // A pack backing several directories is opened once
+        std::shared_ptr<const AssetPack> pack;
+        const std::string packKey = normalize(packPath);
+        for (const auto& [key, opened] : table.packs)
+            if (key == packKey)
+                pack = opened;
+        if (!pack) {
+            auto fresh = std::make_shared<AssetPack>();
+            if (!fresh->open(packPath))
+                return false;
+            size_t compressed = 0;
+            for (const AssetPack::Entry& entry : fresh->entries())
+                compressed += entry.compressed;
+            std::cout << "Mounted " << packPath << ": " << fresh->entries().size() << " assets ("
+                      << compressed << " compressed), " << fresh->fileSize() / 1024 << " KiB\n";
+            pack = fresh;
+            table.packs.emplace_back(packKey, pack);
+        }
+
+        std::string root = normalize(directory);
+        if (root.empty() || root.back() != '/')
+            root += '/';
+        table.mounts.push_back({ root, prefix, pack });
+
+        // Loose files edited since the pack was built win over their stale entries
+        std::error_code ec;
+        const auto packTime = std::filesystem::last_write_time(packPath, ec);
+        if (ec)
+            return true;
+        size_t stale = 0;
+        for (const AssetPack::Entry& entry : pack->entries()) {
+            if (entry.name.compare(0, prefix.size(), prefix) != 0)
+                continue;
+            const std::string loose = root + entry.name.substr(prefix.size());
+            const auto looseTime = std::filesystem::last_write_time(loose, ec);
+            if (!ec && looseTime > packTime && table.bypassed.insert(normalize(loose)).second)
+                stale++;
+        }
+        if (stale > 0)
+            std::cout << "  " << stale << " assets under " << root << " are newer on disk than the pack\n";
+        return true;
+    }
+
+    AssetData readAsset(const std::string& path)
+    {
+        AssetData asset;
+        const AssetPack* pack = nullptr;
+        if (const AssetPack::Entry* entry = findPacked(path, pack)) {
+            if (const uint8_t* view = pack->view(*entry)) {
+                asset.bytes = view;
+            } else {
+                asset.owned.resize(entry->size);
+                if (!pack->read(*entry, asset.owned.data()))
+                    return asset;
+                asset.bytes = asset.owned.data();
+            }
+            asset.length = entry->size;
+            asset.found = true;
+            return asset;
+        }
+
+        if (asset.file.open(path)) {
+            asset.bytes = asset.file.data();
+            asset.length = asset.file.size();
+            asset.found = true;
+        }
+        return asset;
+    }
+
+    void bypassAssetPack(const std::string& path)
+    {
+        Mounts& table = mountTable();
+        std::unique_lock<std::shared_mutex> lock(table.mutex);
+        table.bypassed.insert(normalize(path));
+    }
+
+    bool assetExists(const std::string& path)
+    {
+        const AssetPack* pack = nullptr;
+        return findPacked(path, pack) != nullptr || std::filesystem::exists(path);
+    }
+
+} // namespace gfx
@@ -0,0 +1,273 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "bvh.h"
+#include <algorithm>
+#include <numeric>
+
+namespace gfx {
+
+    namespace {
+        constexpr int kBinCount = 12;
+        constexpr int kMaxDepth = 60;   // keeps traversal within its fixed stack
+
+        float surfaceArea(const AABB& b)
+        {
+            glm::vec3 d = b.max - b.min;
+            return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+        }
+    }
+
+    RayQuery::RayQuery(const Ray& r)
+        : origin(r.origin), direction(r.direction),
+          invDirection(1.0f / r.direction.x, 1.0f / r.direction.y, 1.0f / r.direction.z) {}
+
+    float intersectAABB(const RayQuery& r, const AABB& b, float tMax)
+    {
+        glm::vec3 t0 = (b.min - r.origin) * r.invDirection;
+        glm::vec3 t1 = (b.max - r.origin) * r.invDirection;
+        float tNear = std::max(std::max(std::min(t0.x, t1.x), std::min(t0.y, t1.y)),
+                               std::max(std::min(t0.z, t1.z), 0.0f));
+        float tFar  = std::min(std::min(std::max(t0.x, t1.x), std::max(t0.y, t1.y)),
+                               std::min(std::max(t0.z, t1.z), tMax));
+        return tNear <= tFar ? tNear : std::numeric_limits<float>::infinity();
+    }
+
+// ------------------------------------------------------------------
+// BVH
+// ------------------------------------------------------------------
+    void BVH::build(const std::vector<AABB>& primitiveBounds, uint32_t maxLeafSize)
+    {
+        const uint32_t n = static_cast<uint32_t>(primitiveBounds.size());
+        nodeList.clear();
+        order.resize(n);
+        std::iota(order.begin(), order.end(), 0u);
+        if (n == 0)
+            return;
+
+        std::vector<glm::vec3> centers(n);
+        for (uint32_t i = 0; i < n; ++i)
+            centers[i] = primitiveBounds[i].center();
+
+        // A binary tree over n leaves-or-fewer never needs more than 2n - 1 nodes,
+        // so references into nodeList stay valid during the build.
+        nodeList.reserve(2 * static_cast<size_t>(n));
+        Node root;
+        root.first = 0;
+        root.count = n;
+        nodeList.push_back(root);
+        subdivide_(0, primitiveBounds, centers, std::max(maxLeafSize, 1u));
+        nodeList.shrink_to_fit();
+    }
+
+    void BVH::subdivide_(uint32_t nodeIndex, const std::vector<AABB>& prims,
+                         const std::vector<glm::vec3>& centers, uint32_t maxLeafSize)
+    {
+        struct Pending { uint32_t node; int depth; };
+        std::vector<Pending> work { { nodeIndex, 0 } };
+
+        while (!work.empty()) {
+            Pending job = work.back();
+            work.pop_back();
+            Node& node = nodeList[job.node];
+
+            AABB centroidBounds;
+            node.bounds = AABB{};
+            for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                node.bounds.expand(prims[order[i]]);
+                centroidBounds.expand(centers[order[i]]);
+            }
+            if (node.count <= maxLeafSize || job.depth >= kMaxDepth)
+                continue;
+
+            glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+            int axis = 0;
+            if (extent.y > extent[axis]) axis = 1;
+            if (extent.z > extent[axis]) axis = 2;
+            if (extent[axis] <= 0.0f)
+                continue;   // all centers coincide: nothing to split
+
+            // Binned SAH along the widest centroid axis
+            struct Bin { AABB bounds; uint32_t count = 0; };
+            Bin bins[kBinCount];
+            float scale = kBinCount / extent[axis];
+            auto binOf = [&](uint32_t prim) {
+                int b = static_cast<int>((centers[prim][axis] - centroidBounds.min[axis]) * scale);
+                return std::min(b, kBinCount - 1);
+            };
+            for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                Bin& bin = bins[binOf(order[i])];
+                bin.bounds.expand(prims[order[i]]);
+                bin.count++;
+            }
+
+            float leftArea[kBinCount - 1], rightArea[kBinCount - 1];
+            uint32_t leftCount[kBinCount - 1], rightCount[kBinCount - 1];
+            AABB acc;
+            uint32_t sum = 0;
+            for (int i = 0; i < kBinCount - 1; ++i) {
+                sum += bins[i].count;
+                leftCount[i] = sum;
+                if (bins[i].count) acc.expand(bins[i].bounds);
+                leftArea[i] = acc.valid() ? surfaceArea(acc) : 0.0f;
+            }
+            acc = AABB{};
+            sum = 0;
+            for (int i = kBinCount - 1; i > 0; --i) {
+                sum += bins[i].count;
+                rightCount[i - 1] = sum;
+                if (bins[i].count) acc.expand(bins[i].bounds);
+                rightArea[i - 1] = acc.valid() ? surfaceArea(acc) : 0.0f;
+            }
+
+            int bestSplit = -1;
+            float bestCost = std::numeric_limits<float>::max();
+            for (int i = 0; i < kBinCount - 1; ++i) {
+                if (leftCount[i] == 0 || rightCount[i] == 0) continue;
+                float cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+                if (cost < bestCost) { bestCost = cost; bestSplit = i; }
+            }
+
+            uint32_t* begin = order.data() + node.first;
+            uint32_t* end   = begin + node.count;
+            uint32_t* mid;
+            if (bestSplit >= 0) {
+                float leafCost = node.count * surfaceArea(node.bounds);
+                if (bestCost >= leafCost && node.count <= 4 * maxLeafSize)
+                    continue;
+                mid = std::partition(begin, end, [&](uint32_t p) { return binOf(p) <= bestSplit; });
+            } else {
+                // Everything landed in one bin: fall back to a median split
+                mid = begin + node.count / 2;
+                std::nth_element(begin, mid, end, [&](uint32_t a, uint32_t b) {
+                    return centers[a][axis] < centers[b][axis];
+                });
+            }
+
+            uint32_t leftN = static_cast<uint32_t>(mid - begin);
+            Node left, right;
+            left.first  = node.first;
+            left.count  = leftN;
+            right.first = node.first + leftN;
+            right.count = node.count - leftN;
+
+            uint32_t leftIndex = static_cast<uint32_t>(nodeList.size());
+            node.first = leftIndex;
+            node.count = 0;
+            nodeList.push_back(left);
+            nodeList.push_back(right);
+            work.push_back({ leftIndex + 1, job.depth + 1 });
+            work.push_back({ leftIndex, job.depth + 1 });
+        }
+    }
+
+    void BVH::refit(const std::vector<AABB>& primitiveBounds)
+    {
+        // Children are always stored after their parent
+        for (size_t i = nodeList.size(); i-- > 0;) {
+            Node& node = nodeList[i];
+            node.bounds = AABB{};
+            if (node.count > 0) {
+                for (uint32_t p = node.first; p < node.first + node.count; ++p)
+                    node.bounds.expand(primitiveBounds[order[p]]);
+            } else {
+                node.bounds.expand(nodeList[node.first].bounds);
+                node.bounds.expand(nodeList[node.first + 1].bounds);
+            }
+        }
+    }
+
+    bool BVH::empty() const
+    {
+        return nodeList.empty();
+    }
+
+    const std::vector<BVH::Node>& BVH::nodes() const
+    {
+        return nodeList;
+    }
+
+    const std::vector<uint32_t>& BVH::primitiveOrder() const
+    {
+        return order;
+    }
+
+// ------------------------------------------------------------------
+// TriangleBVH
+// ------------------------------------------------------------------
+    void TriangleBVH::build(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices)
+    {
+        const size_t triCount = indices.size() / 3;
+        auto position = [&](unsigned int i) { return positions[i]; };
+
+        std::vector<AABB> triBounds(triCount);
+        meshBounds = AABB{};
+        for (size_t t = 0; t < triCount; ++t) {
+            for (int k = 0; k < 3; ++k)
+                triBounds[t].expand(position(indices[3 * t + k]));
+            meshBounds.expand(triBounds[t]);
+        }
+
+        bvh.build(triBounds);
+
+        const auto& order = bvh.primitiveOrder();
+        triangles.resize(triCount);
+        sourceToSlot.resize(triCount);
+        for (size_t slot = 0; slot < triCount; ++slot) {
+            uint32_t src = order[slot];
+            glm::vec3 a = position(indices[3 * src]);
+            glm::vec3 b = position(indices[3 * src + 1]);
+            glm::vec3 c = position(indices[3 * src + 2]);
+            triangles[slot] = Triangle { a, b - a, c - a, src };
+            sourceToSlot[src] = static_cast<uint32_t>(slot);
+        }
+    }
+
+    bool TriangleBVH::intersect(const RayQuery& r, float tMax, TriangleHit& hit) const
+    {
+        bool found = false;
+        bvh.traverse(r, tMax, [&](uint32_t first, uint32_t count, float& tLimit) {
+            for (uint32_t i = first; i < first + count; ++i) {
+                // Moller-Trumbore, two-sided
+                const Triangle& tri = triangles[i];
+                glm::vec3 p = glm::cross(r.direction, tri.e2);
+                float det = glm::dot(tri.e1, p);
+                if (std::abs(det) < 1e-12f) continue;
+                float invDet = 1.0f / det;
+                glm::vec3 s = r.origin - tri.v0;
+                float u = glm::dot(s, p) * invDet;
+                if (u < 0.0f || u > 1.0f) continue;
+                glm::vec3 q = glm::cross(s, tri.e1);
+                float v = glm::dot(r.direction, q) * invDet;
+                if (v < 0.0f || u + v > 1.0f) continue;
+                float t = glm::dot(tri.e2, q) * invDet;
+                if (t < 0.0f || t >= tLimit) continue;
+
+                tLimit = t;
+                hit.t = t;
+                hit.triangle = tri.source;
+                hit.u = u;
+                hit.v = v;
+                found = true;
+            }
+        });
+        return found;
+    }
+
+    const AABB& TriangleBVH::bounds() const
+    {
+        return meshBounds;
+    }
+
+    size_t TriangleBVH::triangleCount() const
+    {
+        return triangles.size();
+    }
+
+    glm::vec3 TriangleBVH::normal(uint32_t triangle) const
+    {
+        const Triangle& tri = triangles[sourceToSlot[triangle]];
+        return glm::normalize(glm::cross(tri.e1, tri.e2));
+    }
+
+} // namespace gfx
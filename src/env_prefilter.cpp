@@ -0,0 +1,291 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "env_prefilter.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <glm.hpp>
+
+#include "asset_vfs.h"
+#include "hash.h"
+#include "mipmap.h"
+
+namespace gfx {
+
+    namespace {
+        constexpr uint32_t kBakeVersion = 1;
+        constexpr float kPi = 3.14159265358979f;
+
+        // Face axes from the GL cube map table: direction = major + sc * s + tc * t
+        struct FaceFrame { glm::vec3 major, s, t; };
+        const FaceFrame kFaces[6] = {
+            { {  1,  0,  0 }, {  0,  0, -1 }, { 0, -1,  0 } },
+            { { -1,  0,  0 }, {  0,  0,  1 }, { 0, -1,  0 } },
+            { {  0,  1,  0 }, {  1,  0,  0 }, { 0,  0,  1 } },
+            { {  0, -1,  0 }, {  1,  0,  0 }, { 0,  0, -1 } },
+            { {  0,  0,  1 }, {  1,  0,  0 }, { 0, -1,  0 } },
+            { {  0,  0, -1 }, { -1,  0,  0 }, { 0, -1,  0 } },
+        };
+
+        // One source level of one face, linear RGB
+        struct LinearFace {
+            int size = 0;
+            std::vector<float> rgb;
+        };
+        using LinearCube = std::vector<std::array<LinearFace, 6>>;   // [level][face]
+
+        const float* srgbToLinear()
+        {
+            static const auto table = [] {
+                std::array<float, 256> t{};
+                for (int i = 0; i < 256; ++i) {
+                    double c = i / 255.0;
+                    t[i] = static_cast<float>(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+                }
+                return t;
+            }();
+            return table.data();
+        }
+
+        uint8_t linearToSrgb(float l)
+        {
+            l = std::min(std::max(l, 0.0f), 1.0f);
+            float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+            return static_cast<uint8_t>(std::lround(c * 255.0f));
+        }
+
+        // Face and [0, 1] texture coordinates of a direction (inverse of kFaces)
+        void cubeCoords(const glm::vec3& d, int& face, float& s, float& t)
+        {
+            const float ax = std::fabs(d.x), ay = std::fabs(d.y), az = std::fabs(d.z);
+            float ma, sc, tc;
+            if (ax >= ay && ax >= az) {
+                face = d.x > 0 ? 0 : 1; ma = ax; sc = d.x > 0 ? -d.z : d.z; tc = -d.y;
+            } else if (ay >= az) {
+                face = d.y > 0 ? 2 : 3; ma = ay; sc = d.x; tc = d.y > 0 ? d.z : -d.z;
+            } else {
+                face = d.z > 0 ? 4 : 5; ma = az; sc = d.z > 0 ? d.x : -d.x; tc = -d.y;
+            }
+            s = 0.5f * (sc / ma + 1.0f);
+            t = 0.5f * (tc / ma + 1.0f);
+        }
+
+        // Bilinear within the face; edges clamp (the sources are seamless enough at these sizes)
+        glm::vec3 sampleFace(const LinearFace& f, float s, float t)
+        {
+            const float x = std::min(std::max(s * f.size - 0.5f, 0.0f), f.size - 1.0f);
+            const float y = std::min(std::max(t * f.size - 0.5f, 0.0f), f.size - 1.0f);
+            const int x0 = static_cast<int>(x), y0 = static_cast<int>(y);
+            const int x1 = std::min(x0 + 1, f.size - 1), y1 = std::min(y0 + 1, f.size - 1);
+            const float fx = x - x0, fy = y - y0;
+            auto at = [&](int px, int py) {
+                const float* p = &f.rgb[(static_cast<size_t>(py) * f.size + px) * 3];
+                return glm::vec3(p[0], p[1], p[2]);
+            };
+            return (at(x0, y0) * (1 - fx) + at(x1, y0) * fx) * (1 - fy)
+                 + (at(x0, y1) * (1 - fx) + at(x1, y1) * fx) * fy;
+        }
+
+        glm::vec3 sampleCube(const LinearCube& cube, const glm::vec3& dir, float lod)
+        {
+            int face;
+            float s, t;
+            cubeCoords(dir, face, s, t);
+            lod = std::min(std::max(lod, 0.0f), static_cast<float>(cube.size() - 1));
+            const int l0 = static_cast<int>(lod), l1 = std::min(l0 + 1, static_cast<int>(cube.size()) - 1);
+            const float f = lod - l0;
+            glm::vec3 c = sampleFace(cube[l0][face], s, t);
+            if (f > 0.0f)
+                c = c * (1.0f - f) + sampleFace(cube[l1][face], s, t) * f;
+            return c;
+        }
+
+        float radicalInverse(uint32_t bits)
+        {
+            bits = (bits << 16u) | (bits >> 16u);
+            bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+            bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+            bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+            bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+            return static_cast<float>(bits) * 2.3283064365386963e-10f;
+        }
+
+        // A light direction in the tangent frame of N (= V), its cosine weight and source lod
+        struct LobeSample {
+            glm::vec3 direction;
+            float weight;
+            float lod;
+        };
+
+        // GGX importance samples (Hammersley) for one roughness. The lod picks the
+        // source mip whose texel solid angle matches the sample's (filtered importance sampling).
+        std::vector<LobeSample> lobeSamples(float roughness, int count, int sourceSize)
+        {
+            const float a = roughness * roughness, a2 = a * a;
+            const float texelSolidAngle = 4.0f * kPi / (6.0f * sourceSize * sourceSize);
+            std::vector<LobeSample> samples;
+            for (int i = 0; i < count; ++i) {
+                const float u = (i + 0.5f) / count, v = radicalInverse(static_cast<uint32_t>(i));
+                const float phi = 2.0f * kPi * u;
+                const float cosTheta = std::sqrt((1.0f - v) / (1.0f + (a2 - 1.0f) * v));
+                const float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+                const glm::vec3 h(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+                const glm::vec3 l = h * (2.0f * cosTheta) - glm::vec3(0, 0, 1);
+                if (l.z <= 0.0f)
+                    continue;
+                // With N = V the pdf of L is D(h) / 4
+                const float denom = cosTheta * cosTheta * (a2 - 1.0f) + 1.0f;
+                const float pdf = a2 / (kPi * denom * denom) * 0.25f;
+                const float sampleSolidAngle = 1.0f / (count * pdf + 1e-6f);
+                const float lod = std::max(0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1.0f, 0.0f);
+                samples.push_back({ l, l.z, lod });
+            }
+            return samples;
+        }
+
+        LinearCube linearSource(const std::vector<Image>& faces, int size, ThreadPool& pool)
+        {
+            // Full chains, then keep from the first level no larger than twice the output
+            std::vector<std::vector<MipLevel>> chains = buildMipChains(faces, true, pool);
+            size_t first = 0;
+            while (first + 1 < chains[0].size() && chains[0][first].width > 2 * size)
+                ++first;
+
+            const float* toLinear = srgbToLinear();
+            LinearCube cube(chains[0].size() - first);
+            pool.parallelFor(0, cube.size() * 6, 1, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    const MipLevel& level = chains[i % 6][first + i / 6];
+                    LinearFace& face = cube[i / 6][i % 6];
+                    face.size = level.width;
+                    face.rgb.resize(static_cast<size_t>(level.width) * level.height * 3);
+                    for (size_t p = 0; p < static_cast<size_t>(level.width) * level.height; ++p)
+                        for (int c = 0; c < 3; ++c)
+                            face.rgb[p * 3 + c] = toLinear[level.rgba[p * 4 + c]];
+                }
+            });
+            return cube;
+        }
+    }
+
+    KtxSource prefilterCubeMap(const std::vector<Image>& faces, const PrefilterSettings& settings, ThreadPool& pool)
+    {
+        KtxSource out;
+        if (faces.size() != 6) {
+            std::cerr << "Environment prefilter needs 6 cube faces, got " << faces.size() << "\n";
+            return out;
+        }
+        for (const Image& face : faces)
+            if (!face.valid() || face.width != face.height || face.width != faces[0].width) {
+                std::cerr << "Environment prefilter: invalid or mismatched cube face " << face.path << "\n";
+                return out;
+            }
+
+        const int size = std::max(1, settings.size);
+        const int levels = std::max(1, std::min(settings.levels, static_cast<int>(std::log2(size)) + 1));
+        const LinearCube source = linearSource(faces, size, pool);
+        const int sourceSize = source[0][0].size;
+        const float mirrorLod = std::log2(static_cast<float>(sourceSize) / size);
+
+        out.internalFormat = GL_RGBA8;
+        out.format = GL_RGBA;
+        out.type = GL_UNSIGNED_BYTE;
+        out.baseInternalFormat = GL_RGBA;
+        out.width = out.height = size;
+        out.faces = 6;
+        out.keyValues.emplace_back("gfx.prefilter", "ggx roughness=level/" + std::to_string(std::max(1, levels - 1)));
+        out.images.resize(static_cast<size_t>(levels) * 6);
+
+        for (int level = 0; level < levels; ++level) {
+            const int levelSize = std::max(1, size >> level);
+            const float roughness = levels > 1 ? static_cast<float>(level) / (levels - 1) : 0.0f;
+            const std::vector<LobeSample> samples = lobeSamples(roughness, settings.samples, sourceSize);
+            for (int f = 0; f < 6; ++f)
+                out.images[level * 6 + f].resize(static_cast<size_t>(levelSize) * levelSize * 4);
+
+            pool.parallelFor(0, static_cast<size_t>(levelSize) * 6, 4, [&](size_t begin, size_t end) {
+                for (size_t row = begin; row < end; ++row) {
+                    const int f = static_cast<int>(row / levelSize), y = static_cast<int>(row % levelSize);
+                    const FaceFrame& frame = kFaces[f];
+                    uint8_t* out8 = out.images[level * 6 + f].data() + static_cast<size_t>(y) * levelSize * 4;
+                    const float tc = -1.0f + (y + 0.5f) * 2.0f / levelSize;
+                    for (int x = 0; x < levelSize; ++x) {
+                        const float sc = -1.0f + (x + 0.5f) * 2.0f / levelSize;
+                        const glm::vec3 n = glm::normalize(frame.major + frame.s * sc + frame.t * tc);
+
+                        glm::vec3 color(0.0f);
+                        if (level == 0) {
+                            color = sampleCube(source, n, mirrorLod);
+                        } else {
+                            const glm::vec3 up = std::fabs(n.z) < 0.999f ? glm::vec3(0, 0, 1) : glm::vec3(1, 0, 0);
+                            const glm::vec3 tangent = glm::normalize(glm::cross(up, n));
+                            const glm::vec3 bitangent = glm::cross(n, tangent);
+                            float weight = 0.0f;
+                            for (const LobeSample& s : samples) {
+                                const glm::vec3 l = tangent * s.direction.x + bitangent * s.direction.y + n * s.direction.z;
+                                color += sampleCube(source, l, s.lod) * s.weight;
+                                weight += s.weight;
+                            }
+                            color = weight > 0.0f ? color * (1.0f / weight) : sampleCube(source, n, mirrorLod);
+                        }
+                        out8[x * 4 + 0] = linearToSrgb(color.x);
+                        out8[x * 4 + 1] = linearToSrgb(color.y);
+                        out8[x * 4 + 2] = linearToSrgb(color.z);
+                        out8[x * 4 + 3] = 255;
+                    }
+                }
+            });
+        }
+        return out;
+    }
+
+    std::string prefilterEnvironment(const std::vector<std::string>& faces, const std::string& cacheDir,
+                                     const PrefilterSettings& settings, ThreadPool& pool)
+    {
+        std::vector<AssetData> files(faces.size());
+        uint64_t hash = hashBytes(&kBakeVersion, sizeof(kBakeVersion));
+        const int key[3] = { settings.size, settings.levels, settings.samples };
+        hash = hashBytes(key, sizeof(key), hash);
+        for (size_t i = 0; i < faces.size(); ++i) {
+            files[i] = readAsset(faces[i]);
+            if (!files[i].valid()) {
+                std::cerr << "Failed to load environment face: " << faces[i] << "\n";
+                return {};
+            }
+            hash = hashBytes(files[i].data(), files[i].size(), hash);
+        }
+
+        const std::string path = (std::filesystem::path(cacheDir) / (hashName(hash) + ".ktx")).string();
+        KtxTexture cached;
+        if (std::filesystem::exists(path) && cached.load(path) && cached.isCube())
+            return path;
+
+        std::vector<Image> images(faces.size());
+        pool.parallelFor(0, faces.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                images[i] = decodeImage(files[i].data(), files[i].size(), false, faces[i]);
+        });
+        KtxSource baked = prefilterCubeMap(images, settings, pool);
+        if (baked.images.empty())
+            return {};
+
+        std::error_code ec;
+        std::filesystem::create_directories(cacheDir, ec);
+        // Write then rename so a crash or concurrent run never leaves a partial
+        // file that the next start would take for a cache hit
+        const std::string temp = path + ".tmp";
+        const bool written = writeKtx(temp, baked);
+        if (written)
+            std::filesystem::rename(temp, path, ec);
+        if (!written || ec) {
+            std::cerr << "Failed to write prefiltered environment: " << path << "\n";
+            std::filesystem::remove(temp, ec);
+            return {};
+        }
+        return path;
+    }
+
+} // namespace gfx
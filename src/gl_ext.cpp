@@ -0,0 +1,82 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "gl_ext.h"
+#include <cstring>
+
+extern "C" {
+PFNGLGETPROGRAMBINARYPROC glext_glGetProgramBinary = nullptr;
+PFNGLPROGRAMBINARYPROC glext_glProgramBinary = nullptr;
+PFNGLPROGRAMPARAMETERIPROC glext_glProgramParameteri = nullptr;
+PFNGLGENPROGRAMPIPELINESPROC glext_glGenProgramPipelines = nullptr;
+PFNGLDELETEPROGRAMPIPELINESPROC glext_glDeleteProgramPipelines = nullptr;
+PFNGLBINDPROGRAMPIPELINEPROC glext_glBindProgramPipeline = nullptr;
+PFNGLUSEPROGRAMSTAGESPROC glext_glUseProgramStages = nullptr;
+PFNGLACTIVESHADERPROGRAMPROC glext_glActiveShaderProgram = nullptr;
+PFNGLVALIDATEPROGRAMPIPELINEPROC glext_glValidateProgramPipeline = nullptr;
+PFNGLGETPROGRAMPIPELINEIVPROC glext_glGetProgramPipelineiv = nullptr;
+PFNGLGETPROGRAMPIPELINEINFOLOGPROC glext_glGetProgramPipelineInfoLog = nullptr;
+PFNGLMEMORYBARRIERPROC glext_glMemoryBarrier = nullptr;
+PFNGLBINDIMAGETEXTUREPROC glext_glBindImageTexture = nullptr;
+PFNGLTEXSTORAGE2DPROC glext_glTexStorage2D = nullptr;
+PFNGLDISPATCHCOMPUTEPROC glext_glDispatchCompute = nullptr;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glext_glMultiDrawElementsIndirect = nullptr;
+PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glext_glMaxShaderCompilerThreadsKHR = nullptr;
+}
+
+namespace gfx {
+
+    void loadGLExtensions(GLADloadproc load)
+    {
+        if (hasGLVersion(4, 1) || hasGLExtension("GL_ARB_get_program_binary")) {
+            glext_glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)load("glGetProgramBinary");
+            glext_glProgramBinary = (PFNGLPROGRAMBINARYPROC)load("glProgramBinary");
+            glext_glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)load("glProgramParameteri");
+        }
+        if (hasGLVersion(4, 1) || hasGLExtension("GL_ARB_separate_shader_objects")) {
+            glext_glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)load("glProgramParameteri");
+            glext_glGenProgramPipelines = (PFNGLGENPROGRAMPIPELINESPROC)load("glGenProgramPipelines");
+            glext_glDeleteProgramPipelines = (PFNGLDELETEPROGRAMPIPELINESPROC)load("glDeleteProgramPipelines");
+            glext_glBindProgramPipeline = (PFNGLBINDPROGRAMPIPELINEPROC)load("glBindProgramPipeline");
+            glext_glUseProgramStages = (PFNGLUSEPROGRAMSTAGESPROC)load("glUseProgramStages");
+            glext_glActiveShaderProgram = (PFNGLACTIVESHADERPROGRAMPROC)load("glActiveShaderProgram");
+            glext_glValidateProgramPipeline = (PFNGLVALIDATEPROGRAMPIPELINEPROC)load("glValidateProgramPipeline");
+            glext_glGetProgramPipelineiv = (PFNGLGETPROGRAMPIPELINEIVPROC)load("glGetProgramPipelineiv");
+            glext_glGetProgramPipelineInfoLog = (PFNGLGETPROGRAMPIPELINEINFOLOGPROC)load("glGetProgramPipelineInfoLog");
+        }
+        if (hasGLVersion(4, 2)) {
+            glext_glMemoryBarrier = (PFNGLMEMORYBARRIERPROC)load("glMemoryBarrier");
+            glext_glBindImageTexture = (PFNGLBINDIMAGETEXTUREPROC)load("glBindImageTexture");
+            glext_glTexStorage2D = (PFNGLTEXSTORAGE2DPROC)load("glTexStorage2D");
+        }
+        if (hasGLVersion(4, 3)) {
+            glext_glDispatchCompute = (PFNGLDISPATCHCOMPUTEPROC)load("glDispatchCompute");
+            glext_glMultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)load("glMultiDrawElementsIndirect");
+        }
+        // The ARB entry point is the same function under its own name
+        if (hasGLExtension("GL_KHR_parallel_shader_compile"))
+            glext_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsKHR");
+        else if (hasGLExtension("GL_ARB_parallel_shader_compile"))
+            glext_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsARB");
+        if (glext_glMaxShaderCompilerThreadsKHR)
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);   // implementation-chosen maximum
+    }
+
+    bool hasGLVersion(int major, int minor)
+    {
+        return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+    }
+
+    bool hasGLExtension(const char* name)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i) {
+            const char* ext = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+            if (ext && std::strcmp(ext, name) == 0)
+                return true;
+        }
+        return false;
+    }
+
+} // namespace gfx
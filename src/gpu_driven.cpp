@@ -0,0 +1,341 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "gpu_driven.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace gfx {
+
+    namespace {
+        constexpr GLuint kInstanceBinding = 0;
+        constexpr GLuint kCommandBinding  = 1;
+        constexpr GLuint kVisibleBinding  = 2;
+        constexpr GLint  kHiZTextureUnit  = 8;   // clear of the material/skybox units
+        constexpr GLuint kCullGroupSize   = 64;
+        constexpr GLuint kHiZGroupSize    = 8;
+    }
+
+    GpuDrivenRenderer::GpuDrivenRenderer()
+        : cullProgram(std::string(SHADER_DIR) + "instance_cull.comp"),
+          hizProgram(std::string(SHADER_DIR) + "hiz_build.comp")
+    {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        glGenBuffers(1, &instanceBuffer);
+        glGenBuffers(1, &visibleBuffer);
+        glGenBuffers(1, &commandBuffer);
+        glGenBuffers(1, &commandTemplate);
+
+        // Same interleaved layout as Mesh (Mesh::VertexFormat), plus the per-instance index stream.
+        // With baseInstance set per command, attribute 3 reads that command's
+        // slice of the visible list.
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        Mesh::VertexFormat::setupAttributes();
+
+        glBindBuffer(GL_ARRAY_BUFFER, visibleBuffer);
+        glVertexAttribIPointer(kInstanceAttribute, 1, GL_UNSIGNED_INT, sizeof(GLuint), nullptr);
+        glVertexAttribDivisor(kInstanceAttribute, 1);
+        glEnableVertexAttribArray(kInstanceAttribute);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    GpuDrivenRenderer::~GpuDrivenRenderer()
+    {
+        cleanup();
+    }
+
+    bool GpuDrivenRenderer::isSupported()
+    {
+        return hasGLVersion(4, 3) && glDispatchCompute && glMultiDrawElementsIndirect;
+    }
+
+    int GpuDrivenRenderer::addMesh(const Mesh& mesh)
+    {
+        MeshRange range;
+        range.bounds     = mesh.getBounds();
+        range.indexCount = static_cast<GLuint>(mesh.getIndices().size());
+        range.firstIndex = static_cast<GLuint>(indices.size());
+        range.baseVertex = static_cast<GLint>(vertices.size());
+
+        vertices.append(mesh.getVertices());
+        indices.insert(indices.end(), mesh.getIndices().begin(), mesh.getIndices().end());
+        meshes.push_back(range);
+
+        geometryDirty = true;
+        commandsDirty = true;
+        return static_cast<int>(meshes.size()) - 1;
+    }
+
+    int GpuDrivenRenderer::addInstance(int meshId, const glm::mat4& model)
+    {
+        GpuInstance inst;
+        inst.meta = glm::uvec4(static_cast<unsigned>(meshId), 0u, 0u, 0u);
+        instances.push_back(inst);
+        commandsDirty = true;
+
+        int id = static_cast<int>(instances.size()) - 1;
+        setInstanceTransform(id, model);
+        return id;
+    }
+
+    void GpuDrivenRenderer::setInstanceTransform(int instanceId, const glm::mat4& model)
+    {
+        GpuInstance& inst = instances[instanceId];
+        BoundingSphere s = transformSphere(meshes[inst.meta.x].bounds, model);
+        inst.model  = model;
+        inst.sphere = glm::vec4(s.center, s.radius);
+        markDirty_(static_cast<size_t>(instanceId));
+    }
+
+    void GpuDrivenRenderer::setInstanceLights(int instanceId, const glm::uvec3& packedLights)
+    {
+        GpuInstance& inst = instances[instanceId];
+        if (inst.meta.y == packedLights.x && inst.meta.z == packedLights.y && inst.meta.w == packedLights.z)
+            return;
+        inst.meta = glm::uvec4(inst.meta.x, packedLights.x, packedLights.y, packedLights.z);
+        markDirty_(static_cast<size_t>(instanceId));
+    }
+
+    void GpuDrivenRenderer::setInstanceMaterial(int instanceId, const glm::vec2& materialParams)
+    {
+        GpuInstance& inst = instances[instanceId];
+        inst.material = glm::vec4(materialParams.x, materialParams.y, 0.0f, 0.0f);
+        markDirty_(static_cast<size_t>(instanceId));
+    }
+
+    void GpuDrivenRenderer::markDirty_(size_t i)
+    {
+        if (dirtyBegin == dirtyEnd) { dirtyBegin = i; dirtyEnd = i + 1; }
+        else { dirtyBegin = std::min(dirtyBegin, i); dirtyEnd = std::max(dirtyEnd, i + 1); }
+    }
+
+    void GpuDrivenRenderer::setOcclusionCulling(bool enabled)
+    {
+        occlusionEnabled = enabled;
+    }
+
+    size_t GpuDrivenRenderer::instanceCount() const
+    {
+        return instances.size();
+    }
+
+    void GpuDrivenRenderer::uploadGeometry_()
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER,
+                     static_cast<GLsizeiptr>(vertices.byteSize()),
+                     vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        glBindVertexArray(VAO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                     static_cast<GLsizeiptr>(indices.size() * sizeof(unsigned int)),
+                     indices.data(), GL_STATIC_DRAW);
+        glBindVertexArray(0);
+
+        geometryDirty = false;
+    }
+
+    void GpuDrivenRenderer::rebuildCommands_()
+    {
+        // Each mesh owns a contiguous slice of the visible list sized for all of its instances.
+        std::vector<DrawElementsIndirectCommand> cmds(meshes.size());
+        for (size_t m = 0; m < meshes.size(); ++m) {
+            cmds[m].count         = meshes[m].indexCount;
+            cmds[m].instanceCount = 0;
+            cmds[m].firstIndex    = meshes[m].firstIndex;
+            cmds[m].baseVertex    = meshes[m].baseVertex;
+            cmds[m].baseInstance  = 0;
+        }
+        for (const auto& inst : instances)
+            cmds[inst.meta.x].baseInstance++;
+        GLuint offset = 0;
+        for (auto& c : cmds) {
+            GLuint n = c.baseInstance;
+            c.baseInstance = offset;
+            offset += n;
+        }
+
+        GLsizeiptr cmdBytes = static_cast<GLsizeiptr>(cmds.size() * sizeof(DrawElementsIndirectCommand));
+        glBindBuffer(GL_COPY_WRITE_BUFFER, commandTemplate);
+        glBufferData(GL_COPY_WRITE_BUFFER, cmdBytes, cmds.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, commandBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, cmdBytes, nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        if (instances.size() > instanceCapacity) {
+            instanceCapacity = std::max(instances.size(), instanceCapacity * 2);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer);
+            glBufferData(GL_SHADER_STORAGE_BUFFER,
+                         static_cast<GLsizeiptr>(instanceCapacity * sizeof(GpuInstance)),
+                         nullptr, GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, visibleBuffer);
+            glBufferData(GL_SHADER_STORAGE_BUFFER,
+                         static_cast<GLsizeiptr>(instanceCapacity * sizeof(GLuint)),
+                         nullptr, GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+            // Fresh storage: everything needs uploading again
+            dirtyBegin = 0;
+            dirtyEnd = instances.size();
+        }
+
+        commandsDirty = false;
+    }
+
+    void GpuDrivenRenderer::uploadInstances_()
+    {
+        if (dirtyBegin == dirtyEnd)
+            return;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER,
+                        static_cast<GLintptr>(dirtyBegin * sizeof(GpuInstance)),
+                        static_cast<GLsizeiptr>((dirtyEnd - dirtyBegin) * sizeof(GpuInstance)),
+                        instances.data() + dirtyBegin);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        dirtyBegin = dirtyEnd = 0;
+    }
+
+    void GpuDrivenRenderer::cull(const glm::mat4& view, const glm::mat4& projection)
+    {
+        if (instances.empty())
+            return;
+        if (geometryDirty) uploadGeometry_();
+        if (commandsDirty) rebuildCommands_();
+        uploadInstances_();
+
+        // Reset instanceCount on the GPU; no readback, no per-command CPU work.
+        GLsizeiptr cmdBytes = static_cast<GLsizeiptr>(meshes.size() * sizeof(DrawElementsIndirectCommand));
+        glBindBuffer(GL_COPY_READ_BUFFER, commandTemplate);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, commandBuffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, cmdBytes);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        frameViewProj = projection * view;
+        Frustum frustum = Frustum::fromMatrix(frameViewProj);
+
+        cullProgram.use();
+        cullProgram.setUniform("numInstances", static_cast<int>(instances.size()));
+        for (int i = 0; i < 6; ++i)
+            cullProgram.setUniform("frustumPlanes[" + std::to_string(i) + "]", frustum.planes[i]);
+
+        bool useHiZ = occlusionEnabled && hizValid;
+        cullProgram.setUniform("occlusionEnabled", useHiZ ? 1 : 0);
+        if (useHiZ) {
+            cullProgram.setUniform("hizViewProj", hizViewProj);
+            cullProgram.setUniform("hizSize", glm::vec2(static_cast<float>(hizWidth), static_cast<float>(hizHeight)));
+            cullProgram.setUniform("hizLevels", hizLevels);
+            cullProgram.setUniform("hiz", kHiZTextureUnit);
+            glActiveTexture(GL_TEXTURE0 + kHiZTextureUnit);
+            glBindTexture(GL_TEXTURE_2D, hizTexture);
+        }
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kInstanceBinding, instanceBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kCommandBinding, commandBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kVisibleBinding, visibleBuffer);
+
+        GLuint groups = (static_cast<GLuint>(instances.size()) + kCullGroupSize - 1) / kCullGroupSize;
+        glDispatchCompute(groups, 1, 1);
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    void GpuDrivenRenderer::draw() const
+    {
+        if (instances.empty())
+            return;
+        // The caller has bound the program and its per-frame uniforms.
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kInstanceBinding, instanceBuffer);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr,
+                                    static_cast<GLsizei>(meshes.size()), 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+
+    void GpuDrivenRenderer::resizeHiZ_(int width, int height)
+    {
+        if (depthTexture) glDeleteTextures(1, &depthTexture);
+        if (hizTexture) glDeleteTextures(1, &hizTexture);
+
+        hizWidth  = width;
+        hizHeight = height;
+        hizLevels = 1 + static_cast<int>(std::floor(std::log2(static_cast<float>(std::max(width, height)))));
+
+        glActiveTexture(GL_TEXTURE0 + kHiZTextureUnit);
+
+        glGenTextures(1, &depthTexture);
+        glBindTexture(GL_TEXTURE_2D, depthTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0,
+                     GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        glGenTextures(1, &hizTexture);
+        glBindTexture(GL_TEXTURE_2D, hizTexture);
+        glTexStorage2D(GL_TEXTURE_2D, hizLevels, GL_R32F, width, height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+        hizValid = false;
+    }
+
+    void GpuDrivenRenderer::updateOcclusion(int width, int height)
+    {
+        if (!occlusionEnabled || width <= 0 || height <= 0)
+            return;
+        if (width != hizWidth || height != hizHeight)
+            resizeHiZ_(width, height);
+
+        // Grab this frame's depth from the default framebuffer
+        glActiveTexture(GL_TEXTURE0 + kHiZTextureUnit);
+        glBindTexture(GL_TEXTURE_2D, depthTexture);
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+
+        hizProgram.use();
+        hizProgram.setUniform("src", kHiZTextureUnit);
+
+        int w = width, h = height;
+        for (int level = 0; level < hizLevels; ++level) {
+            int srcW = w, srcH = h;
+            if (level > 0) {
+                w = std::max(1, w / 2);
+                h = std::max(1, h / 2);
+                glBindTexture(GL_TEXTURE_2D, hizTexture);
+            }
+            hizProgram.setUniform("srcLevel", level - 1);
+            hizProgram.setUniform("srcSize", glm::ivec2(srcW, srcH));
+            glBindImageTexture(0, hizTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+            glDispatchCompute((w + kHiZGroupSize - 1) / kHiZGroupSize,
+                              (h + kHiZGroupSize - 1) / kHiZGroupSize, 1);
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        hizViewProj = frameViewProj;
+        hizValid = true;
+    }
+
+    void GpuDrivenRenderer::cleanup()
+    {
+        if (VAO) { glDeleteVertexArrays(1, &VAO); VAO = 0; }
+        GLuint* buffers[] = { &VBO, &EBO, &instanceBuffer, &visibleBuffer, &commandBuffer, &commandTemplate };
+        for (GLuint* b : buffers)
+            if (*b) { glDeleteBuffers(1, b); *b = 0; }
+        if (depthTexture) { glDeleteTextures(1, &depthTexture); depthTexture = 0; }
+        if (hizTexture) { glDeleteTextures(1, &hizTexture); hizTexture = 0; }
+        hizValid = false;
+    }
+
+} // namespace gfx
@@ -0,0 +1,342 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "hot_reload.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+
+#include "asset_vfs.h"
+#include "material_library.h"
+#include "mesh.h"
+#include "shader_source.h"
+#include "shaderprogram.h"
+#include "texture_manager.h"
+#include "upload_thread.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace gfx {
+
+    namespace {
+        std::string normalize(const std::string& path)
+        {
+            return std::filesystem::path(path).lexically_normal().generic_string();
+        }
+
+        std::vector<std::string> normalized(const std::vector<std::string>& paths)
+        {
+            std::vector<std::string> out;
+            for (const std::string& path : paths)
+                out.push_back(normalize(path));
+            return out;
+        }
+
+        template <class T> bool isReady(const std::future<T>& future)
+        {
+            return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+    }
+
+    HotReload::HotReload(ThreadPool& pool)
+        : pool(pool)
+    {
+    }
+
+    HotReload::~HotReload()
+    {
+        stop();
+        for (Watch& watch : watches)
+            if (watch.loading.valid())
+                watch.loading.wait();
+    }
+
+#ifdef __linux__
+    bool HotReload::start(const std::vector<std::string>& directories)
+    {
+        stop();
+        notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (notifyFd < 0 || pipe(wakeFd) != 0) {
+            std::cerr << "Hot reload: inotify unavailable, files are not watched\n";
+            stop();
+            return false;
+        }
+
+        // Editors either rewrite a file in place (close after write) or write a
+        // temporary and rename it over the original (moved to)
+        const uint32_t events = IN_CLOSE_WRITE | IN_MOVED_TO;
+        for (const std::string& directory : directories) {
+            std::error_code ec;
+            std::vector<std::string> tree{ normalize(directory) };
+            for (std::filesystem::recursive_directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec))
+                if (it->is_directory(ec))
+                    tree.push_back(normalize(it->path().string()));
+            for (std::string& path : tree) {
+                if (!path.empty() && path.back() == '/')
+                    path.pop_back();
+                const int wd = inotify_add_watch(notifyFd, path.c_str(), events);
+                if (wd >= 0)
+                    directoryOf.emplace_back(wd, path);
+            }
+        }
+        if (directoryOf.empty()) {
+            std::cerr << "Hot reload: none of the directories could be watched\n";
+            stop();
+            return false;
+        }
+        watcher = std::thread([this] { watchThread_(); });
+        std::cout << "Hot reload: watching " << directoryOf.size() << " directories\n";
+        return true;
+    }
+
+    void HotReload::stop()
+    {
+        if (watcher.joinable()) {
+            const char wake = 1;
+            (void)!write(wakeFd[1], &wake, 1);
+            watcher.join();
+        }
+        for (int* fd : { &notifyFd, &wakeFd[0], &wakeFd[1] })
+            if (*fd >= 0) {
+                close(*fd);
+                *fd = -1;
+            }
+        directoryOf.clear();
+    }
+
+    void HotReload::watchThread_()
+    {
+        alignas(inotify_event) char buffer[4096];
+        pollfd fds[2] = { { notifyFd, POLLIN, 0 }, { wakeFd[0], POLLIN, 0 } };
+        std::set<std::string> batch;
+        for (;;) {
+            // Block until something happens; once a batch has started, keep collecting
+            // until the directory has been quiet briefly, so a save that touches a file
+            // several times (or several files) triggers one rebuild
+            const int ready = poll(fds, 2, batch.empty() ? -1 : 50);
+            if (ready < 0)
+                continue;
+            if (fds[1].revents & POLLIN)
+                return;
+            if (ready == 0) {
+                std::lock_guard<std::mutex> lock(mutex);
+                changed.insert(batch.begin(), batch.end());
+                batch.clear();
+                dirty.store(true, std::memory_order_release);
+                continue;
+            }
+
+            ssize_t length;
+            while ((length = read(notifyFd, buffer, sizeof(buffer))) > 0) {
+                for (char* p = buffer; p < buffer + length;) {
+                    const auto* event = reinterpret_cast<const inotify_event*>(p);
+                    p += sizeof(inotify_event) + event->len;
+                    if (event->len == 0)
+                        continue;
+                    for (const auto& [wd, directory] : directoryOf)
+                        if (wd == event->wd)
+                            batch.insert(directory + "/" + event->name);
+                }
+            }
+        }
+    }
+#else
+    bool HotReload::start(const std::vector<std::string>&)
+    {
+        std::cerr << "Hot reload needs inotify (Linux); files are not watched\n";
+        return false;
+    }
+
+    void HotReload::stop()
+    {
+    }
+
+    void HotReload::watchThread_()
+    {
+    }
+#endif
+
+    bool HotReload::running() const
+    {
+        return watcher.joinable();
+    }
+
+    void HotReload::watch(const std::string& name, const std::vector<std::string>& files, Rebuild rebuild)
+    {
+        Watch watch;
+        watch.name = name;
+        watch.files = normalized(files);
+        watch.rebuild = std::move(rebuild);
+        watches.push_back(std::move(watch));
+    }
+
+    void HotReload::update()
+    {
+        if (inFlight == 0 && !dirty.load(std::memory_order_acquire))
+            return;
+
+        if (dirty.exchange(false, std::memory_order_acquire)) {
+            std::set<std::string> files;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                files.swap(changed);
+            }
+            // The packs were built before the edit: read these from disk from now on
+            for (const std::string& file : files)
+                bypassAssetPack(file);
+            for (Watch& watch : watches) {
+                const bool touched = std::any_of(watch.files.begin(), watch.files.end(),
+                                                 [&](const std::string& file) { return files.count(file) != 0; });
+                if (!touched)
+                    continue;
+                if (watch.state == State::Idle)
+                    start_(watch);
+                else
+                    watch.again = true;
+            }
+        }
+
+        for (Watch& watch : watches) {
+            if (watch.state == State::Loading && isReady(watch.loading)) {
+                Rebuilt rebuilt = watch.loading.get();
+                if (!rebuilt.apply) {
+                    std::cerr << "Hot reload: " << watch.name << " failed, keeping the previous version\n";
+                    finish_(watch);
+                    continue;
+                }
+                if (!rebuilt.files.empty())
+                    watch.files = normalized(rebuilt.files);
+                watch.apply = std::move(rebuilt.apply);
+                watch.state = State::Applying;
+            }
+            if (watch.state == State::Applying && watch.apply())
+                finish_(watch);
+        }
+    }
+
+    void HotReload::start_(Watch& watch)
+    {
+        std::cout << "Hot reload: rebuilding " << watch.name << "\n";
+        watch.state = State::Loading;
+        watch.loading = pool.submit(watch.rebuild);
+        inFlight++;
+    }
+
+    void HotReload::finish_(Watch& watch)
+    {
+        watch.state = State::Idle;
+        watch.apply = {};
+        inFlight--;
+        if (watch.again) {
+            watch.again = false;
+            start_(watch);
+        }
+    }
+
+    void watchProgram(HotReload& reload, ShaderProgram& program, const std::string& name)
+    {
+        std::vector<std::string> files;
+        for (const auto& stage : program.stageFiles())
+            preprocessShader(stage.second, &files);
+
+        reload.watch(name, files, [&program, stageFiles = program.stageFiles(), separable = program.isSeparable()]() {
+            HotReload::Rebuilt rebuilt;
+            std::vector<ShaderProgram::Stage> stages;
+            for (const auto& [type, path] : stageFiles) {
+                std::string source = preprocessShader(path, &rebuilt.files);
+                if (source.empty())
+                    return HotReload::Rebuilt();
+                stages.push_back({ type, std::move(source) });
+            }
+            // Compile without blocking the frame, then swap once the driver is done
+            auto replacement = std::make_shared<std::unique_ptr<ShaderProgram>>();
+            rebuilt.apply = [&program, stages, separable, replacement]() {
+                if (!*replacement) {
+                    *replacement = std::make_unique<ShaderProgram>(stages, ShaderProgram::Deferred{}, separable);
+                    return false;
+                }
+                if (!(*replacement)->isReady())
+                    return false;
+                program.adopt(**replacement);
+                replacement->reset();
+                return true;
+            };
+            return rebuilt;
+        });
+    }
+
+    void watchMesh(HotReload& reload, Mesh& mesh, const std::string& path, UploadThread* uploads,
+                   const Mesh::LoadOptions& options)
+    {
+        reload.watch(path, { path }, [&mesh, path, uploads, options]() {
+            auto geometry = std::make_shared<Mesh::Geometry>(Mesh::parseOBJ(path, options));
+            HotReload::Rebuilt rebuilt;
+            if (geometry->vertices.empty() || geometry->indices.empty())
+                return rebuilt;
+            // With an upload thread the buffers are filled on its context and only the
+            // VAO is built here, once they have landed
+            struct Buffers {
+                GLuint vertex = 0, index = 0;
+                bool submitted = false, uploaded = false;
+            };
+            auto buffers = std::make_shared<Buffers>();
+            rebuilt.apply = [&mesh, geometry, uploads, buffers]() {
+                if (!buffers->submitted) {
+                    buffers->submitted = true;
+                    auto upload = [geometry, buffers] { Mesh::createBuffers(*geometry, buffers->vertex, buffers->index); };
+                    if (uploads && uploads->submit(upload, [buffers] { buffers->uploaded = true; }))
+                        return false;
+                    mesh.setGeometry(std::move(*geometry));
+                    return true;
+                }
+                if (!buffers->uploaded)
+                    return false;
+                mesh.setGeometry(std::move(*geometry), buffers->vertex, buffers->index);
+                return true;
+            };
+            return rebuilt;
+        });
+    }
+
+    void watchTexture(HotReload& reload, TextureManager& textures, GLuint texture, const std::string& name)
+    {
+        // The manager loads on the pool and streams the result in; the apply step
+        // only starts that and waits for the swap
+        reload.watch(name, textures.sources(texture), [&textures, texture]() {
+            auto state = std::make_shared<int>(0);     // 0 not started, 1 streaming, 2 done
+            HotReload::Rebuilt rebuilt;
+            rebuilt.apply = [&textures, texture, state]() {
+                if (*state == 0) {
+                    *state = 1;
+                    if (!textures.reload(texture, [state](GLuint) { *state = 2; }))
+                        *state = 2;
+                }
+                return *state == 2;
+            };
+            return rebuilt;
+        });
+    }
+
+    void watchMaterials(HotReload& reload, MaterialLibrary& materials, std::function<void()> onRebuilt)
+    {
+        reload.watch("materials", materials.mapFiles(), [&materials, onRebuilt]() {
+            HotReload::Rebuilt rebuilt;
+            if (!materials.load())
+                return rebuilt;
+            rebuilt.apply = [&materials, onRebuilt]() {
+                materials.build();
+                if (onRebuilt)
+                    onRebuilt();
+                return true;
+            };
+            return rebuilt;
+        });
+    }
+
+} // namespace gfx
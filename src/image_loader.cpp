@@ -0,0 +1,58 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "image_loader.h"
+#include <iostream>
+#include "stb_image.h"
+#include "asset_vfs.h"
+
+namespace gfx {
+
+    void Image::PixelDeleter::operator()(unsigned char* p) const
+    {
+        stbi_image_free(p);
+    }
+
+    Image loadImage(const std::string& path, bool flipVertical)
+    {
+        AssetData file = readAsset(path);
+        if (!file.valid()) {
+            std::cerr << "Failed to load image: " << path << " (can't open file)\n";
+            Image image;
+            image.path = path;
+            return image;
+        }
+        return decodeImage(file.data(), file.size(), flipVertical, path);
+    }
+
+    Image decodeImage(const unsigned char* bytes, size_t size, bool flipVertical, const std::string& name)
+    {
+        Image image;
+        image.path = name;
+
+        stbi_set_flip_vertically_on_load_thread(flipVertical ? 1 : 0);
+        image.pixels.reset(stbi_load_from_memory(bytes, static_cast<int>(size),
+                                                 &image.width, &image.height, &image.channels, 0));
+        if (!image.pixels) {
+            std::cerr << "Failed to decode image: " << name << " (" << stbi_failure_reason() << ")\n";
+            image.width = image.height = image.channels = 0;
+        }
+        return image;
+    }
+
+    std::future<Image> loadImageAsync(const std::string& path, bool flipVertical, ThreadPool& pool)
+    {
+        return pool.submit([path, flipVertical] { return loadImage(path, flipVertical); });
+    }
+
+    std::vector<Image> loadImages(const std::vector<std::string>& paths, bool flipVertical, ThreadPool& pool)
+    {
+        std::vector<Image> images(paths.size());
+        pool.parallelFor(0, paths.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                images[i] = loadImage(paths[i], flipVertical);
+        });
+        return images;
+    }
+
+} // namespace gfx
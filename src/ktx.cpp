@@ -0,0 +1,178 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "ktx.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace gfx {
+
+    namespace {
+        const uint8_t kIdentifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+        constexpr uint32_t kEndianness = 0x04030201;
+
+        struct Header {
+            uint32_t endianness;
+            uint32_t glType, glTypeSize, glFormat, glInternalFormat, glBaseInternalFormat;
+            uint32_t pixelWidth, pixelHeight, pixelDepth;
+            uint32_t numberOfArrayElements, numberOfFaces, numberOfMipmapLevels;
+            uint32_t bytesOfKeyValueData;
+        };
+
+        size_t pad4(size_t n) { return (n + 3) & ~size_t(3); }
+
+        uint32_t readU32(const uint8_t* p)
+        {
+            uint32_t v;
+            std::memcpy(&v, p, 4);
+            return v;
+        }
+
+        void writeU32(std::ostream& out, uint32_t v)
+        {
+            out.write(reinterpret_cast<const char*>(&v), 4);
+        }
+
+        void writePadding(std::ostream& out, size_t n)
+        {
+            static const char zeros[4] = {};
+            out.write(zeros, static_cast<std::streamsize>(n));
+        }
+    }
+
+    bool KtxTexture::load(const std::string& path)
+    {
+        images.clear();
+        sizes.clear();
+        keyValues.clear();
+        file = readAsset(path);
+        if (!file.valid()) {
+            std::cerr << "Failed to open KTX file: " << path << "\n";
+            return false;
+        }
+
+        const uint8_t* data = file.data();
+        const size_t size = file.size();
+        Header header{};
+        if (size < sizeof(kIdentifier) + sizeof(Header) || std::memcmp(data, kIdentifier, sizeof(kIdentifier)) != 0) {
+            std::cerr << "Not a KTX 1.1 file: " << path << "\n";
+            return false;
+        }
+        std::memcpy(&header, data + sizeof(kIdentifier), sizeof(Header));
+        if (header.endianness != kEndianness || header.pixelDepth > 1 || header.numberOfArrayElements > 0 ||
+            (header.numberOfFaces != 1 && header.numberOfFaces != 6)) {
+            std::cerr << "Unsupported KTX layout (byte order, 3D or array): " << path << "\n";
+            return false;
+        }
+
+        glType = header.glType;
+        glFormat = header.glFormat;
+        glInternalFormat = header.glInternalFormat;
+        pixelWidth = static_cast<int>(header.pixelWidth);
+        pixelHeight = static_cast<int>(std::max(1u, header.pixelHeight));
+        faceCount = static_cast<int>(header.numberOfFaces);
+        levelCount = static_cast<int>(std::max(1u, header.numberOfMipmapLevels));
+
+        size_t offset = sizeof(kIdentifier) + sizeof(Header);
+        const size_t keyValueEnd = offset + header.bytesOfKeyValueData;
+        while (offset + 4 <= keyValueEnd && keyValueEnd <= size) {
+            uint32_t length = readU32(data + offset);
+            const char* entry = reinterpret_cast<const char*>(data + offset + 4);
+            if (offset + 4 + length > keyValueEnd) break;
+            size_t keyLength = strnlen(entry, length);
+            std::string key(entry, keyLength);
+            std::string value = keyLength < length ? std::string(entry + keyLength + 1, length - keyLength - 1) : "";
+            while (!value.empty() && value.back() == '\0') value.pop_back();
+            keyValues.emplace_back(key, value);
+            offset += pad4(4 + length);
+        }
+        offset = keyValueEnd;
+
+        for (int level = 0; level < levelCount; ++level) {
+            if (offset + 4 > size) break;
+            size_t imageSize = readU32(data + offset);
+            offset += 4;
+            for (int face = 0; face < faceCount; ++face) {
+                if (offset + imageSize > size) break;
+                images.push_back(data + offset);
+                offset += pad4(imageSize);
+            }
+            sizes.push_back(imageSize);
+        }
+        if (images.size() != static_cast<size_t>(levelCount * faceCount)) {
+            std::cerr << "Truncated KTX file: " << path << "\n";
+            images.clear();
+            return false;
+        }
+        return true;
+    }
+
+    const uint8_t* KtxTexture::imageData(int level, int face) const
+    {
+        return images[static_cast<size_t>(level) * faceCount + face];
+    }
+
+    size_t KtxTexture::imageSize(int level) const
+    {
+        return sizes[level];
+    }
+
+    std::string KtxTexture::value(const std::string& key) const
+    {
+        for (const auto& kv : keyValues)
+            if (kv.first == key) return kv.second;
+        return {};
+    }
+
+    bool writeKtx(const std::string& path, const KtxSource& source)
+    {
+        if (source.images.empty() || source.images.size() % source.faces != 0)
+            return false;
+        std::ofstream out(path, std::ios::binary);
+        if (!out) {
+            std::cerr << "Failed to write KTX file: " << path << "\n";
+            return false;
+        }
+
+        uint32_t keyValueBytes = 0;
+        for (const auto& kv : source.keyValues)
+            keyValueBytes += static_cast<uint32_t>(pad4(4 + kv.first.size() + 1 + kv.second.size() + 1));
+
+        out.write(reinterpret_cast<const char*>(kIdentifier), sizeof(kIdentifier));
+        Header header{};
+        header.endianness = kEndianness;
+        header.glType = source.type;
+        header.glTypeSize = source.type == GL_UNSIGNED_BYTE || source.type == 0 ? 1 : 4;
+        header.glFormat = source.format;
+        header.glInternalFormat = source.internalFormat;
+        header.glBaseInternalFormat = source.baseInternalFormat;
+        header.pixelWidth = static_cast<uint32_t>(source.width);
+        header.pixelHeight = static_cast<uint32_t>(source.height);
+        header.numberOfFaces = static_cast<uint32_t>(source.faces);
+        header.numberOfMipmapLevels = static_cast<uint32_t>(source.images.size() / source.faces);
+        header.bytesOfKeyValueData = keyValueBytes;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        for (const auto& kv : source.keyValues) {
+            size_t length = kv.first.size() + 1 + kv.second.size() + 1;
+            writeU32(out, static_cast<uint32_t>(length));
+            out.write(kv.first.c_str(), static_cast<std::streamsize>(kv.first.size() + 1));
+            out.write(kv.second.c_str(), static_cast<std::streamsize>(kv.second.size() + 1));
+            writePadding(out, pad4(length) - length);
+        }
+
+        for (size_t level = 0; level < header.numberOfMipmapLevels; ++level) {
+            const auto& first = source.images[level * source.faces];
+            writeU32(out, static_cast<uint32_t>(first.size()));
+            for (int face = 0; face < source.faces; ++face) {
+                const auto& image = source.images[level * source.faces + face];
+                out.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+                writePadding(out, pad4(image.size()) - image.size());
+            }
+        }
+        return static_cast<bool>(out);
+    }
+
+} // namespace gfx
@@ -0,0 +1,197 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "light_assignment.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace gfx {
+
+    namespace {
+        float brightest(const glm::vec3& a, const glm::vec3& b)
+        {
+            glm::vec3 m = glm::max(a, b);
+            return std::max(m.x, std::max(m.y, m.z));
+        }
+
+        float attenuation(float constant, float linear, float quadratic, float d)
+        {
+            return 1.0f / (constant + linear * d + quadratic * d * d);
+        }
+
+        // Sphere vs. cone (apex, unit axis, range, half-angle). Conservative.
+        bool sphereTouchesCone(const BoundingSphere& s, const glm::vec3& apex, const glm::vec3& axis,
+                               float range, float cosAngle, float sinAngle)
+        {
+            glm::vec3 v = s.center - apex;
+            float lenSq   = glm::dot(v, v);
+            float along   = glm::dot(v, axis);
+            float across  = std::sqrt(std::max(lenSq - along * along, 0.0f));
+            float outside = cosAngle * across - along * sinAngle;
+            if (outside > s.radius) return false;           // beside the cone
+            if (along > s.radius + range) return false;     // past its range
+            if (along < -s.radius) return false;            // behind the apex
+            return true;
+        }
+
+        void rank(std::vector<std::pair<float, int>>& candidates, int* out, int& count)
+        {
+            int keep = std::min(static_cast<int>(candidates.size()), kMaxLightsPerObject);
+            std::partial_sort(candidates.begin(), candidates.begin() + keep, candidates.end(),
+                              [](const auto& a, const auto& b) { return a.first > b.first; });
+            for (int i = 0; i < keep; ++i)
+                out[i] = candidates[i].second;
+            count = keep;
+        }
+
+        // Packs up to kMaxLightsPerObject indices into 8-bit slots; returns the count packed
+        unsigned packSlots(const int* indices, int count, unsigned& slots)
+        {
+            assert(count >= 0 && count <= kMaxLightsPerObject);
+            unsigned packed = 0;
+            for (int i = 0; i < std::min(count, kMaxLightsPerObject); ++i) {
+                assert(indices[i] >= 0 && indices[i] <= kMaxPackedLightIndex);
+                if (indices[i] < 0 || indices[i] > kMaxPackedLightIndex)
+                    continue;
+                slots |= static_cast<unsigned>(indices[i]) << (8 * packed++);
+            }
+            return packed;
+        }
+    }
+
+    float attenuationRange(float constant, float linear, float quadratic, float intensity, float cutoff)
+    {
+        // Solve quadratic*d^2 + linear*d + constant = intensity / cutoff for d
+        float target = intensity / cutoff;
+        if (constant >= target) return 0.0f;
+        if (quadratic <= 0.0f) {
+            if (linear <= 0.0f) return std::numeric_limits<float>::max();
+            return (target - constant) / linear;
+        }
+        float disc = linear * linear - 4.0f * quadratic * (constant - target);
+        return (-linear + std::sqrt(disc)) / (2.0f * quadratic);
+    }
+
+    float pointLightRange(const PointLightConfig& L, float cutoff)
+    {
+        return attenuationRange(L.constant, L.linear, L.quadratic,
+                                brightest(L.diffuse, L.specular), cutoff);
+    }
+
+    float spotLightRange(const SpotLightConfig& L, float cutoff)
+    {
+        return attenuationRange(L.constant, L.linear, L.quadratic,
+                                brightest(L.diffuse, L.specular), cutoff);
+    }
+
+    BoundingSphere spotLightBounds(const SpotLightConfig& L, float cutoff)
+    {
+        float range    = spotLightRange(L, cutoff);
+        float cosAngle = glm::clamp(L.outerCutOff, -1.0f, 1.0f);
+        float sinAngle = std::sqrt(1.0f - cosAngle * cosAngle);
+        glm::vec3 dir  = glm::normalize(L.direction);
+
+        BoundingSphere s;
+        if (cosAngle < 0.70710678f) {
+            // Wide cone: the sphere through the cap's rim
+            s.center = L.position + dir * (range * cosAngle);
+            s.radius = range * sinAngle;
+        } else {
+            // Narrow cone: the sphere through the apex and the rim
+            s.radius = range / (2.0f * cosAngle);
+            s.center = L.position + dir * s.radius;
+        }
+        return s;
+    }
+
+    glm::uvec3 ObjectLights::packed() const
+    {
+        glm::uvec3 p(0u);
+        const unsigned points = packSlots(point, pointCount, p.x);
+        const unsigned spots  = packSlots(spot, spotCount, p.y);
+        p.z = points | spots << 8;
+        return p;
+    }
+
+    LightAssigner::LightAssigner(float cutoff)
+        : cutoff(cutoff) {}
+
+    void LightAssigner::setLights(const SceneConfig& cfg)
+    {
+        // Only lights the shader has (gfx::LightBuffer logs the rest)
+        points.clear();
+        for (const auto& L : cfg.pointLights) {
+            if (points.size() == static_cast<size_t>(kMaxPointLights))
+                break;
+            PointVolume v;
+            v.position  = L.position;
+            v.range     = pointLightRange(L, cutoff);
+            v.intensity = brightest(L.diffuse, L.specular);
+            v.constant  = L.constant;
+            v.linear    = L.linear;
+            v.quadratic = L.quadratic;
+            points.push_back(v);
+        }
+
+        spots.clear();
+        for (const auto& L : cfg.spotLights) {
+            if (spots.size() == static_cast<size_t>(kMaxSpotLights))
+                break;
+            SpotVolume v;
+            v.position  = L.position;
+            v.direction = glm::normalize(L.direction);
+            v.range     = spotLightRange(L, cutoff);
+            v.intensity = brightest(L.diffuse, L.specular);
+            v.constant  = L.constant;
+            v.linear    = L.linear;
+            v.quadratic = L.quadratic;
+            v.cosOuter  = glm::clamp(L.outerCutOff, -1.0f, 1.0f);
+            v.sinOuter  = std::sqrt(1.0f - v.cosOuter * v.cosOuter);
+            v.bounds    = spotLightBounds(L, cutoff);
+            spots.push_back(v);
+        }
+    }
+
+    ObjectLights LightAssigner::assign(const AABB& objectBounds) const
+    {
+        ObjectLights out;
+        BoundingSphere sphere { objectBounds.center(), glm::length(objectBounds.extents()) };
+        std::vector<std::pair<float, int>> candidates;
+
+        // Significance: contribution at the object's closest point
+        for (size_t i = 0; i < points.size(); ++i) {
+            const PointVolume& v = points[i];
+            glm::vec3 closest = glm::clamp(v.position, objectBounds.min, objectBounds.max);
+            float d = glm::length(closest - v.position);
+            if (d > v.range) continue;
+            candidates.emplace_back(v.intensity * attenuation(v.constant, v.linear, v.quadratic, d),
+                                    static_cast<int>(i));
+        }
+        rank(candidates, out.point, out.pointCount);
+
+        candidates.clear();
+        for (size_t i = 0; i < spots.size(); ++i) {
+            const SpotVolume& v = spots[i];
+            float reach = glm::length(sphere.center - v.bounds.center);
+            if (reach > sphere.radius + v.bounds.radius) continue;
+            if (!sphereTouchesCone(sphere, v.position, v.direction, v.range, v.cosOuter, v.sinOuter)) continue;
+            glm::vec3 closest = glm::clamp(v.position, objectBounds.min, objectBounds.max);
+            float d = glm::length(closest - v.position);
+            candidates.emplace_back(v.intensity * attenuation(v.constant, v.linear, v.quadratic, d),
+                                    static_cast<int>(i));
+        }
+        rank(candidates, out.spot, out.spotCount);
+
+        return out;
+    }
+
+    void LightAssigner::assign(const std::vector<AABB>& objectBounds, std::vector<ObjectLights>& out) const
+    {
+        out.resize(objectBounds.size());
+        for (size_t i = 0; i < objectBounds.size(); ++i)
+            out[i] = assign(objectBounds[i]);
+    }
+
+} // namespace gfx
@@ -0,0 +1,151 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "light_buffer.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+namespace gfx {
+
+    namespace {
+        // std140 images of PointLight / SpotLight (lighting.glsl) as array elements
+        struct PointLightStd140 {
+            glm::vec3 position;
+            float constant;
+            float linear;
+            float quadratic;
+            float pad0[2];
+            glm::vec3 diffuse;
+            float pad1;
+            glm::vec3 specular;
+            float pad2;
+        };
+        static_assert(offsetof(PointLightStd140, diffuse) == 32 && offsetof(PointLightStd140, specular) == 48 &&
+                      sizeof(PointLightStd140) == 64, "PointLight std140 layout");
+
+        struct SpotLightStd140 {
+            glm::vec3 position;
+            float pad0;
+            glm::vec3 direction;
+            float cutOff;
+            float outerCutOff;
+            float constant;
+            float linear;
+            float quadratic;
+            glm::vec3 diffuse;
+            float pad1;
+            glm::vec3 specular;
+            float pad2;
+        };
+        static_assert(offsetof(SpotLightStd140, direction) == 16 && offsetof(SpotLightStd140, diffuse) == 48 &&
+                      offsetof(SpotLightStd140, specular) == 64 && sizeof(SpotLightStd140) == 80,
+                      "SpotLight std140 layout");
+
+        // Each block is the light count (padded to a vec4) followed by the array
+        constexpr size_t kHeaderSize = 16;
+        constexpr size_t kPointBlockSize = kHeaderSize + kMaxPointLights * sizeof(PointLightStd140);
+        constexpr size_t kSpotBlockSize  = kHeaderSize + kMaxSpotLights * sizeof(SpotLightStd140);
+        // The smallest GL_MAX_UNIFORM_BLOCK_SIZE any implementation may report
+        static_assert(kPointBlockSize <= 16384 && kSpotBlockSize <= 16384, "light blocks exceed 16 KB");
+
+        template <class T> void upload(GLuint buffer, const std::vector<T>& lights)
+        {
+            std::vector<uint8_t> bytes(kHeaderSize + lights.size() * sizeof(T));
+            const int32_t count = static_cast<int32_t>(lights.size());
+            std::copy_n(reinterpret_cast<const uint8_t*>(&count), sizeof(count), bytes.begin());
+            if (!lights.empty())
+                std::copy_n(reinterpret_cast<const uint8_t*>(lights.data()), lights.size() * sizeof(T),
+                            bytes.begin() + kHeaderSize);
+            glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, static_cast<GLsizeiptr>(bytes.size()), bytes.data());
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        }
+    }
+
+    LightBuffer::~LightBuffer()
+    {
+        cleanup();
+    }
+
+    void LightBuffer::create_()
+    {
+        if (pointBuffer)
+            return;
+        // Allocated at full capacity: a block must be backed by its whole declared size
+        glGenBuffers(1, &pointBuffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, pointBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, kPointBlockSize, nullptr, GL_DYNAMIC_DRAW);
+        glGenBuffers(1, &spotBuffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, spotBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, kSpotBlockSize, nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, kPointLightBinding, pointBuffer);
+        glBindBufferBase(GL_UNIFORM_BUFFER, kSpotLightBinding, spotBuffer);
+    }
+
+    void LightBuffer::setPointLights(const std::vector<PointLightConfig>& lights)
+    {
+        create_();
+        const size_t n = std::min<size_t>(lights.size(), kMaxPointLights);
+        if (n < lights.size() && !warnedPoints) {
+            warnedPoints = true;
+            std::cerr << "Light buffer: " << lights.size() << " point lights, only the first "
+                      << kMaxPointLights << " are lit\n";
+        }
+        std::vector<PointLightStd140> packed(n);
+        for (size_t i = 0; i < n; ++i) {
+            const PointLightConfig& L = lights[i];
+            PointLightStd140& p = packed[i];
+            p = PointLightStd140{};
+            p.position  = L.position;
+            p.constant  = L.constant;
+            p.linear    = L.linear;
+            p.quadratic = L.quadratic;
+            p.diffuse   = L.diffuse;
+            p.specular  = L.specular;
+        }
+        upload(pointBuffer, packed);
+    }
+
+    void LightBuffer::setSpotLights(const std::vector<SpotLightConfig>& lights)
+    {
+        create_();
+        const size_t n = std::min<size_t>(lights.size(), kMaxSpotLights);
+        if (n < lights.size() && !warnedSpots) {
+            warnedSpots = true;
+            std::cerr << "Light buffer: " << lights.size() << " spot lights, only the first "
+                      << kMaxSpotLights << " are lit\n";
+        }
+        std::vector<SpotLightStd140> packed(n);
+        for (size_t i = 0; i < n; ++i) {
+            const SpotLightConfig& L = lights[i];
+            SpotLightStd140& s = packed[i];
+            s = SpotLightStd140{};
+            s.position    = L.position;
+            s.direction   = L.direction;
+            s.cutOff      = L.cutOff;
+            s.outerCutOff = L.outerCutOff;
+            s.constant    = L.constant;
+            s.linear      = L.linear;
+            s.quadratic   = L.quadratic;
+            s.diffuse     = L.diffuse;
+            s.specular    = L.specular;
+        }
+        upload(spotBuffer, packed);
+    }
+
+    void LightBuffer::attach(const ShaderProgram& program)
+    {
+        program.bindUniformBlock("PointLights", kPointLightBinding);
+        program.bindUniformBlock("SpotLights", kSpotLightBinding);
+    }
+
+    void LightBuffer::cleanup()
+    {
+        if (pointBuffer) { glDeleteBuffers(1, &pointBuffer); pointBuffer = 0; }
+        if (spotBuffer) { glDeleteBuffers(1, &spotBuffer); spotBuffer = 0; }
+    }
+
+} // namespace gfx
@@ -0,0 +1,153 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "lz4_block.h"
+#include <cstring>
+
+namespace gfx {
+
+    namespace {
+        constexpr size_t kMinMatch = 4;
+        constexpr size_t kLastLiterals = 5;     // the block must end in at least this many literals
+        constexpr size_t kMatchLimit = 12;      // and no match may start closer to the end than this
+        constexpr size_t kMaxOffset = 65535;
+        constexpr int kHashBits = 16;
+
+        uint32_t read32(const uint8_t* p)
+        {
+            uint32_t v;
+            std::memcpy(&v, p, 4);
+            return v;
+        }
+
+        size_t hash4(uint32_t sequence)
+        {
+            return (sequence * 2654435761u) >> (32 - kHashBits);
+        }
+
+        void writeLength(std::vector<uint8_t>& out, size_t length)
+        {
+            for (; length >= 255; length -= 255)
+                out.push_back(255);
+            out.push_back(static_cast<uint8_t>(length));
+        }
+
+        void writeSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalCount,
+                           size_t offset, size_t matchLength)
+        {
+            const size_t matchCode = matchLength - kMinMatch;
+            out.push_back(static_cast<uint8_t>((literalCount < 15 ? literalCount : 15) << 4 |
+                                               (matchCode < 15 ? matchCode : 15)));
+            if (literalCount >= 15)
+                writeLength(out, literalCount - 15);
+            out.insert(out.end(), literals, literals + literalCount);
+            out.push_back(static_cast<uint8_t>(offset));
+            out.push_back(static_cast<uint8_t>(offset >> 8));
+            if (matchCode >= 15)
+                writeLength(out, matchCode - 15);
+        }
+
+        bool readLength(const uint8_t* data, size_t dataSize, size_t& in, size_t& length)
+        {
+            uint8_t byte;
+            do {
+                if (in >= dataSize)
+                    return false;
+                byte = data[in++];
+                length += byte;
+            } while (byte == 255);
+            return true;
+        }
+    }
+
+    std::vector<uint8_t> lz4Compress(const uint8_t* data, size_t size)
+    {
+        std::vector<uint8_t> out;
+        out.reserve(size + size / 255 + 16);
+
+        // Position + 1 of the last occurrence of each hashed 4-byte sequence; 0 is empty
+        std::vector<size_t> table(size_t(1) << kHashBits, 0);
+        size_t anchor = 0, i = 0;
+        if (size > kMatchLimit) {
+            const size_t matchLimit = size - kMatchLimit;
+            const size_t matchEnd = size - kLastLiterals;
+            while (i < matchLimit) {
+                const uint32_t sequence = read32(data + i);
+                size_t& slot = table[hash4(sequence)];
+                const size_t candidate = slot;
+                slot = i + 1;
+                if (candidate == 0 || i - (candidate - 1) > kMaxOffset || read32(data + candidate - 1) != sequence) {
+                    ++i;
+                    continue;
+                }
+
+                size_t match = candidate - 1;
+                size_t length = kMinMatch;
+                while (i + length < matchEnd && data[match + length] == data[i + length])
+                    ++length;
+                while (i > anchor && match > 0 && data[i - 1] == data[match - 1]) {
+                    --i;
+                    --match;
+                    ++length;
+                }
+                writeSequence(out, data + anchor, i - anchor, i - match, length);
+                i += length;
+                anchor = i;
+            }
+        }
+
+        const size_t literalCount = size - anchor;
+        out.push_back(static_cast<uint8_t>((literalCount < 15 ? literalCount : 15) << 4));
+        if (literalCount >= 15)
+            writeLength(out, literalCount - 15);
+        out.insert(out.end(), data + anchor, data + size);
+        return out;
+    }
+
+    uint64_t lz4MaxDecodedSize(uint64_t dataSize)
+    {
+        return dataSize * 255 + 16;
+    }
+
+    bool lz4Decompress(const uint8_t* data, size_t dataSize, uint8_t* out, size_t size)
+    {
+        size_t in = 0, written = 0;
+        while (in < dataSize) {
+            const uint8_t token = data[in++];
+
+            size_t literalCount = token >> 4;
+            if (literalCount == 15 && !readLength(data, dataSize, in, literalCount))
+                return false;
+            if (literalCount > dataSize - in || literalCount > size - written)
+                return false;
+            if (literalCount > 0)
+                std::memcpy(out + written, data + in, literalCount);
+            in += literalCount;
+            written += literalCount;
+            if (in == dataSize)
+                break;      // the last sequence has no match
+
+            if (dataSize - in < 2)
+                return false;
+            const size_t offset = data[in] | static_cast<size_t>(data[in + 1]) << 8;
+            in += 2;
+            size_t length = (token & 15) + kMinMatch;
+            if ((token & 15) == 15 && !readLength(data, dataSize, in, length))
+                return false;
+            if (offset == 0 || offset > written || length > size - written)
+                return false;
+
+            const uint8_t* source = out + written - offset;
+            if (offset >= length) {
+                std::memcpy(out + written, source, length);
+            } else {
+                // Overlapping match: a run that repeats the last `offset` bytes
+                for (size_t k = 0; k < length; ++k)
+                    out[written + k] = source[k];
+            }
+            written += length;
+        }
+        return written == size;
+    }
+
+} // namespace gfx
@@ -0,0 +1,96 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "mapped_file.h"
+#include <fstream>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GFX_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace gfx {
+
+    MappedFile::MappedFile(const std::string& path)
+    {
+        open(path);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other) {
+            close();
+            bytes = other.bytes;
+            length = other.length;
+            mapped = other.mapped;
+            fallback = std::move(other.fallback);
+            if (!mapped && !fallback.empty())
+                bytes = fallback.data();
+            other.bytes = nullptr;
+            other.length = 0;
+            other.mapped = false;
+        }
+        return *this;
+    }
+
+    bool MappedFile::open(const std::string& path)
+    {
+        close();
+#ifdef GFX_HAS_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat info{};
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (view != MAP_FAILED) {
+                bytes = static_cast<const uint8_t*>(view);
+                length = static_cast<size_t>(info.st_size);
+                mapped = true;
+            }
+        }
+        ::close(fd);
+        if (mapped)
+            return true;
+#endif
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in)
+            return false;
+        fallback.resize(static_cast<size_t>(in.tellg()));
+        in.seekg(0);
+        if (fallback.empty() || !in.read(reinterpret_cast<char*>(fallback.data()), static_cast<std::streamsize>(fallback.size()))) {
+            fallback.clear();
+            return false;
+        }
+        bytes = fallback.data();
+        length = fallback.size();
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+#ifdef GFX_HAS_MMAP
+        if (mapped)
+            munmap(const_cast<uint8_t*>(bytes), length);
+#endif
+        fallback.clear();
+        bytes = nullptr;
+        length = 0;
+        mapped = false;
+    }
+
+} // namespace gfx
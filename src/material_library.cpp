@@ -0,0 +1,566 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "material_library.h"
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <ostream>
+#include <tuple>
+#include <unordered_map>
+
+#include "image_loader.h"
+#include "ktx.h"
+#include "mipmap.h"
+#include "texture_compress.h"
+#include "texture_residency.h"
+#include "texture_streamer.h"
+
+namespace gfx {
+
+    namespace {
+        // One material map as GL wants it: every level, tightly described
+        struct MapLevel {
+            int width = 0;
+            int height = 0;
+            size_t size = 0;
+            const uint8_t* data = nullptr;
+        };
+
+        struct MapData {
+            GLenum internalFormat = 0;
+            GLenum format = 0;
+            GLenum type = 0;            // 0 = compressed
+            GLint alignment = 1;
+            std::vector<MapLevel> levels;
+            std::shared_ptr<void> owner;
+
+            bool valid() const { return !levels.empty(); }
+            int width() const { return levels[0].width; }
+            int height() const { return levels[0].height; }
+        };
+
+        bool singleChannel(GLenum internalFormat)
+        {
+            return internalFormat == GL_R8 || internalFormat == GL_COMPRESSED_RED_RGTC1;
+        }
+
+        // Gray maps become R8 and everything else RGBA8, so same-sized images share
+        // a page however their files happened to be saved. The mip chain is built
+        // here (sRGB-correct for color) rather than by glGenerateMipmap.
+        MapData mapFromImage(const Image& image, ThreadPool& pool)
+        {
+            MapData map;
+            if (!image.valid())
+                return map;
+            map.type = GL_UNSIGNED_BYTE;
+            const bool srgb = prefersSrgbMips(image);
+            auto chain = std::make_shared<std::vector<MipLevel>>(buildMipChain(image, srgb, pool));
+            if (!srgb && chooseBlockFormat(image) == BlockFormat::BC4) {
+                // Keep red only, in place: level sizes shrink to a quarter
+                for (MipLevel& level : *chain) {
+                    const size_t count = static_cast<size_t>(level.width) * level.height;
+                    for (size_t i = 0; i < count; ++i)
+                        level.rgba[i] = level.rgba[i * 4];
+                    level.rgba.resize(count);
+                }
+                map.internalFormat = GL_R8;
+                map.format = GL_RED;
+            } else {
+                map.internalFormat = GL_RGBA8;
+                map.format = GL_RGBA;
+            }
+            for (const MipLevel& level : *chain)
+                map.levels.push_back({ level.width, level.height, level.rgba.size(), level.rgba.data() });
+            map.owner = chain;
+            return map;
+        }
+
+        MapData mapFromCompressed(CompressedTexture texture)
+        {
+            MapData map;
+            if (!texture.valid())
+                return map;
+            auto owner = std::make_shared<CompressedTexture>(std::move(texture));
+            map.internalFormat = owner->glFormat();
+            for (const auto& level : owner->levels)
+                map.levels.push_back({ level.width, level.height, level.size, owner->data.data() + level.offset });
+            map.owner = owner;
+            return map;
+        }
+
+        MapData mapFromKtx(const std::string& path)
+        {
+            MapData map;
+            auto owner = std::make_shared<KtxTexture>();
+            if (!owner->load(path))
+                return map;
+            if (owner->isCube()) {
+                std::cerr << "Material map is a cube map: " << path << "\n";
+                return map;
+            }
+            map.internalFormat = owner->internalFormat();
+            map.format = owner->format();
+            map.type = owner->type();
+            map.alignment = 4;   // KTX rows are 4-byte aligned
+            for (int level = 0; level < owner->levels(); ++level)
+                map.levels.push_back({ std::max(1, owner->width() >> level), std::max(1, owner->height() >> level),
+                                       owner->imageSize(level), owner->imageData(level, 0) });
+            map.owner = owner;
+            return map;
+        }
+
+        // Same shape as `like`, all zero: black in R8 and in BC4 (both endpoints 0)
+        MapData blankMap(const MapData& like)
+        {
+            MapData map;
+            const bool compressed = like.type == 0;
+            map.internalFormat = compressed ? GL_COMPRESSED_RED_RGTC1 : GL_R8;
+            map.format = GL_RED;
+            map.type = compressed ? 0 : GL_UNSIGNED_BYTE;
+            size_t total = 0;
+            for (const MapLevel& level : like.levels) {
+                size_t size = compressed ? static_cast<size_t>((level.width + 3) / 4) * ((level.height + 3) / 4) * 8
+                                         : static_cast<size_t>(level.width) * level.height;
+                map.levels.push_back({ level.width, level.height, size, nullptr });
+                total += size;
+            }
+            auto zeros = std::make_shared<std::vector<uint8_t>>(total, 0);
+            size_t offset = 0;
+            for (MapLevel& level : map.levels) {
+                level.data = zeros->data() + offset;
+                offset += level.size;
+            }
+            map.owner = zeros;
+            return map;
+        }
+
+        MapData whiteMap()
+        {
+            auto pixels = std::make_shared<std::vector<uint8_t>>(4 * 4 * 4, 255);
+            MapData map;
+            map.internalFormat = GL_RGBA8;
+            map.format = GL_RGBA;
+            map.type = GL_UNSIGNED_BYTE;
+            map.levels.push_back({ 4, 4, pixels->size(), pixels->data() });
+            map.owner = pixels;
+            return map;
+        }
+
+        bool sameShape(const MapData& a, const MapData& b)
+        {
+            return a.width() == b.width() && a.height() == b.height() && a.levels.size() == b.levels.size();
+        }
+
+        // Same shape and format as `like`, every byte `value`: 0 is black in every
+        // format used here, 0xFF is white in the uncompressed ones (the whiteMap fallback)
+        MapData filledMap(const MapData& like, uint8_t value)
+        {
+            MapData map = like;
+            size_t total = 0;
+            for (const MapLevel& level : like.levels)
+                total += level.size;
+            auto bytes = std::make_shared<std::vector<uint8_t>>(total, value);
+            size_t offset = 0;
+            for (MapLevel& level : map.levels) {
+                level.data = bytes->data() + offset;
+                offset += level.size;
+            }
+            map.owner = bytes;
+            return map;
+        }
+
+        // Levels and formats only; the pixels are dropped
+        MapData shapeOf(const MapData& map)
+        {
+            MapData shape = map;
+            for (MapLevel& level : shape.levels)
+                level.data = nullptr;
+            shape.owner.reset();
+            return shape;
+        }
+
+        MapData loadMap(const std::string& path, bool compressed, const std::string& cacheDir, ThreadPool& pool)
+        {
+            if (isKtxPath(path))
+                return mapFromKtx(path);
+            if (compressed)
+                return mapFromCompressed(loadCompressedTexture(path, false, cacheDir, pool));
+            return mapFromImage(loadImage(path, false), pool);
+        }
+
+        // Levels [first, last] of every layer of one array, for the streamer. Runs on
+        // a worker; an empty source means a layer's file changed shape since build().
+        // Layers without a file were synthesised by build() and are refilled with `blank`.
+        StreamSource arraySource(const std::vector<std::string>& layers, const MapData& shape, uint8_t blank,
+                                 int first, int last, bool compressed, const std::string& cacheDir, ThreadPool& pool)
+        {
+            StreamSource source;
+            auto maps = std::make_shared<std::vector<MapData>>(layers.size());
+            for (size_t i = 0; i < layers.size(); ++i) {
+                MapData& map = (*maps)[i];
+                map = layers[i].empty() ? filledMap(shape, blank) : loadMap(layers[i], compressed, cacheDir, pool);
+                if (!map.valid() || map.internalFormat != shape.internalFormat || !sameShape(map, shape)) {
+                    std::cerr << "Material map changed since the library was built: " << layers[i] << "\n";
+                    return StreamSource();
+                }
+                for (int level = first; level <= last; ++level) {
+                    const MapLevel& l = map.levels[level];
+                    StreamUpload upload;
+                    upload.target = GL_TEXTURE_2D_ARRAY;
+                    upload.level = level;
+                    upload.layer = static_cast<int>(i);
+                    upload.width = l.width;
+                    upload.height = l.height;
+                    upload.internalFormat = static_cast<GLint>(map.internalFormat);
+                    upload.format = map.format;
+                    upload.type = map.type;
+                    upload.rowHeight = map.type == 0 ? 4 : 1;
+                    upload.alignment = map.alignment;
+                    upload.rowBytes = l.size / static_cast<size_t>((l.height + upload.rowHeight - 1) / upload.rowHeight);
+                    upload.data = l.data;
+                    source.uploads.push_back(upload);
+                    source.bytes += l.size;
+                }
+            }
+            source.owner = maps;
+            source.layers = static_cast<int>(layers.size());
+            source.keepLevels = true;
+            return source;
+        }
+
+        int trackArray(TextureResidency& residency, GLuint texture, const MapData& map, std::vector<std::string> layers,
+                       uint8_t blank, int tail, bool compressed, const std::string& cacheDir, ThreadPool& pool)
+        {
+            ResidencyDesc desc;
+            desc.texture = texture;
+            desc.target = GL_TEXTURE_2D_ARRAY;
+            desc.internalFormat = map.internalFormat;
+            desc.format = map.format;
+            desc.type = map.type;
+            desc.width = map.width();
+            desc.height = map.height();
+            desc.layers = static_cast<int>(layers.size());
+            for (const MapLevel& level : map.levels)
+                desc.levelBytes.push_back(level.size * layers.size());
+            desc.residentBase = tail;
+            MapData shape = shapeOf(map);
+            ThreadPool* workers = &pool;
+            desc.load = [shape, layers, blank, compressed, cacheDir, workers](int first, int last) {
+                return arraySource(layers, shape, blank, first, last, compressed, cacheDir, *workers);
+            };
+            return residency.track(std::move(desc));
+        }
+
+        // Allocates levels [firstLevel, last] of a `layers`-deep array shaped like `map`
+        GLuint createArray(const MapData& map, int layers, int firstLevel)
+        {
+            GLuint texture = 0;
+            glGenTextures(1, &texture);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+            for (size_t i = static_cast<size_t>(firstLevel); i < map.levels.size(); ++i) {
+                const MapLevel& level = map.levels[i];
+                if (map.type == 0)
+                    glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(i), map.internalFormat,
+                                           level.width, level.height, layers, 0,
+                                           static_cast<GLsizei>(level.size * layers), nullptr);
+                else
+                    glTexImage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(i), static_cast<GLint>(map.internalFormat),
+                                 level.width, level.height, layers, 0, map.format, map.type, nullptr);
+            }
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, firstLevel);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(map.levels.size()) - 1);
+            if (singleChannel(map.internalFormat)) {
+                glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_SWIZZLE_G, GL_RED);
+                glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_SWIZZLE_B, GL_RED);
+            }
+            return texture;
+        }
+
+        size_t uploadLayer(const MapData& map, int layer, int firstLevel)
+        {
+            size_t bytes = 0;
+            glPixelStorei(GL_UNPACK_ALIGNMENT, map.alignment);
+            for (size_t i = static_cast<size_t>(firstLevel); i < map.levels.size(); ++i) {
+                const MapLevel& level = map.levels[i];
+                if (map.type == 0)
+                    glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(i), 0, 0, layer,
+                                              level.width, level.height, 1, map.internalFormat,
+                                              static_cast<GLsizei>(level.size), level.data);
+                else
+                    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(i), 0, 0, layer,
+                                    level.width, level.height, 1, map.format, map.type, level.data);
+                bytes += level.size;
+            }
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            return bytes;
+        }
+    }
+
+    struct MaterialLibrary::LoadedMaps {
+        size_t materialCount = 0;
+        std::unordered_map<std::string, size_t> index;
+        std::vector<MapData> maps;
+    };
+
+    MaterialLibrary::MaterialLibrary() = default;
+
+    MaterialLibrary::~MaterialLibrary()
+    {
+        cleanup();
+    }
+
+    bool MaterialLibrary::enableCompression(const std::string& cacheDir)
+    {
+        compression = supportsBlockCompression();
+        compressionCache = cacheDir;
+        if (!compression)
+            std::cerr << "S3TC not supported: material maps stay uncompressed\n";
+        return compression;
+    }
+
+    int MaterialLibrary::add(const std::string& diffusePath, const std::string& specularPath, float shininess)
+    {
+        auto key = std::make_tuple(diffusePath, specularPath, shininess);
+        auto found = idOf.find(key);
+        if (found != idOf.end())
+            return found->second;
+
+        Material material;
+        material.diffuse = diffusePath;
+        material.specular = specularPath;
+        material.slot.shininess = shininess;
+        materials.push_back(material);
+        int id = static_cast<int>(materials.size()) - 1;
+        idOf.emplace(key, id);
+        return id;
+    }
+
+    bool MaterialLibrary::load(ThreadPool& pool)
+    {
+        // Every distinct map loads once, in parallel
+        auto result = std::make_unique<LoadedMaps>();
+        result->materialCount = materials.size();
+        std::vector<std::string> paths;
+        for (const Material& material : materials)
+            for (const std::string* path : { &material.diffuse, &material.specular })
+                if (!path->empty() && result->index.emplace(*path, paths.size()).second)
+                    paths.push_back(*path);
+
+        result->maps.resize(paths.size());
+        const bool compressed = compression;
+        const std::string cacheDir = compressionCache;
+        pool.parallelFor(0, paths.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                result->maps[i] = loadMap(paths[i], compressed, cacheDir, pool);
+        });
+        bool ok = true;
+        for (const MapData& map : result->maps)
+            ok = ok && map.valid();
+        loaded = std::move(result);
+        return ok;
+    }
+
+    std::vector<std::string> MaterialLibrary::mapFiles() const
+    {
+        std::vector<std::string> files;
+        for (const Material& material : materials)
+            for (const std::string* path : { &material.diffuse, &material.specular })
+                if (!path->empty() && std::find(files.begin(), files.end(), *path) == files.end())
+                    files.push_back(*path);
+        return files;
+    }
+
+    bool MaterialLibrary::build(ThreadPool& pool)
+    {
+        // Maps added since load() ran are not in it: load again
+        if (!loaded || loaded->materialCount != materials.size())
+            load(pool);
+        const std::unique_ptr<LoadedMaps> input = std::move(loaded);
+        const std::vector<MapData>& maps = input->maps;
+        std::unordered_map<std::string, size_t>& pathIndex = input->index;
+        cleanup();
+        const bool compressed = compression;
+        const std::string cacheDir = compressionCache;
+
+        // Resolve each distinct map pair to a (diffuse, specular) of equal shape
+        std::map<std::pair<std::string, std::string>, size_t> layerOf;
+        std::vector<std::vector<size_t>> users;
+        std::vector<std::pair<MapData, MapData>> resolved;
+        std::vector<std::pair<std::string, std::string>> sources;   // "" = synthesised layer
+        bool ok = true;
+        for (size_t m = 0; m < materials.size(); ++m) {
+            const Material& material = materials[m];
+            auto inserted = layerOf.emplace(std::make_pair(material.diffuse, material.specular), resolved.size());
+            if (!inserted.second) {
+                users[inserted.first->second].push_back(m);
+                continue;
+            }
+            users.push_back({ m });
+
+            std::pair<std::string, std::string> source(material.diffuse, material.specular);
+            MapData diffuse = maps[pathIndex[material.diffuse]];
+            if (!diffuse.valid()) {
+                std::cerr << "Failed to load material map: " << material.diffuse << "\n";
+                diffuse = whiteMap();
+                source.first.clear();
+                ok = false;
+            }
+            MapData specular;
+            if (!material.specular.empty()) {
+                specular = maps[pathIndex[material.specular]];
+                if (!specular.valid()) {
+                    std::cerr << "Failed to load material map: " << material.specular << "\n";
+                    ok = false;
+                } else if (!sameShape(diffuse, specular)) {
+                    std::cerr << "Specular map does not match its diffuse map in size or mips: " << material.specular << "\n";
+                    specular = MapData();
+                }
+            }
+            if (!specular.valid()) {
+                specular = blankMap(diffuse);
+                source.second.clear();
+            }
+            resolved.emplace_back(std::move(diffuse), std::move(specular));
+            sources.push_back(std::move(source));
+        }
+
+        // Group by everything an array layer has to share
+        using PageKey = std::tuple<int, int, size_t, GLenum, GLenum>;
+        std::map<PageKey, std::vector<size_t>> groups;
+        for (size_t r = 0; r < resolved.size(); ++r) {
+            const MapData& d = resolved[r].first;
+            const MapData& s = resolved[r].second;
+            groups[PageKey(d.width(), d.height(), d.levels.size(), d.internalFormat, s.internalFormat)].push_back(r);
+        }
+
+        GLint maxLayers = 256;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+        GLint previousUnit = GL_TEXTURE0;
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &previousUnit);
+        glActiveTexture(GL_TEXTURE0);
+
+        for (const auto& group : groups) {
+            const std::vector<size_t>& members = group.second;
+            for (size_t first = 0; first < members.size(); first += static_cast<size_t>(maxLayers)) {
+                const int layers = static_cast<int>(std::min(members.size() - first, static_cast<size_t>(maxLayers)));
+                const MapData& diffuseShape = resolved[members[first]].first;
+                const MapData& specularShape = resolved[members[first]].second;
+
+                const int levels = static_cast<int>(diffuseShape.levels.size());
+                // Under a residency budget only the tail goes up now; finer levels stream on request
+                const int tail = residency ? residency->tailLevel(diffuseShape.width(), diffuseShape.height(), levels) : 0;
+
+                Page page;
+                page.width = std::max(diffuseShape.width(), diffuseShape.height());
+                size_t bytes = 0;
+                page.diffuse = createArray(diffuseShape, layers, tail);
+                for (int layer = 0; layer < layers; ++layer)
+                    bytes += uploadLayer(resolved[members[first + layer]].first, layer, tail);
+
+                page.specular = createArray(specularShape, layers, tail);
+                for (int layer = 0; layer < layers; ++layer)
+                    bytes += uploadLayer(resolved[members[first + layer]].second, layer, tail);
+
+                statistics.bytes += bytes;
+
+                if (residency) {
+                    std::vector<std::string> diffuseSources, specularSources;
+                    for (int layer = 0; layer < layers; ++layer) {
+                        diffuseSources.push_back(sources[members[first + layer]].first);
+                        specularSources.push_back(sources[members[first + layer]].second);
+                    }
+                    // Synthesised diffuse layers are the white fallback, specular ones blankMap
+                    page.diffuseHandle = trackArray(*residency, page.diffuse, diffuseShape, std::move(diffuseSources),
+                                                    0xFF, tail, compressed, cacheDir, pool);
+                    page.specularHandle = trackArray(*residency, page.specular, specularShape, std::move(specularSources),
+                                                     0, tail, compressed, cacheDir, pool);
+                }
+
+                for (int layer = 0; layer < layers; ++layer)
+                    for (size_t m : users[members[first + layer]]) {
+                        materials[m].slot.page = static_cast<int>(pages.size());
+                        materials[m].slot.layer = layer;
+                    }
+                pages.push_back(page);
+                statistics.layers += static_cast<size_t>(layers);
+            }
+        }
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        glActiveTexture(static_cast<GLenum>(previousUnit));
+
+        statistics.materials = materials.size();
+        statistics.pages = pages.size();
+        return ok;
+    }
+
+    const MaterialLibrary::Slot& MaterialLibrary::slot(int material) const
+    {
+        return materials[material].slot;
+    }
+
+    size_t MaterialLibrary::pageCount() const
+    {
+        return pages.size();
+    }
+
+    void MaterialLibrary::bindPage(int page, GLint diffuseUnit, GLint specularUnit) const
+    {
+        if (page < 0 || page >= static_cast<int>(pages.size()))
+            return;
+        glActiveTexture(GL_TEXTURE0 + diffuseUnit);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, pages[page].diffuse);
+        glActiveTexture(GL_TEXTURE0 + specularUnit);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, pages[page].specular);
+    }
+
+    const MaterialLibrary::Stats& MaterialLibrary::stats() const
+    {
+        return statistics;
+    }
+
+    void MaterialLibrary::printStats(std::ostream& out) const
+    {
+        out << "Materials: " << statistics.materials << " in " << statistics.pages << " array page(s), "
+            << statistics.layers << " layers, " << statistics.bytes / 1024 << " KB\n";
+    }
+
+    void MaterialLibrary::enableResidency(TextureResidency* budget)
+    {
+        residency = budget;
+    }
+
+    void MaterialLibrary::request(int material, float pixels)
+    {
+        if (!residency || material < 0 || material >= static_cast<int>(materials.size()))
+            return;
+        const int page = materials[material].slot.page;
+        if (page < 0)
+            return;
+        const Page& p = pages[page];
+        const int level = mipForCoverage(p.width, pixels);
+        residency->request(p.diffuseHandle, level);
+        residency->request(p.specularHandle, level);
+    }
+
+    void MaterialLibrary::cleanup()
+    {
+        for (Page& page : pages) {
+            if (residency) {
+                residency->untrack(page.diffuseHandle);
+                residency->untrack(page.specularHandle);
+            }
+            glDeleteTextures(1, &page.diffuse);
+            glDeleteTextures(1, &page.specular);
+        }
+        pages.clear();
+        for (Material& material : materials)
+            material.slot.page = -1;
+        statistics = Stats();
+    }
+
+} // namespace gfx
@@ -4,24 +4,43 @@
 #include "stb_image.h"
 #include <iostream>
 #include "tiny_obj_loader.h"
+#include "asset_vfs.h"
 #include <unordered_set>
 
-// Vertex layout: [px,py,pz, nx,ny,nz, u,v]
+// Vertex layout: Mesh::VertexFormat (position, octahedral normal, uv)
 
-bool Mesh::loadOBJ_(const std::string& path)
+bool Mesh::loadOBJ_(const std::string& path, const LoadOptions& options)
 {
-    vertices.clear();
-    indices.clear();
+    Geometry geometry = parseOBJ(path, options);
+    vertices = std::move(geometry.vertices);
+    indices = std::move(geometry.indices);
+    bounds = geometry.bounds;
+    return !vertices.empty() && !indices.empty();
+}
+
+Mesh::Geometry Mesh::parseOBJ(const std::string& path, const LoadOptions& options)
+{
+    Geometry geometry;
+    Vertices& vertices = geometry.vertices;
+    std::vector<unsigned int>& indices = geometry.indices;
+    gfx::AABB& bounds = geometry.bounds;
 
     tinyobj::ObjReaderConfig config;
     config.triangulate = false;   // we'll triangulate ourselves (fan) to match your logic
     config.vertex_color = false;
 
+    // Read through the asset VFS so the OBJ can come from the pack. Only geometry is
+    // used, so any mtllib it names is not loaded.
+    gfx::AssetData obj = gfx::readAsset(path);
+    if (!obj.valid()) {
+        std::cerr << "tinyobj error: cannot open " << path << "\n";
+        return geometry;
+    }
     tinyobj::ObjReader reader;
-    if (!reader.ParseFromFile(path, config)) {
+    if (!reader.ParseFromString(std::string(obj.text()), "", config)) {
         if (!reader.Error().empty())
             std::cerr << "tinyobj error: " << reader.Error() << "\n";
-        return false;
+        return geometry;
     }
     if (!reader.Warning().empty()) {
         std::cerr << "tinyobj warning: " << reader.Warning() << "\n";
@@ -32,7 +51,7 @@ bool Mesh::loadOBJ_(const std::string& path)
 
     auto getPos = [&](int vi) -> glm::vec3 {
         const float* v = attrib.vertices.data() + 3 * vi;
-        return glm::vec3(v[0], v[1], v[2]);
+        return glm::vec3(v[0], v[1], v[2]) * options.scale;
     };
 
     auto getUV = [&](int ti) -> glm::vec2 {
@@ -40,6 +59,17 @@ bool Mesh::loadOBJ_(const std::string& path)
         return glm::vec2(t[0], t[1]);
     };
 
+    // Every fan triangle gets its own three vertices: size everything up front and
+    // write in place
+    size_t vertexCount = 0;
+    for (const auto& shape : shapes)
+        for (int fv : shape.mesh.num_face_vertices)
+            if (fv >= 3)
+                vertexCount += 3 * static_cast<size_t>(fv - 2);
+    vertices.resize(vertexCount);
+    indices.resize(vertexCount);
+    const auto out = vertices.span();
+
     uint32_t baseIndex = 0;
 
     for (const auto& shape : shapes) {
@@ -101,30 +131,25 @@ bool Mesh::loadOBJ_(const std::string& path)
                     n = -n;
                 }
 
-                // Helper to emit a single vertex (pos, n, uv) + push index
+                // Helper to write a single vertex (pos, n, uv) + its index
                 auto emit = [&](int localFaceVertex) {
                     const auto& idx = shape.mesh.indices[index_offset + localFaceVertex];
                     const glm::vec3 p = getPos(idx.vertex_index);
-
-                    vertices.push_back(p.x);
-                    vertices.push_back(p.y);
-                    vertices.push_back(p.z);
-
-                    vertices.push_back(n.x);
-                    vertices.push_back(n.y);
-                    vertices.push_back(n.z);
+                    bounds.expand(p);
 
                     float u = 0.0f, v = 0.0f;
                     if (idx.texcoord_index >= 0 &&
                         static_cast<size_t>(2 * idx.texcoord_index + 1) < attrib.texcoords.size())
                     {
                         glm::vec2 uv = getUV(idx.texcoord_index);
-                        u = uv.x; v = uv.y;
+                        u = uv.x; v = options.flipTexCoords ? 1.0f - uv.y : uv.y;
                     }
-                    vertices.push_back(u);
-                    vertices.push_back(v);
+                    out.set<gfx::Position3f>(baseIndex, p);
+                    out.set<gfx::NormalOct16>(baseIndex, n);
+                    out.set<gfx::UV2h>(baseIndex, glm::vec2(u, v));
 
-                    indices.push_back(baseIndex++);
+                    indices[baseIndex] = baseIndex;
+                    baseIndex++;
                 };
 
                 // Triangle: (0, k, k+1)
@@ -137,67 +162,106 @@ bool Mesh::loadOBJ_(const std::string& path)
         }
     }
 
-    return !vertices.empty() && !indices.empty();
+    return geometry;
 }
 
-void Mesh::createBuffers_()
+//Buffers are bound to GL_COPY_WRITE_BUFFER to fill them: binding the element array
+//target without a VAO is an error in core profile, and the upload context has none.
+static void uploadBuffers(const Mesh::Vertices& vertices, const std::vector<unsigned int>& indices,
+                          GLuint& vertexBuffer, GLuint& indexBuffer)
+{
+    glGenBuffers(1, &vertexBuffer);
+    glGenBuffers(1, &indexBuffer);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vertexBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER,
+                 static_cast<GLsizeiptr>(vertices.byteSize()),
+                 vertices.data(),
+                 GL_STATIC_DRAW);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER,
+                 static_cast<GLsizeiptr>(indices.size() * sizeof(unsigned int)),
+                 indices.data(),
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void Mesh::createBuffers(const Geometry& geometry, GLuint& vertexBuffer, GLuint& indexBuffer)
 {
+    uploadBuffers(geometry.vertices, geometry.indices, vertexBuffer, indexBuffer);
+}
 
-    const GLint posLoc = glGetAttribLocation(shaderProgramID, "aPos");
-    const GLint norLoc = glGetAttribLocation(shaderProgramID, "aNor");
-    const GLint uvLoc  = glGetAttribLocation(shaderProgramID, "aTexCoord");
+void Mesh::createBuffers_()
+{
+    uploadBuffers(vertices, indices, VBO, EBO);
+    createVertexArray_();
+}
 
-    GLsizei stride = 8 * sizeof(float);
-    std::vector<VertexAttribute> attributes = {
-            VertexAttribute{ static_cast<GLuint>(posLoc), 3, GL_FLOAT, GL_FALSE, stride, 0 },
-            VertexAttribute{ static_cast<GLuint>(norLoc),  3, GL_FLOAT, GL_FALSE, stride, 3 * sizeof(float)},
-            VertexAttribute{ static_cast<GLuint>(uvLoc),  2, GL_FLOAT, GL_FALSE, stride, 6 * sizeof(float) }};
+//Fixed locations: the VAO doesn't depend on which program will draw it.
+void Mesh::createVertexArray_()
+{
 
     indexCount = static_cast<GLsizei>(indices.size());
 
     glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
     glBindVertexArray(VAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER,
-                 static_cast<GLsizeiptr>(vertices.size() * sizeof(float)),
-                 vertices.data(),
-                 GL_STATIC_DRAW);
-
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 static_cast<GLsizeiptr>(indices.size() * sizeof(unsigned int)),
-                 indices.data(),
-                 GL_STATIC_DRAW);
 
-    for (const auto& attr : attributes) {
-        glVertexAttribPointer(attr.pos,
-                              attr.size,
-                              attr.type,
-                              attr.normalized,
-                              attr.stride,
-                              reinterpret_cast<const void*>(attr.offset));
-        glEnableVertexAttribArray(attr.pos);
-    }
+    VertexFormat::setupAttributes();
 
     glBindVertexArray(0);
 }
 
-Mesh::Mesh(const std::string& path,
-           GLuint id)
+Mesh::Mesh(const std::string& path, const LoadOptions& options)
 {
-    shaderProgramID = id;
-    loadOBJ_(path);
+    loadOBJ_(path, options);
     createBuffers_();
 }
 
+Mesh::Mesh(Geometry geometry)
+{
+    setGeometry(std::move(geometry));
+}
+
+void Mesh::setGeometry(Geometry geometry)
+{
+    cleanup();
+    vertices = std::move(geometry.vertices);
+    indices = std::move(geometry.indices);
+    bounds = geometry.bounds;
+    createBuffers_();
+}
+
+void Mesh::setGeometry(Geometry geometry, GLuint vertexBuffer, GLuint indexBuffer)
+{
+    cleanup();
+    vertices = std::move(geometry.vertices);
+    indices = std::move(geometry.indices);
+    bounds = geometry.bounds;
+    VBO = vertexBuffer;
+    EBO = indexBuffer;
+    createVertexArray_();
+}
+
 Mesh::~Mesh() {
     cleanup();
 }
 
+const Mesh::Vertices& Mesh::getVertices() const {
+    return vertices;
+}
+
+const std::vector<unsigned int>& Mesh::getIndices() const {
+    return indices;
+}
+
+const gfx::AABB& Mesh::getBounds() const {
+    return bounds;
+}
+
 void Mesh::draw() const{
     bind();
     glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, nullptr);
@@ -0,0 +1,131 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "mesh_cache.h"
+#include <iostream>
+#include <ostream>
+#include <sstream>
+
+#include "thread_pool.h"
+
+namespace gfx {
+
+    MeshCache::~MeshCache()
+    {
+        clear();
+    }
+
+    std::string MeshCache::key_(const std::string& path, const Mesh::LoadOptions& options)
+    {
+        std::ostringstream key;
+        key << path << "|s" << options.scale << "|flip" << options.flipTexCoords;
+        return key.str();
+    }
+
+    void MeshCache::load(const std::string& path, const Mesh::LoadOptions& options)
+    {
+        const std::string key = key_(path, options);
+        std::promise<std::shared_ptr<Mesh::Geometry>> promise;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (parsed.count(key))
+                return;
+            parsed.emplace(key, promise.get_future().share());
+        }
+        promise.set_value(std::make_shared<Mesh::Geometry>(Mesh::parseOBJ(path, options)));
+    }
+
+    void MeshCache::prefetch(const std::string& path, const Mesh::LoadOptions& options)
+    {
+        const std::string key = key_(path, options);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (parsed.count(key))
+            return;
+        parsed.emplace(key, ThreadPool::shared().submit([path, options] {
+            return std::make_shared<Mesh::Geometry>(Mesh::parseOBJ(path, options));
+        }).share());
+    }
+
+    Mesh* MeshCache::acquire(const std::string& path, const Mesh::LoadOptions& options)
+    {
+        const std::string key = key_(path, options);
+        auto found = entries.find(key);
+        if (found != entries.end()) {
+            found->second.refs++;
+            statistics.hits++;
+            statistics.savedBytes += found->second.bytes;
+            return found->second.mesh.get();
+        }
+        statistics.misses++;
+
+        Parsed loading;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = parsed.find(key);
+            if (it != parsed.end()) {
+                loading = it->second;
+                parsed.erase(it);
+            }
+        }
+        // Nobody else reads the geometry once it is out of `parsed`: move it into the mesh
+        Mesh::Geometry geometry = loading.valid() ? std::move(*loading.get()) : Mesh::parseOBJ(path, options);
+        if (geometry.vertices.empty() || geometry.indices.empty()) {
+            std::cerr << "Failed to load mesh: " << path << "\n";
+            return nullptr;
+        }
+
+        Entry entry;
+        entry.refs = 1;
+        entry.bytes = geometry.vertices.byteSize() + geometry.indices.size() * sizeof(unsigned int);
+        entry.mesh = std::make_unique<Mesh>(std::move(geometry));
+        Mesh* mesh = entry.mesh.get();
+
+        statistics.meshes++;
+        statistics.residentBytes += entry.bytes;
+        keyOf[mesh] = key;
+        entries.emplace(key, std::move(entry));
+        return mesh;
+    }
+
+    void MeshCache::release(const Mesh* mesh)
+    {
+        auto key = keyOf.find(mesh);
+        if (key == keyOf.end())
+            return;
+        auto entry = entries.find(key->second);
+        if (--entry->second.refs > 0)
+            return;
+
+        statistics.meshes--;
+        statistics.residentBytes -= entry->second.bytes;
+        entries.erase(entry);
+        keyOf.erase(key);
+    }
+
+    const MeshCache::Stats& MeshCache::stats() const
+    {
+        return statistics;
+    }
+
+    void MeshCache::printStats(std::ostream& out) const
+    {
+        out << "Meshes: " << statistics.meshes << " resident (" << statistics.residentBytes / 1024 << " KB), "
+            << statistics.hits << " hits / " << statistics.misses << " misses, "
+            << statistics.savedBytes / 1024 << " KB of duplicate uploads avoided\n";
+    }
+
+    void MeshCache::clear()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto& pair : parsed)
+                pair.second.wait();
+            parsed.clear();
+        }
+        entries.clear();
+        keyOf.clear();
+        statistics.meshes = 0;
+        statistics.residentBytes = 0;
+    }
+
+} // namespace gfx
@@ -0,0 +1,229 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "mipmap.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GFX_MIP_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// The AVX2 kernel is compiled for the target alone and picked at runtime
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define GFX_MIP_AVX2 1
+#define GFX_MIP_AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(__AVX2__)
+#define GFX_MIP_AVX2 1
+#define GFX_MIP_AVX2_TARGET
+#include <immintrin.h>
+#endif
+
+namespace gfx {
+
+    namespace {
+        // sRGB <-> 16-bit linear. Four decoded texels sum without overflow in 32 bits
+        // and their rounded mean indexes the encode table directly.
+        struct SrgbTables {
+            uint32_t toLinear[256];
+            uint8_t toSrgb[65536 + 4];   // padded for 4-byte gathers at the last entry
+        };
+
+        const SrgbTables& srgbTables()
+        {
+            static const SrgbTables tables = [] {
+                SrgbTables t{};
+                for (int i = 0; i < 256; ++i) {
+                    double c = i / 255.0;
+                    double l = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+                    t.toLinear[i] = static_cast<uint32_t>(std::lround(l * 65535.0));
+                }
+                for (int i = 0; i < 65536; ++i) {
+                    double l = i / 65535.0;
+                    double c = l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+                    t.toSrgb[i] = static_cast<uint8_t>(std::lround(std::min(1.0, c) * 255.0));
+                }
+                return t;
+            }();
+            return tables;
+        }
+
+        bool hasAvx2()
+        {
+#if defined(GFX_MIP_AVX2) && (defined(__GNUC__) || defined(__clang__)) && !defined(__AVX2__)
+            static const bool supported = __builtin_cpu_supports("avx2");
+            return supported;
+#elif defined(GFX_MIP_AVX2)
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        // Output texel x of a row pair, edges clamped; the reference for the SIMD paths
+        inline void downsampleTexel(const uint8_t* r0, const uint8_t* r1, int width, int x, bool srgb,
+                                    const SrgbTables& t, uint8_t* out)
+        {
+            const int x0 = std::min(2 * x, width - 1) * 4, x1 = std::min(2 * x + 1, width - 1) * 4;
+            for (int c = 0; c < 4; ++c) {
+                if (srgb && c < 3) {
+                    uint32_t sum = t.toLinear[r0[x0 + c]] + t.toLinear[r0[x1 + c]]
+                                 + t.toLinear[r1[x0 + c]] + t.toLinear[r1[x1 + c]];
+                    out[c] = t.toSrgb[(sum + 2) >> 2];
+                } else {
+                    int sum = r0[x0 + c] + r0[x1 + c] + r1[x0 + c] + r1[x1 + c];
+                    out[c] = static_cast<uint8_t>((sum + 2) >> 2);
+                }
+            }
+        }
+
+#ifdef GFX_MIP_SSE2
+        // Two output texels from four input texels of each row
+        inline void downsamplePairSse2(const uint8_t* r0, const uint8_t* r1, uint8_t* out)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r0));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r1));
+            __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));  // p0 | p1
+            __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));  // p2 | p3
+            __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+            sum = _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(sum, sum));
+        }
+#endif
+
+#ifdef GFX_MIP_AVX2
+        // sRGB variant: table lookups become gathers, alpha lanes (3 and 7) bypass them
+        GFX_MIP_AVX2_TARGET
+        void downsampleRowSrgbAvx2(const uint8_t* r0, const uint8_t* r1, uint8_t* out, int pairs, const SrgbTables& t)
+        {
+            const int* toLinear = reinterpret_cast<const int*>(t.toLinear);
+            const int* toSrgb = reinterpret_cast<const int*>(t.toSrgb);
+            const __m256i two = _mm256_set1_epi32(2), byteMask = _mm256_set1_epi32(0xFF);
+            for (int i = 0; i < pairs; ++i, r0 += 16, r1 += 16, out += 8) {
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r0));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r1));
+                __m256i a01 = _mm256_cvtepu8_epi32(a), a23 = _mm256_cvtepu8_epi32(_mm_srli_si128(a, 8));
+                __m256i b01 = _mm256_cvtepu8_epi32(b), b23 = _mm256_cvtepu8_epi32(_mm_srli_si128(b, 8));
+
+                __m256i s01 = _mm256_add_epi32(_mm256_blend_epi32(_mm256_i32gather_epi32(toLinear, a01, 4), a01, 0x88),
+                                               _mm256_blend_epi32(_mm256_i32gather_epi32(toLinear, b01, 4), b01, 0x88));
+                __m256i s23 = _mm256_add_epi32(_mm256_blend_epi32(_mm256_i32gather_epi32(toLinear, a23, 4), a23, 0x88),
+                                               _mm256_blend_epi32(_mm256_i32gather_epi32(toLinear, b23, 4), b23, 0x88));
+                // [p0+p1 | p2+p3]
+                __m256i sum = _mm256_add_epi32(_mm256_permute2x128_si256(s01, s23, 0x20),
+                                               _mm256_permute2x128_si256(s01, s23, 0x31));
+                sum = _mm256_srli_epi32(_mm256_add_epi32(sum, two), 2);
+
+                __m256i srgb = _mm256_and_si256(_mm256_i32gather_epi32(toSrgb, sum, 1), byteMask);
+                __m256i texels = _mm256_blend_epi32(srgb, sum, 0x88);
+                __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(texels), _mm256_extracti128_si256(texels, 1));
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(words, words));
+            }
+        }
+#endif
+
+        void downsampleRows(const MipLevel& source, MipLevel& level, size_t yBegin, size_t yEnd, bool srgb)
+        {
+            const SrgbTables& t = srgbTables();
+            const int width = source.width;
+            const size_t rowBytes = static_cast<size_t>(width) * 4;
+            // Pairs of output texels whose four inputs are all in range
+            [[maybe_unused]] const int pairs = level.width / 2;
+#ifdef GFX_MIP_AVX2
+            const bool avx2 = srgb && hasAvx2();
+#endif
+
+            for (size_t y = yBegin; y < yEnd; ++y) {
+                const size_t y0 = std::min<size_t>(2 * y, source.height - 1), y1 = std::min<size_t>(2 * y + 1, source.height - 1);
+                const uint8_t* r0 = source.rgba.data() + y0 * rowBytes;
+                const uint8_t* r1 = source.rgba.data() + y1 * rowBytes;
+                uint8_t* out = level.rgba.data() + y * level.width * 4;
+
+                int x = 0;
+#ifdef GFX_MIP_AVX2
+                if (avx2) {
+                    downsampleRowSrgbAvx2(r0, r1, out, pairs, t);
+                    x = 2 * pairs;
+                }
+#endif
+#ifdef GFX_MIP_SSE2
+                if (!srgb) {
+                    for (; x + 1 < 2 * pairs; x += 2)
+                        downsamplePairSse2(r0 + 8 * x, r1 + 8 * x, out + 4 * x);
+                }
+#endif
+                for (; x < level.width; ++x)
+                    downsampleTexel(r0, r1, width, x, srgb, t, out + 4 * x);
+            }
+        }
+    }
+
+    std::vector<uint8_t> expandToRGBA(const Image& image)
+    {
+        size_t count = static_cast<size_t>(image.width) * image.height;
+        std::vector<uint8_t> rgba(count * 4);
+        const uint8_t* src = image.pixels.get();
+        for (size_t i = 0; i < count; ++i, src += image.channels) {
+            uint8_t* dst = &rgba[i * 4];
+            switch (image.channels) {
+                case 1: dst[0] = dst[1] = dst[2] = src[0]; dst[3] = 255; break;
+                case 2: dst[0] = dst[1] = dst[2] = src[0]; dst[3] = src[1]; break;
+                case 3: dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; dst[3] = 255; break;
+                default: std::memcpy(dst, src, 4); break;
+            }
+        }
+        return rgba;
+    }
+
+    bool prefersSrgbMips(const Image& image)
+    {
+        if (image.channels < 3)
+            return false;
+        const uint8_t* p = image.pixels.get();
+        size_t count = static_cast<size_t>(image.width) * image.height;
+        for (size_t i = 0; i < count; ++i, p += image.channels)
+            if (p[0] != p[1] || p[1] != p[2])
+                return true;
+        return false;
+    }
+
+    MipLevel downsampleRGBA(const MipLevel& source, bool srgb, ThreadPool& pool)
+    {
+        MipLevel level;
+        level.width = std::max(1, source.width / 2);
+        level.height = std::max(1, source.height / 2);
+        level.rgba.resize(static_cast<size_t>(level.width) * level.height * 4);
+        // ~64K output texels per task; small levels stay on the calling thread
+        const size_t grain = std::max<size_t>(1, (64u << 10) / static_cast<size_t>(level.width));
+        pool.parallelFor(0, static_cast<size_t>(level.height), grain, [&](size_t begin, size_t end) {
+            downsampleRows(source, level, begin, end, srgb);
+        });
+        return level;
+    }
+
+    std::vector<MipLevel> buildMipChain(const Image& image, bool srgb, ThreadPool& pool)
+    {
+        std::vector<MipLevel> chain;
+        if (!image.valid())
+            return chain;
+        chain.push_back(MipLevel{ image.width, image.height, expandToRGBA(image) });
+        while (chain.back().width > 1 || chain.back().height > 1)
+            chain.push_back(downsampleRGBA(chain.back(), srgb, pool));
+        return chain;
+    }
+
+    std::vector<std::vector<MipLevel>> buildMipChains(const std::vector<Image>& faces, bool srgb, ThreadPool& pool)
+    {
+        std::vector<std::vector<MipLevel>> chains(faces.size());
+        pool.parallelFor(0, faces.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                chains[i] = buildMipChain(faces[i], srgb, pool);
+        });
+        return chains;
+    }
+
+} // namespace gfx
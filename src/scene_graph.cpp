@@ -0,0 +1,223 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "scene_graph.h"
+#include <algorithm>
+#include <type_traits>
+
+namespace gfx {
+
+    namespace {
+        glm::mat4 composeTRS(const glm::vec3& t, const glm::quat& r, const glm::vec3& s)
+        {
+            glm::mat4 m = glm::mat4_cast(r);
+            m[0] *= s.x;
+            m[1] *= s.y;
+            m[2] *= s.z;
+            m[3] = glm::vec4(t, 1.0f);
+            return m;
+        }
+    }
+
+    NodeHandle SceneGraph::createNode(NodeHandle parentNode, const glm::vec3& t, const glm::quat& r, const glm::vec3& s)
+    {
+        NodeHandle handle = static_cast<NodeHandle>(handleToSlot.size());
+        uint32_t slot = static_cast<uint32_t>(slotToHandle.size());
+
+        // Appended for now; rebuildOrder_() moves it into breadth-first position
+        handleToSlot.push_back(slot);
+        parentHandle.push_back(parentNode);
+        slotToHandle.push_back(handle);
+        parent.push_back(parentNode == kInvalidNode ? kInvalidNode : handleToSlot[parentNode]);
+        depth.push_back(parentNode == kInvalidNode ? 0 : static_cast<uint16_t>(depth[handleToSlot[parentNode]] + 1));
+        translation.push_back(t);
+        rotation.push_back(r);
+        scale.push_back(s);
+        worldMatrix.emplace_back(1.0f);
+        dirty.push_back(0);
+
+        orderDirty = true;
+        markDirty_(slot);
+        return handle;
+    }
+
+    void SceneGraph::setLocal(NodeHandle node, const glm::vec3& t, const glm::quat& r, const glm::vec3& s)
+    {
+        uint32_t slot = handleToSlot[node];
+        translation[slot] = t;
+        rotation[slot] = r;
+        scale[slot] = s;
+        markDirty_(slot);
+    }
+
+    void SceneGraph::setTranslation(NodeHandle node, const glm::vec3& t)
+    {
+        uint32_t slot = handleToSlot[node];
+        translation[slot] = t;
+        markDirty_(slot);
+    }
+
+    void SceneGraph::setRotation(NodeHandle node, const glm::quat& r)
+    {
+        uint32_t slot = handleToSlot[node];
+        rotation[slot] = r;
+        markDirty_(slot);
+    }
+
+    void SceneGraph::setScale(NodeHandle node, const glm::vec3& s)
+    {
+        uint32_t slot = handleToSlot[node];
+        scale[slot] = s;
+        markDirty_(slot);
+    }
+
+    void SceneGraph::markDirty_(uint32_t slot)
+    {
+        if (dirty[slot])
+            return;
+        dirty[slot] = 1;
+        ++dirtyCount;
+
+        if (orderDirty)
+            return;   // level bounds are recomputed by rebuildOrder_()
+        uint16_t level = depth[slot];
+        levelDirtyMin[level] = std::min(levelDirtyMin[level], slot);
+        levelDirtyMax[level] = std::max(levelDirtyMax[level], slot);
+    }
+
+    void SceneGraph::rebuildOrder_()
+    {
+        const uint32_t n = static_cast<uint32_t>(slotToHandle.size());
+
+        // Children per handle, CSR style, kept in creation order
+        std::vector<uint32_t> childStart(n + 1, 0), childOf(n);
+        for (uint32_t h = 0; h < n; ++h)
+            if (parentHandle[h] != kInvalidNode) childStart[parentHandle[h] + 1]++;
+        for (uint32_t h = 0; h < n; ++h)
+            childStart[h + 1] += childStart[h];
+        std::vector<uint32_t> fill(childStart.begin(), childStart.end() - 1);
+        for (uint32_t h = 0; h < n; ++h)
+            if (parentHandle[h] != kInvalidNode) childOf[fill[parentHandle[h]]++] = h;
+
+        // Breadth-first: roots first, then each node's children in turn
+        std::vector<NodeHandle> bfs;
+        bfs.reserve(n);
+        for (uint32_t h = 0; h < n; ++h)
+            if (parentHandle[h] == kInvalidNode) bfs.push_back(h);
+        for (size_t i = 0; i < bfs.size(); ++i) {
+            NodeHandle h = bfs[i];
+            for (uint32_t c = childStart[h]; c < childStart[h + 1]; ++c)
+                bfs.push_back(childOf[c]);
+        }
+
+        auto permute = [&](auto& column) {
+            using Column = std::decay_t<decltype(column)>;
+            Column sorted(n);
+            for (uint32_t s = 0; s < n; ++s)
+                sorted[s] = column[handleToSlot[bfs[s]]];
+            column.swap(sorted);
+        };
+        permute(translation);
+        permute(rotation);
+        permute(scale);
+        permute(worldMatrix);
+        permute(dirty);
+
+        for (uint32_t s = 0; s < n; ++s)
+            handleToSlot[bfs[s]] = s;
+        slotToHandle = bfs;
+
+        parent.assign(n, kInvalidNode);
+        depth.assign(n, 0);
+        childBegin.assign(n + 1, n);
+        uint32_t next = 0;
+        for (uint32_t s = 0; s < n; ++s) {
+            NodeHandle h = bfs[s];
+            if (parentHandle[h] != kInvalidNode) {
+                parent[s] = handleToSlot[parentHandle[h]];
+                depth[s] = static_cast<uint16_t>(depth[parent[s]] + 1);
+            } else {
+                ++next;   // roots occupy the first slots
+            }
+        }
+        // Children of slot s start after everything before them in BFS order
+        for (uint32_t s = 0; s < n; ++s) {
+            childBegin[s] = next;
+            next += childStart[bfs[s] + 1] - childStart[bfs[s]];
+        }
+        childBegin[n] = next;
+
+        uint16_t levels = n ? static_cast<uint16_t>(depth[n - 1] + 1) : 0;
+        levelDirtyMin.assign(levels, n);
+        levelDirtyMax.assign(levels, 0);
+        for (uint32_t s = 0; s < n; ++s) {
+            if (!dirty[s]) continue;
+            levelDirtyMin[depth[s]] = std::min(levelDirtyMin[depth[s]], s);
+            levelDirtyMax[depth[s]] = std::max(levelDirtyMax[depth[s]], s);
+        }
+        orderDirty = false;
+    }
+
+    size_t SceneGraph::update()
+    {
+        changedList.clear();
+        if (dirtyCount == 0)
+            return 0;
+        if (orderDirty)
+            rebuildOrder_();
+
+        // carry = slot range (in the current level) holding children of nodes updated one level up
+        uint32_t carryBegin = 0, carryEnd = 0;
+        for (size_t level = 0; level < levelDirtyMin.size(); ++level) {
+            uint32_t begin = carryBegin, end = carryEnd;
+            if (levelDirtyMin[level] <= levelDirtyMax[level]) {
+                begin = begin < end ? std::min(begin, levelDirtyMin[level]) : levelDirtyMin[level];
+                end   = std::max(end, levelDirtyMax[level] + 1);
+            }
+            levelDirtyMin[level] = static_cast<uint32_t>(slotToHandle.size());
+            levelDirtyMax[level] = 0;
+            if (begin >= end) {
+                carryBegin = carryEnd = 0;
+                continue;
+            }
+
+            for (uint32_t s = begin; s < end; ++s) {
+                uint32_t p = parent[s];
+                if (!dirty[s] && (p == kInvalidNode || !dirty[p]))
+                    continue;
+                glm::mat4 local = composeTRS(translation[s], rotation[s], scale[s]);
+                worldMatrix[s] = p == kInvalidNode ? local : worldMatrix[p] * local;
+                if (!dirty[s]) {
+                    dirty[s] = 1;   // children one level down key off this
+                    ++dirtyCount;
+                }
+                updatedSlots.push_back(s);
+                changedList.push_back(slotToHandle[s]);
+            }
+            carryBegin = childBegin[begin];
+            carryEnd   = childBegin[end];
+        }
+
+        for (uint32_t s : updatedSlots)
+            dirty[s] = 0;
+        updatedSlots.clear();
+        dirtyCount = 0;
+        return changedList.size();
+    }
+
+    const glm::mat4& SceneGraph::world(NodeHandle node) const
+    {
+        return worldMatrix[handleToSlot[node]];
+    }
+
+    const std::vector<NodeHandle>& SceneGraph::changed() const
+    {
+        return changedList;
+    }
+
+    size_t SceneGraph::size() const
+    {
+        return slotToHandle.size();
+    }
+
+} // namespace gfx
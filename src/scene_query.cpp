@@ -0,0 +1,158 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "scene_query.h"
+#include <iostream>
+#include <mutex>
+
+namespace gfx {
+
+    Ray screenRay(const Camera& camera, double cursorX, double cursorY, int width, int height)
+    {
+        float x = static_cast<float>(2.0 * cursorX / width - 1.0);
+        float y = static_cast<float>(1.0 - 2.0 * cursorY / height);
+
+        glm::mat4 viewProj = camera.GetProjection(static_cast<float>(width) / height) * camera.GetViewMatrix();
+        glm::mat4 inv = glm::inverse(viewProj);
+        glm::vec4 nearPoint = inv * glm::vec4(x, y, -1.0f, 1.0f);
+        glm::vec4 farPoint  = inv * glm::vec4(x, y,  1.0f, 1.0f);
+
+        Ray r;
+        r.origin    = glm::vec3(nearPoint) / nearPoint.w;
+        r.direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - r.origin);
+        return r;
+    }
+
+    int SceneQuery::addMesh(const Mesh& mesh)
+    {
+        // Build outside the lock; only publishing the mesh needs exclusivity
+        auto tris = std::make_unique<TriangleBVH>();
+        const auto vertices = mesh.getVertices().span();
+        std::vector<glm::vec3> positions(vertices.size());
+        for (size_t v = 0; v < vertices.size(); ++v)
+            positions[v] = vertices.get<Position3f>(v);
+        tris->build(positions, mesh.getIndices());
+
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        meshes.push_back(std::move(tris));
+        return static_cast<int>(meshes.size()) - 1;
+    }
+
+    int SceneQuery::addObject(int meshId, const glm::mat4& model)
+    {
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            if (meshId < 0 || meshId >= static_cast<int>(meshes.size())) {
+                std::cerr << "Scene query: addObject with unknown mesh " << meshId << "\n";
+                return -1;
+            }
+        }
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        pendingObjects.push_back(Object { meshId, model, glm::mat4(1.0f) });
+        return pendingObjectCount++;
+    }
+
+    bool SceneQuery::setObjectTransform(int objectId, const glm::mat4& model)
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        // Every id below pendingObjectCount exists in objects once commit() appends the staged ones
+        if (objectId < 0 || objectId >= pendingObjectCount) {
+            std::cerr << "Scene query: setObjectTransform on unknown object " << objectId << "\n";
+            return false;
+        }
+        pendingTransforms[objectId] = model;
+        return true;
+    }
+
+    void SceneQuery::commit()
+    {
+        std::vector<Object> added;
+        std::unordered_map<int, glm::mat4> moved;
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            added.swap(pendingObjects);
+            moved.swap(pendingTransforms);
+        }
+        if (added.empty() && moved.empty())
+            return;
+
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        const size_t firstAdded = objects.size();
+        objects.insert(objects.end(), added.begin(), added.end());
+        objectBounds.resize(objects.size());
+        for (const auto& [id, model] : moved)
+            objects[id].model = model;
+
+        for (size_t id = firstAdded; id < objects.size(); ++id)
+            moved.emplace(static_cast<int>(id), objects[id].model);
+        for (const auto& [id, model] : moved) {
+            Object& obj = objects[id];
+            obj.invModel = glm::inverse(obj.model);
+            objectBounds[id] = transformAABB(meshes[obj.mesh]->bounds(), obj.model);
+        }
+
+        if (!added.empty())
+            topLevel.build(objectBounds, 1);
+        else
+            topLevel.refit(objectBounds);
+    }
+
+    size_t SceneQuery::objectCount() const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return objects.size();
+    }
+
+    bool SceneQuery::raycast(const Ray& ray, RayHit& hit, float maxDistance) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return raycastLocked_(ray, hit, maxDistance);
+    }
+
+    void SceneQuery::raycastBatch(const std::vector<Ray>& rays, std::vector<RayHit>& hits,
+                                  float maxDistance, ThreadPool& pool) const
+    {
+        hits.assign(rays.size(), RayHit{});
+        // Held across the whole batch so a commit() cannot land between chunks
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        pool.parallelFor(0, rays.size(), 256, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                raycastLocked_(rays[i], hits[i], maxDistance);
+        });
+    }
+
+    bool SceneQuery::raycastLocked_(const Ray& ray, RayHit& hit, float maxDistance) const
+    {
+        hit = RayHit{};
+        const auto& order = topLevel.primitiveOrder();
+        RayQuery world(ray);
+
+        topLevel.traverse(world, maxDistance, [&](uint32_t first, uint32_t count, float& tMax) {
+            for (uint32_t i = first; i < first + count; ++i) {
+                int id = static_cast<int>(order[i]);
+                const Object& obj = objects[id];
+
+                // Unnormalized local direction keeps t comparable across objects
+                Ray local;
+                local.origin    = glm::vec3(obj.invModel * glm::vec4(ray.origin, 1.0f));
+                local.direction = glm::vec3(obj.invModel * glm::vec4(ray.direction, 0.0f));
+
+                TriangleHit tri;
+                if (!meshes[obj.mesh]->intersect(RayQuery(local), tMax, tri))
+                    continue;
+
+                tMax = tri.t;
+                hit.object   = id;
+                hit.triangle = tri.triangle;
+                hit.distance = tri.t;
+                hit.position = ray.origin + ray.direction * tri.t;
+                glm::mat3 normalMatrix = glm::transpose(glm::mat3(obj.invModel));
+                hit.normal = glm::normalize(normalMatrix * meshes[obj.mesh]->normal(tri.triangle));
+                if (glm::dot(hit.normal, ray.direction) > 0.0f)
+                    hit.normal = -hit.normal;   // face the viewer
+            }
+        });
+        return hit.object >= 0;
+    }
+
+} // namespace gfx
@@ -0,0 +1,30 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#include "shader_source.h"
+
+#include <string_view>
+
+#ifndef GFX_SHADERS_FROM_DISK
+#include "embedded_shaders.h"   // generated by tools/shader_embed.cpp
+#endif
+
+namespace gfx {
+
+    std::string shaderSource(const std::string& path)
+    {
+#ifndef GFX_SHADERS_FROM_DISK
+        const std::string_view root = SHADER_DIR;
+        if (path.compare(0, root.size(), root) == 0) {
+            const std::string_view name = std::string_view(path).substr(root.size());
+            for (const embedded::Shader& shader : embedded::shaders) {
+                if (shader.name == name)
+                    return std::string(shader.source);
+            }
+        }
+#endif
+        return preprocessShader(path);
+    }
+
+} // namespace gfx
@@ -0,0 +1,95 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#include "shader_source.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+#include "asset_vfs.h"
+
+namespace gfx {
+
+    namespace {
+        bool readText(const std::filesystem::path& path, std::string& text)
+        {
+            AssetData file = readAsset(path.string());
+            if (!file.valid())
+                return false;
+            text = file.text();
+            return true;
+        }
+
+        // `#include "name"` (or <name>) with any spacing; false for every other line.
+        bool parseInclude(const std::string& line, std::string& name)
+        {
+            size_t i = line.find_first_not_of(" \t");
+            if (i == std::string::npos || line[i] != '#')
+                return false;
+            i = line.find_first_not_of(" \t", i + 1);
+            if (i == std::string::npos || line.compare(i, 7, "include") != 0)
+                return false;
+            i = line.find_first_not_of(" \t", i + 7);
+            if (i == std::string::npos || (line[i] != '"' && line[i] != '<'))
+                return false;
+            const size_t end = line.find(line[i] == '"' ? '"' : '>', i + 1);
+            if (end == std::string::npos)
+                return false;
+            name = line.substr(i + 1, end - i - 1);
+            return !name.empty();
+        }
+
+        struct Expansion {
+            std::vector<std::string> files;     // source string numbers in #line
+            std::string out;
+        };
+
+        bool expand(const std::filesystem::path& path, int fileIndex, Expansion& state)
+        {
+            std::string text;
+            if (!readText(path, text)) {
+                std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path.string() << "\n";
+                return false;
+            }
+
+            std::istringstream lines(text);
+            std::string line, name;
+            for (int lineNumber = 1; std::getline(lines, line); ++lineNumber) {
+                if (!line.empty() && line.back() == '\r')
+                    line.pop_back();
+                if (!parseInclude(line, name)) {
+                    state.out += line;
+                    state.out += '\n';
+                    continue;
+                }
+
+                const std::string target = (path.parent_path() / name).lexically_normal().string();
+                if (std::find(state.files.begin(), state.files.end(), target) != state.files.end()) {
+                    state.out += '\n';      // already pasted: keep the line count
+                    continue;
+                }
+                const int targetIndex = static_cast<int>(state.files.size());
+                state.files.push_back(target);
+                state.out += "#line 1 " + std::to_string(targetIndex) + " // " + name + "\n";
+                if (!expand(target, targetIndex, state))
+                    return false;
+                state.out += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+            }
+            return true;
+        }
+    }
+
+    std::string preprocessShader(const std::string& path, std::vector<std::string>* dependencies)
+    {
+        Expansion state;
+        state.files.push_back(std::filesystem::path(path).lexically_normal().string());
+        const bool ok = expand(path, 0, state);
+        if (dependencies)
+            dependencies->insert(dependencies->end(), state.files.begin(), state.files.end());
+        return ok ? std::move(state.out) : std::string();
+    }
+
+} // namespace gfx
@@ -1,31 +1,54 @@
 #include "shaderprogram.h"
+#include "gl_ext.h"
+#include "hash.h"
+#include "shader_source.h"
+#include "texture_manager.h"
+#include "vertex_attributes.h"
+#include <filesystem>
 #include <fstream>
-#include <sstream>
 #include <iostream>
 #include <vector>
 #include <string>
 
+std::string ShaderProgram::binaryCacheDir;
+
+namespace {
+    constexpr uint32_t kBinaryMagic = 0x4E425047;   // "GPBN"
+    constexpr uint32_t kBinaryVersion = 2;         // 2: attribute locations bound before linking
+
+    //Sampler uniforms hold a texture unit: a single int.
+    bool isSamplerType(GLenum type) {
+        switch (type) {
+            case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+            case GL_SAMPLER_1D_SHADOW: case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_CUBE_SHADOW:
+            case GL_SAMPLER_1D_ARRAY: case GL_SAMPLER_2D_ARRAY:
+            case GL_SAMPLER_1D_ARRAY_SHADOW: case GL_SAMPLER_2D_ARRAY_SHADOW:
+            case GL_SAMPLER_2D_RECT: case GL_SAMPLER_2D_RECT_SHADOW: case GL_SAMPLER_BUFFER:
+            case GL_SAMPLER_2D_MULTISAMPLE: case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+            case GL_INT_SAMPLER_1D: case GL_INT_SAMPLER_2D: case GL_INT_SAMPLER_3D: case GL_INT_SAMPLER_CUBE:
+            case GL_INT_SAMPLER_1D_ARRAY: case GL_INT_SAMPLER_2D_ARRAY: case GL_INT_SAMPLER_2D_RECT:
+            case GL_INT_SAMPLER_BUFFER: case GL_INT_SAMPLER_2D_MULTISAMPLE: case GL_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+            case GL_UNSIGNED_INT_SAMPLER_1D: case GL_UNSIGNED_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_3D:
+            case GL_UNSIGNED_INT_SAMPLER_CUBE: case GL_UNSIGNED_INT_SAMPLER_1D_ARRAY:
+            case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY: case GL_UNSIGNED_INT_SAMPLER_2D_RECT:
+            case GL_UNSIGNED_INT_SAMPLER_BUFFER: case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE:
+            case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+                return true;
+            default:
+                return false;
+        }
+    }
+}
 
+
+//Shaders under SHADER_DIR come preprocessed from the binary itself (see shader_source.h);
+//other paths are read from disk with their #includes expanded.
 std::string ShaderProgram::loadShaderSource(const std::string& filePath) {
-    //OpenGL requires the shader to be stored as a const string.
-    //Create an input file stream to read from the file.
-    std::ifstream shaderFile;
-    //bitwise OR operation combining two error state flags used with
-    //input/output streams, particularly std::ifstream for file input.
-    shaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    try {
-        shaderFile.open(filePath);
-        std::stringstream shaderStream;
-        //Reads the entire contents of the file into the string stream using the file buffer.
-        shaderStream << shaderFile.rdbuf();
-        shaderFile.close();
-        return shaderStream.str();
-    } catch (std::ifstream::failure& e) {
-        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << filePath << "\n";
-        return "";
-    }
+    return gfx::shaderSource(filePath);
 }
 
+//Only issues the compile: the status is checked in finish(), so the driver can
+//work on several shaders (and the caller on other things) in the meantime.
 GLuint ShaderProgram::compileShader(const std::string& source, GLenum shaderType) {
     //Converts the std::string source code into a C-style string (const char*)
     //because OpenGL expects shader source code in this format.
@@ -33,47 +56,345 @@ GLuint ShaderProgram::compileShader(const std::string& source, GLenum shaderType
     GLuint shader = glCreateShader(shaderType);
     glShaderSource(shader, 1, &shaderCode, nullptr);
     glCompileShader(shader);
-
-    GLint success;
-    GLchar infoLog[512];
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(shader, 512, nullptr, infoLog);
-        std::cerr << "ERROR::SHADER::COMPILATION_FAILED\n" << infoLog << "\n";
-    }
-
     return shader;
 }
 
-void ShaderProgram::linkProgram(GLuint vertexShader, GLuint fragmentShader) {
+void ShaderProgram::linkProgram(const std::vector<GLuint>& shaders, bool retrievable) {
     //Creates a new shader program and returns its ID.
     ID = glCreateProgram();
-    //Attach the compiled vertex and fragment shaders to the program.
-    glAttachShader(ID, vertexShader);
-    glAttachShader(ID, fragmentShader);
+    //Attach the compiled shader stages to the program.
+    for (GLuint shader : shaders)
+        glAttachShader(ID, shader);
+    //Fixed attribute locations, so any mesh's VAO works with any program.
+    for (const gfx::AttributeBinding& binding : gfx::kAttributeBindings)
+        glBindAttribLocation(ID, binding.location, binding.name);
+    //A separable program may be linked with a single stage and mixed with others in pipelines.
+    if (separable)
+        glProgramParameteri(ID, GL_PROGRAM_SEPARABLE, GL_TRUE);
+    //Ask the driver to keep a binary we can read back for the cache.
+    if (retrievable)
+        glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(ID);
-    //After linking, the shaders are no longer needed separately, so it's safe to delete them.
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+}
+
+void ShaderProgram::build(const std::vector<Stage>& stages) {
+    //Warm start: a binary saved by an earlier run with the same sources and driver.
+    std::string cachePath = binaryCachePath(stages, separable);
+    if (!cachePath.empty() && loadBinary(cachePath))
+        return;
+
+    //we call compileShader function by supplying different second parameter to indicate different shaders.
+    for (const Stage& stage : stages)
+        pendingShaders.push_back(compileShader(stage.source, stage.type));
+    linkProgram(pendingShaders, !cachePath.empty());
+    pendingCachePath = cachePath;
+    pending = true;
+}
+
+ShaderProgram::ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath)
+    : ShaderProgram(vertexPath, fragmentPath, Deferred{}) {
+    finish();
+}
+
+ShaderProgram::ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath, Deferred)
+    : stagePaths{ { GL_VERTEX_SHADER, vertexPath }, { GL_FRAGMENT_SHADER, fragmentPath } } {
+    build({ { GL_VERTEX_SHADER, loadShaderSource(vertexPath) },
+            { GL_FRAGMENT_SHADER, loadShaderSource(fragmentPath) } });
+}
+
+ShaderProgram::ShaderProgram(const std::string& computePath)
+    : stagePaths{ { GL_COMPUTE_SHADER, computePath } } {
+    build({ { GL_COMPUTE_SHADER, loadShaderSource(computePath) } });
+    finish();
+}
+
+ShaderProgram::ShaderProgram(const std::vector<Stage>& stages, Deferred, bool separable)
+    : separable(separable) {
+    build(stages);
+}
+
+ShaderProgram::ShaderProgram(GLenum stageType, const std::string& path, Separable)
+    : separable(true), stagePaths{ { stageType, path } } {
+    build({ { stageType, loadShaderSource(path) } });
+}
+
+//Only the fragment stage is compiled here; the vertex stage is attached at the first use().
+ShaderProgram::ShaderProgram(const ShaderProgram& vertexStage, const std::string& fragmentPath, Deferred)
+    : separable(true), sharedStage(&vertexStage), stagePaths{ { GL_FRAGMENT_SHADER, fragmentPath } } {
+    build({ { GL_FRAGMENT_SHADER, loadShaderSource(fragmentPath) } });
+    glGenProgramPipelines(1, &pipeline);
+}
+
+bool ShaderProgram::supportsPipelines() {
+    return glGenProgramPipelines && glBindProgramPipeline && glUseProgramStages && glActiveShaderProgram &&
+           glProgramParameteri;
+}
+
+const std::vector<std::pair<GLenum, std::string>>& ShaderProgram::stageFiles() const {
+    return stagePaths;
+}
+
+bool ShaderProgram::isSeparable() const {
+    return separable;
+}
+
+bool ShaderProgram::adopt(ShaderProgram& replacement) {
+    if (!replacement.finish())
+        return false;   //errors were just printed by finish()
+    finish();
+    if (replacement.separable != separable) {
+        std::cerr << "ERROR::PROGRAM::RELOAD: replacement must be " << (separable ? "" : "non-")
+                  << "separable, keeping the previous program\n";
+        return false;
+    }
+
+    //VAOs are built against the engine-wide locations, which linking binds; a replacement
+    //that moves one with layout(location) would draw garbage, so keep the old one.
+    GLint attributes = 0;
+    glGetProgramiv(ID, GL_ACTIVE_ATTRIBUTES, &attributes);
+    for (GLint i = 0; i < attributes; ++i) {
+        GLchar name[256];
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveAttrib(ID, static_cast<GLuint>(i), sizeof(name), nullptr, &size, &type, name);
+        GLint before = glGetAttribLocation(ID, name), after = glGetAttribLocation(replacement.ID, name);
+        if (after != -1 && after != before) {
+            std::cerr << "ERROR::PROGRAM::RELOAD: attribute '" << name << "' moved from location "
+                      << before << " to " << after << ", keeping the previous program\n";
+            return false;
+        }
+    }
+
+    copyUniformsTo(replacement.ID);
+    glDeleteProgram(ID);
+    ID = replacement.ID;
+    isDeleted = false;
+    linked = true;
+    //The replacement no longer owns a program; its destructor deletes nothing.
+    replacement.ID = 0;
+    replacement.isDeleted = true;
+    if (pipeline)
+        glUseProgramStages(pipeline, GL_FRAGMENT_SHADER_BIT, ID);
+    return true;
+}
+
+//Copies every uniform value (and uniform block binding) this program has into the
+//same-named, same-typed uniforms of `program`: whatever was set once at startup
+//(sampler units, lights, ambient SH...) survives a reload.
+void ShaderProgram::copyUniformsTo(GLuint program) const {
+    GLint previous = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &previous);
+    glUseProgram(program);
+
+    GLint uniforms = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &uniforms);
+    for (GLint i = 0; i < uniforms; ++i) {
+        GLchar name[256];
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(ID, static_cast<GLuint>(i), sizeof(name), nullptr, &size, &type, name);
+
+        //Arrays report "name[0]"; every element has its own location.
+        std::string base = name;
+        if (size > 1 && base.size() > 3 && base.compare(base.size() - 3, 3, "[0]") == 0)
+            base.resize(base.size() - 3);
+        for (GLint element = 0; element < size; ++element) {
+            const std::string elementName = size > 1 ? base + "[" + std::to_string(element) + "]" : base;
+            GLint from = glGetUniformLocation(ID, elementName.c_str());
+            GLint to = glGetUniformLocation(program, elementName.c_str());
+            if (from == -1 || to == -1)
+                continue;   //block members, or a uniform the new code dropped
+            GLfloat f[16];
+            GLint n[4];
+            GLuint u[4];
+            switch (type) {
+                case GL_FLOAT:             glGetUniformfv(ID, from, f); glUniform1fv(to, 1, f); break;
+                case GL_FLOAT_VEC2:        glGetUniformfv(ID, from, f); glUniform2fv(to, 1, f); break;
+                case GL_FLOAT_VEC3:        glGetUniformfv(ID, from, f); glUniform3fv(to, 1, f); break;
+                case GL_FLOAT_VEC4:        glGetUniformfv(ID, from, f); glUniform4fv(to, 1, f); break;
+                case GL_FLOAT_MAT2:        glGetUniformfv(ID, from, f); glUniformMatrix2fv(to, 1, GL_FALSE, f); break;
+                case GL_FLOAT_MAT3:        glGetUniformfv(ID, from, f); glUniformMatrix3fv(to, 1, GL_FALSE, f); break;
+                case GL_FLOAT_MAT4:        glGetUniformfv(ID, from, f); glUniformMatrix4fv(to, 1, GL_FALSE, f); break;
+                case GL_FLOAT_MAT2x3:      glGetUniformfv(ID, from, f); glUniformMatrix2x3fv(to, 1, GL_FALSE, f); break;
+                case GL_FLOAT_MAT2x4:      glGetUniformfv(ID, from, f); glUniformMatrix2x4fv(to, 1, GL_FALSE, f); break;
+                case GL_FLOAT_MAT3x2:      glGetUniformfv(ID, from, f); glUniformMatrix3x2fv(to, 1, GL_FALSE, f); break;
+                case GL_FLOAT_MAT3x4:      glGetUniformfv(ID, from, f); glUniformMatrix3x4fv(to, 1, GL_FALSE, f); break;
+                case GL_FLOAT_MAT4x2:      glGetUniformfv(ID, from, f); glUniformMatrix4x2fv(to, 1, GL_FALSE, f); break;
+                case GL_FLOAT_MAT4x3:      glGetUniformfv(ID, from, f); glUniformMatrix4x3fv(to, 1, GL_FALSE, f); break;
+                case GL_INT:
+                case GL_BOOL:              glGetUniformiv(ID, from, n); glUniform1iv(to, 1, n); break;
+                case GL_INT_VEC2:
+                case GL_BOOL_VEC2:         glGetUniformiv(ID, from, n); glUniform2iv(to, 1, n); break;
+                case GL_INT_VEC3:
+                case GL_BOOL_VEC3:         glGetUniformiv(ID, from, n); glUniform3iv(to, 1, n); break;
+                case GL_INT_VEC4:
+                case GL_BOOL_VEC4:         glGetUniformiv(ID, from, n); glUniform4iv(to, 1, n); break;
+                case GL_UNSIGNED_INT:      glGetUniformuiv(ID, from, u); glUniform1uiv(to, 1, u); break;
+                case GL_UNSIGNED_INT_VEC2: glGetUniformuiv(ID, from, u); glUniform2uiv(to, 1, u); break;
+                case GL_UNSIGNED_INT_VEC3: glGetUniformuiv(ID, from, u); glUniform3uiv(to, 1, u); break;
+                case GL_UNSIGNED_INT_VEC4: glGetUniformuiv(ID, from, u); glUniform4uiv(to, 1, u); break;
+                default:
+                    if (isSamplerType(type)) {
+                        glGetUniformiv(ID, from, n); glUniform1iv(to, 1, n);
+                    } else {
+                        //doubles, images...: nothing here sets them, so say so rather than guess
+                        std::cerr << "Warning: uniform '" << elementName << "' has a type reload does not copy (0x"
+                                  << std::hex << type << std::dec << ")\n";
+                    }
+                    break;
+            }
+        }
+    }
+
+    GLint blocks = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCKS, &blocks);
+    for (GLint i = 0; i < blocks; ++i) {
+        GLchar name[256];
+        glGetActiveUniformBlockName(ID, static_cast<GLuint>(i), sizeof(name), nullptr, name);
+        GLuint target = glGetUniformBlockIndex(program, name);
+        if (target == GL_INVALID_INDEX)
+            continue;
+        GLint binding = 0;
+        glGetActiveUniformBlockiv(ID, static_cast<GLuint>(i), GL_UNIFORM_BLOCK_BINDING, &binding);
+        glUniformBlockBinding(program, target, static_cast<GLuint>(binding));
+    }
+
+    glUseProgram(static_cast<GLuint>(previous) == ID ? program : static_cast<GLuint>(previous));
+}
+
+bool ShaderProgram::isReady() const {
+    if (!pending)
+        return !sharedStage || sharedStage->isReady();
+    //Without the extension there is no way to ask without waiting, so report
+    //ready and let the first use block as it always did.
+    static const bool canPoll = gfx::hasGLExtension("GL_KHR_parallel_shader_compile") ||
+                                gfx::hasGLExtension("GL_ARB_parallel_shader_compile");
+    if (!canPoll)
+        return true;
+    GLint done = GL_FALSE;
+    glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &done);
+    return done == GL_TRUE && (!sharedStage || sharedStage->isReady());
+}
+
+bool ShaderProgram::finish() const {
+    if (!pending)
+        return linked;
+    pending = false;
 
     GLint success;
     GLchar infoLog[512];
+    for (GLuint shader : pendingShaders) {
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            glGetShaderInfoLog(shader, 512, nullptr, infoLog);
+            std::cerr << "ERROR::SHADER::COMPILATION_FAILED\n" << infoLog << "\n";
+        }
+    }
     glGetProgramiv(ID, GL_LINK_STATUS, &success);
     if (!success) {
         glGetProgramInfoLog(ID, 512, nullptr, infoLog);
         std::cerr << "ERROR::PROGRAM::LINKING_FAILED\n" << infoLog << "\n";
     }
+    //After linking, the shaders are no longer needed separately, so it's safe to delete them.
+    for (GLuint shader : pendingShaders)
+        glDeleteShader(shader);
+    pendingShaders.clear();
+
+    linked = success == GL_TRUE;
+    if (linked && !pendingCachePath.empty())
+        saveBinary(pendingCachePath);
+    return linked;
 }
 
-ShaderProgram::ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath) {
-    std::string vertexCode = loadShaderSource(vertexPath);
-    std::string fragmentCode = loadShaderSource(fragmentPath);
+void ShaderProgram::enableBinaryCache(const std::string& cacheDir) {
+    if (!glGetProgramBinary || !glProgramBinary || !glProgramParameteri)
+        return;
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats <= 0)
+        return;     //driver can't save programs at all
+    std::error_code ec;
+    std::filesystem::create_directories(cacheDir, ec);
+    binaryCacheDir = cacheDir;
+}
 
-    //we call compileShader function by supplying different second parameter to indicate different shaders.
-    GLuint vertexShader = compileShader(vertexCode, GL_VERTEX_SHADER);
-    GLuint fragmentShader = compileShader(fragmentCode, GL_FRAGMENT_SHADER);
+//The key covers the exact stage sources (so any defines or includes baked into them)
+//and the driver identity: binaries are only valid for the driver that produced them.
+std::string ShaderProgram::binaryCachePath(const std::vector<Stage>& stages, bool separable) {
+    if (binaryCacheDir.empty())
+        return "";
+    uint64_t hash = gfx::hashBytes(&kBinaryVersion, sizeof(kBinaryVersion));
+    if (separable)
+        hash = gfx::hashString("separable", hash);
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+        const char* value = reinterpret_cast<const char*>(glGetString(name));
+        hash = gfx::hashString(value ? value : "", hash);
+    }
+    for (const Stage& stage : stages) {
+        if (stage.source.empty())
+            return "";  //unreadable file: compile (and report) without caching
+        hash = gfx::hashBytes(&stage.type, sizeof(stage.type), hash);
+        hash = gfx::hashString(stage.source, hash);
+    }
+    return (std::filesystem::path(binaryCacheDir) / (gfx::hashName(hash) + ".glbin")).string();
+}
+
+bool ShaderProgram::loadBinary(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in)
+        return false;
+    const size_t fileSize = static_cast<size_t>(in.tellg());
+    in.seekg(0);
+    uint32_t magic = 0, version = 0, format = 0;
+    in.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    in.read(reinterpret_cast<char*>(&version), sizeof(version));
+    in.read(reinterpret_cast<char*>(&format), sizeof(format));
+    if (!in || magic != kBinaryMagic || version != kBinaryVersion || fileSize <= 12)
+        return false;
+    std::vector<char> binary(fileSize - 12);
+    if (!in.read(binary.data(), static_cast<std::streamsize>(binary.size())))
+        return false;
 
-    linkProgram(vertexShader, fragmentShader);
+    ID = glCreateProgram();
+    glProgramBinary(ID, format, binary.data(), static_cast<GLsizei>(binary.size()));
+    GLint success = GL_FALSE;
+    glGetProgramiv(ID, GL_LINK_STATUS, &success);
+    if (success == GL_TRUE) {
+        linked = true;
+        return true;
+    }
+
+    //Rejected (driver update, different GPU...): drop it and compile from source.
+    glDeleteProgram(ID);
+    ID = 0;
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    return false;
+}
+
+void ShaderProgram::saveBinary(const std::string& path) const {
+    GLint length = 0;
+    glGetProgramiv(ID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+    std::vector<char> binary(static_cast<size_t>(length));
+    GLenum format = 0;
+    glGetProgramBinary(ID, length, nullptr, &format, binary.data());
+
+    //Write then rename so a concurrent run never reads a partial file.
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary);
+        if (!out)
+            return;
+        uint32_t header[3] = { kBinaryMagic, kBinaryVersion, format };
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        out.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+        if (!out)
+            return;
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp, path, ec);
 }
 
 //This is the destructor of the ShaderProgram class.
@@ -84,13 +405,44 @@ ShaderProgram::~ShaderProgram() {
 }
 
 //This method activates the shader program so that OpenGL uses it for rendering.
+//A pipeline is bound with no program in use (a used program overrides any pipeline),
+//and its own stage is made the active program so plain glUniform* calls land there.
 void ShaderProgram::use() const {
-    glUseProgram(ID);
+    finish();
+    if (!pipeline) {
+        glUseProgram(ID);
+        return;
+    }
+    attachStages();
+    glUseProgram(0);
+    glBindProgramPipeline(pipeline);
+    glActiveShaderProgram(pipeline, ID);
 }
 
 //This is a getter method that returns the shader program's ID.
+//For a pipeline that is the vertex stage: callers want it for attribute locations.
 GLuint ShaderProgram::getID() const {
-    return ID;
+    finish();
+    return sharedStage ? sharedStage->getID() : ID;
+}
+
+//(Re)attaches the shared stage when it changed: first use, or a hot reload swapped
+//its program. Validation catches vertex outputs the fragment stage can't match.
+void ShaderProgram::attachStages() const {
+    const GLuint stage = sharedStage->getID();
+    if (stage == attachedStage)
+        return;
+    attachedStage = stage;
+    glUseProgramStages(pipeline, GL_VERTEX_SHADER_BIT, stage);
+    glUseProgramStages(pipeline, GL_FRAGMENT_SHADER_BIT, ID);
+    glValidateProgramPipeline(pipeline);
+    GLint valid = GL_FALSE;
+    glGetProgramPipelineiv(pipeline, GL_VALIDATE_STATUS, &valid);
+    if (!valid) {
+        GLchar infoLog[512] = {};
+        glGetProgramPipelineInfoLog(pipeline, 512, nullptr, infoLog);
+        std::cerr << "ERROR::PIPELINE::VALIDATION_FAILED\n" << infoLog << "\n";
+    }
 }
 
 //This method cleans up the shader program by deleting it from OpenGL.
@@ -103,42 +455,99 @@ void ShaderProgram::destroy() {
         ID = 0;
         isDeleted = true;
     }
+    if (pipeline != 0) {
+        glDeleteProgramPipelines(1, &pipeline);
+        pipeline = 0;
+    }
 }
-void ShaderProgram::setUniform(const std::string& name, int value) const {
+//A pipeline looks in its own stage, then the shared one, and makes the stage that
+//declares the uniform the active program for the glUniform* call that follows.
+GLint ShaderProgram::uniformLocation(const std::string& name) const {
+    finish();
     GLint location = glGetUniformLocation(ID, name.c_str());
-    if (location == -1) {
+    if (pipeline) {
+        GLuint owner = ID;
+        if (location == -1) {
+            owner = sharedStage->getID();
+            location = glGetUniformLocation(owner, name.c_str());
+        }
+        glActiveShaderProgram(pipeline, owner);
+    }
+    if (location == -1)
         std::cerr << "Warning: uniform '" << name << "' not found in shader.\n";
+    return location;
+}
+
+void ShaderProgram::setUniform(const std::string& name, int value) const {
+    GLint location = uniformLocation(name);
+    if (location == -1)
         return;
-    }
     glUniform1i(location, value);
 }
 
 void ShaderProgram::setUniform(const std::string& name, float value) const {
-    GLint location = glGetUniformLocation(ID, name.c_str());
-    if (location == -1) {
-        std::cerr << "Warning: uniform '" << name << "' not found in shader.\n";
+    GLint location = uniformLocation(name);
+    if (location == -1)
         return;
-    }
     glUniform1f(location, value);
 }
 
+void ShaderProgram::setUniform(const std::string& name, const glm::vec2& value) const {
+    GLint location = uniformLocation(name);
+    if (location == -1)
+        return;
+    glUniform2fv(location, 1, glm::value_ptr(value));
+}
+
+void ShaderProgram::setUniform(const std::string& name, const glm::ivec2& value) const {
+    GLint location = uniformLocation(name);
+    if (location == -1)
+        return;
+    glUniform2iv(location, 1, glm::value_ptr(value));
+}
+
 void ShaderProgram::setUniform(const std::string& name, const glm::vec3& value) const {
-    GLint location = glGetUniformLocation(ID, name.c_str());
-    if (location == -1) {
-        std::cerr << "Warning: uniform '" << name << "' not found in shader.\n";
+    GLint location = uniformLocation(name);
+    if (location == -1)
         return;
-    }
     glUniform3fv(location, 1, glm::value_ptr(value));
 }
 
+void ShaderProgram::setUniform(const std::string& name, const glm::vec4& value) const {
+    GLint location = uniformLocation(name);
+    if (location == -1)
+        return;
+    glUniform4fv(location, 1, glm::value_ptr(value));
+}
+
+void ShaderProgram::setUniform(const std::string& name, const glm::uvec3& value) const {
+    GLint location = uniformLocation(name);
+    if (location == -1)
+        return;
+    glUniform3uiv(location, 1, glm::value_ptr(value));
+}
+
 void ShaderProgram::setUniform(const std::string& name, const glm::mat4& value) const {
-    GLint location = glGetUniformLocation(ID, name.c_str());
-    if (location == -1) {
-        std::cerr << "Warning: uniform '" << name << "' not found in shader.\n";
+    GLint location = uniformLocation(name);
+    if (location == -1)
         return;
-    }
     glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
 }
+void ShaderProgram::setUniform(const std::string& name, const glm::vec3* values, int count) const {
+    GLint location = uniformLocation(name);
+    if (location == -1)
+        return;
+    glUniform3fv(location, count, glm::value_ptr(values[0]));
+}
+void ShaderProgram::bindUniformBlock(const std::string& name, GLuint binding) const {
+    finish();
+    GLuint block = glGetUniformBlockIndex(ID, name.c_str());
+    if (block == GL_INVALID_INDEX) {
+        std::cerr << "Warning: uniform block '" << name << "' not found in shader.\n";
+        return;
+    }
+    glUniformBlockBinding(ID, block, binding);
+}
 GLuint ShaderProgram::bindTexture2D(const std::string& samplerName,
                                     const std::string& filePath,
                                     GLint textureUnit,
@@ -153,38 +562,28 @@ GLuint ShaderProgram::bindTexture2D(const std::string& samplerName,
         return 0;
     }
 
-    // Ensure we set uniforms on the correct program
-    use();
+    return bindTexture2D(samplerName, gfx::loadImage(filePath, flipVertical), textureUnit,
+                         wrap, minFilter, magFilter, generateMipmaps);
+}
 
-    stbi_set_flip_vertically_on_load(flipVertical ? 1 : 0);
-    int w = 0, h = 0, ch = 0;
-    unsigned char* data = stbi_load(filePath.c_str(), &w, &h, &ch, 0);
-    if (!data) {
-        std::cerr << "Failed to load texture: " << filePath << "\n";
+GLuint ShaderProgram::bindTexture2D(const std::string& samplerName,
+                                    const gfx::Image& image,
+                                    GLint textureUnit,
+                                    GLint wrap,
+                                    GLint minFilter,
+                                    GLint magFilter,
+                                    bool generateMipmaps) const
+{
+    if (!image.valid()) {
+        std::cerr << "Failed to load texture: " << image.path << "\n";
         return 0;
     }
 
-    GLenum srcFormat = GL_RGB;
-    GLint  internal  = GL_RGB;
-    if (ch == 4) { srcFormat = GL_RGBA; internal = GL_RGBA; }
-    else if (ch == 3) { srcFormat = GL_RGB; internal = GL_RGB; }
-    else if (ch == 1) { srcFormat = GL_RED; internal = GL_RED; }
-
-    GLuint texID = 0;
-    glGenTextures(1, &texID);
+    // Ensure we set uniforms on the correct program
+    use();
 
     glActiveTexture(GL_TEXTURE0 + textureUnit);
-    glBindTexture(GL_TEXTURE_2D, texID);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, internal, w, h, 0, srcFormat, GL_UNSIGNED_BYTE, data);
-    if (generateMipmaps) glGenerateMipmap(GL_TEXTURE_2D);
-
-    stbi_image_free(data);
+    GLuint texID = gfx::uploadTexture2D(image, gfx::SamplerParams{ wrap, minFilter, magFilter, generateMipmaps });
 
     // bind sampler uniform to this unit
     GLint loc = glGetUniformLocation(ID, samplerName.c_str());
@@ -205,40 +604,24 @@ GLuint ShaderProgram::bindCubeMap(const std::string& samplerName,
                    GLint minFilter,
                    GLint magFilter) const{
 
-    use();
-    stbi_set_flip_vertically_on_load(flipVertical? 1 : 0);
-
-    GLuint texID = 0;
-    glGenTextures(1, &texID);
-
-    glActiveTexture(GL_TEXTURE0 + textureUnit);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, texID);
-
-    int w = 0, h = 0, ch = 0;
-    for(int i = 0; i < faces.size(); ++i){
-        unsigned char* data = stbi_load(faces[i].c_str(), &w, &h, &ch, 0);
-        if(!data){
-            std::cerr << "Failed to load cubmap face: " << faces[i] << std::endl;
-            break;
-        }
-        GLenum srcFormat = GL_RGB;
-        GLint  internal  = GL_RGB;
-        if (ch == 4) { srcFormat = GL_RGBA; internal = GL_RGBA; }
-        else if (ch == 3) { srcFormat = GL_RGB; internal = GL_RGB; }
-        else if (ch == 1) { srcFormat = GL_RED; internal = GL_RED; }
+    // All faces decode concurrently; only the upload below touches GL
+    return bindCubeMap(samplerName, gfx::loadImages(faces, flipVertical), textureUnit,
+                       wrap, minFilter, magFilter);
+}
 
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(i),
-                     0, internal, w, h, 0,
-                     srcFormat, GL_UNSIGNED_BYTE, data);
+GLuint ShaderProgram::bindCubeMap(const std::string& samplerName,
+                   const std::vector<gfx::Image>& faces,
+                   GLint textureUnit,
+                   GLint wrap,
+                   GLint minFilter,
+                   GLint magFilter) const{
 
-        stbi_image_free(data);
-    }
+    use();
 
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, wrap);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, wrap);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, wrap);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, minFilter);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, magFilter);
+    glActiveTexture(GL_TEXTURE0 + textureUnit);
+    // Mip chain only when the filter samples it
+    bool mipmaps = minFilter != GL_LINEAR && minFilter != GL_NEAREST;
+    GLuint texID = gfx::uploadCubeMap(faces, gfx::SamplerParams{ wrap, minFilter, magFilter, mipmaps });
 
     GLint loc = glGetUniformLocation(ID, samplerName.c_str());
     if(loc >= 0){
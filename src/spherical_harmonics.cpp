@@ -0,0 +1,278 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "spherical_harmonics.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+
+#include "shaderprogram.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GFX_SH_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace gfx {
+
+    namespace {
+        constexpr double kPi = 3.14159265358979323846;
+
+        // Real SH basis constants, same order as SH9
+        constexpr double kY00 = 0.282094791773878;     // 1 / (2 sqrt(pi))
+        constexpr double kY1  = 0.488602511902920;     // sqrt(3 / (4 pi))
+        constexpr double kY2  = 1.092548430592079;     // sqrt(15 / (4 pi))
+        constexpr double kY20 = 0.315391565252520;     // sqrt(5 / (16 pi))
+        constexpr double kY22 = 0.546274215296040;     // sqrt(15 / (16 pi))
+
+        struct Accumulator {
+            double c[9][3] = {};
+            double weight = 0.0;
+        };
+
+        const float* srgbToLinear()
+        {
+            static const auto table = [] {
+                std::array<float, 256> t{};
+                for (int i = 0; i < 256; ++i) {
+                    double c = i / 255.0;
+                    t[i] = static_cast<float>(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+                }
+                return t;
+            }();
+            return table.data();
+        }
+
+        // Face axes from the GL cube map table: direction = major + sc * s + tc * t
+        struct FaceFrame { glm::vec3 major, s, t; };
+        const FaceFrame kFaces[6] = {
+            { {  1,  0,  0 }, {  0,  0, -1 }, { 0, -1,  0 } },
+            { { -1,  0,  0 }, {  0,  0,  1 }, { 0, -1,  0 } },
+            { {  0,  1,  0 }, {  1,  0,  0 }, { 0,  0,  1 } },
+            { {  0, -1,  0 }, {  1,  0,  0 }, { 0,  0, -1 } },
+            { {  0,  0,  1 }, {  1,  0,  0 }, { 0, -1,  0 } },
+            { {  0,  0, -1 }, { -1,  0,  0 }, { 0, -1,  0 } },
+        };
+
+        // Per-row sums; the totals are kept in double
+        struct RowSums {
+            float r[9] = {}, g[9] = {}, b[9] = {};
+            double weight = 0.0;
+        };
+
+        struct RowSetup {
+            const unsigned char* pixels;
+            int width;
+            int channels;
+            float tc;
+            float du;
+            float texelArea;
+            glm::vec3 origin;   // face major axis + tc * t
+            glm::vec3 axis;     // face s axis
+        };
+
+        // Texels [first, last) of one row
+        void accumulateTexels(const RowSetup& row, int first, int last, const float* toLinear, RowSums& sums)
+        {
+            const int gOffset = row.channels >= 3 ? 1 : 0, bOffset = row.channels >= 3 ? 2 : 0;
+            for (int x = first; x < last; ++x) {
+                const float sc = -1.0f + (x + 0.5f) * row.du;
+                // A texel at distance l from the cube center subtends area * cos / l^2 = area / l^3
+                const float invLength = 1.0f / std::sqrt(1.0f + sc * sc + row.tc * row.tc);
+                const float dw = row.texelArea * invLength * invLength * invLength;
+                const float dx = (row.origin.x + row.axis.x * sc) * invLength;
+                const float dy = (row.origin.y + row.axis.y * sc) * invLength;
+                const float dz = (row.origin.z + row.axis.z * sc) * invLength;
+
+                const unsigned char* p = row.pixels + static_cast<size_t>(x) * row.channels;
+                const float r = toLinear[p[0]] * dw, g = toLinear[p[gOffset]] * dw, b = toLinear[p[bOffset]] * dw;
+
+                const float basis[9] = {
+                    float(kY00),
+                    float(kY1) * dy, float(kY1) * dz, float(kY1) * dx,
+                    float(kY2) * dx * dy, float(kY2) * dy * dz, float(kY20) * (3.0f * dz * dz - 1.0f),
+                    float(kY2) * dx * dz, float(kY22) * (dx * dx - dy * dy)
+                };
+                for (int i = 0; i < 9; ++i) {
+                    sums.r[i] += basis[i] * r;
+                    sums.g[i] += basis[i] * g;
+                    sums.b[i] += basis[i] * b;
+                }
+                sums.weight += dw;
+            }
+        }
+
+#ifdef GFX_SH_SSE2
+        float horizontalSum(__m128 v)
+        {
+            alignas(16) float lanes[4];
+            _mm_store_ps(lanes, v);
+            return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        }
+
+        // Four texels per step; returns the first texel left for the scalar loop
+        int accumulateTexelsSse2(const RowSetup& row, const float* toLinear, RowSums& sums)
+        {
+            const int c = row.channels;
+            const int gOffset = c >= 3 ? 1 : 0, bOffset = c >= 3 ? 2 : 0;
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128 lane = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+            const __m128 du = _mm_set1_ps(row.du), area = _mm_set1_ps(row.texelArea);
+            const __m128 tc2 = _mm_set1_ps(1.0f + row.tc * row.tc);
+            const __m128 ox = _mm_set1_ps(row.origin.x), oy = _mm_set1_ps(row.origin.y), oz = _mm_set1_ps(row.origin.z);
+            const __m128 ax = _mm_set1_ps(row.axis.x), ay = _mm_set1_ps(row.axis.y), az = _mm_set1_ps(row.axis.z);
+            const __m128 y00 = _mm_set1_ps(float(kY00)), y1 = _mm_set1_ps(float(kY1)), y2 = _mm_set1_ps(float(kY2));
+            const __m128 y20 = _mm_set1_ps(float(kY20)), y22 = _mm_set1_ps(float(kY22)), three = _mm_set1_ps(3.0f);
+
+            __m128 accR[9], accG[9], accB[9], accW = _mm_setzero_ps();
+            for (int i = 0; i < 9; ++i)
+                accR[i] = accG[i] = accB[i] = _mm_setzero_ps();
+
+            int x = 0;
+            for (; x + 4 <= row.width; x += 4) {
+                const __m128 sc = _mm_sub_ps(_mm_mul_ps(_mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lane), du), one);
+                const __m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(tc2, _mm_mul_ps(sc, sc))));
+                const __m128 dw = _mm_mul_ps(area, _mm_mul_ps(invLength, _mm_mul_ps(invLength, invLength)));
+                const __m128 dx = _mm_mul_ps(_mm_add_ps(ox, _mm_mul_ps(ax, sc)), invLength);
+                const __m128 dy = _mm_mul_ps(_mm_add_ps(oy, _mm_mul_ps(ay, sc)), invLength);
+                const __m128 dz = _mm_mul_ps(_mm_add_ps(oz, _mm_mul_ps(az, sc)), invLength);
+
+                const unsigned char* p = row.pixels + static_cast<size_t>(x) * c;
+                const __m128 r = _mm_mul_ps(dw, _mm_setr_ps(toLinear[p[0]], toLinear[p[c]], toLinear[p[2 * c]], toLinear[p[3 * c]]));
+                const __m128 g = _mm_mul_ps(dw, _mm_setr_ps(toLinear[p[gOffset]], toLinear[p[c + gOffset]],
+                                                             toLinear[p[2 * c + gOffset]], toLinear[p[3 * c + gOffset]]));
+                const __m128 b = _mm_mul_ps(dw, _mm_setr_ps(toLinear[p[bOffset]], toLinear[p[c + bOffset]],
+                                                             toLinear[p[2 * c + bOffset]], toLinear[p[3 * c + bOffset]]));
+
+                const __m128 basis[9] = {
+                    y00,
+                    _mm_mul_ps(y1, dy), _mm_mul_ps(y1, dz), _mm_mul_ps(y1, dx),
+                    _mm_mul_ps(y2, _mm_mul_ps(dx, dy)), _mm_mul_ps(y2, _mm_mul_ps(dy, dz)),
+                    _mm_mul_ps(y20, _mm_sub_ps(_mm_mul_ps(three, _mm_mul_ps(dz, dz)), one)),
+                    _mm_mul_ps(y2, _mm_mul_ps(dx, dz)), _mm_mul_ps(y22, _mm_sub_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)))
+                };
+                for (int i = 0; i < 9; ++i) {
+                    accR[i] = _mm_add_ps(accR[i], _mm_mul_ps(basis[i], r));
+                    accG[i] = _mm_add_ps(accG[i], _mm_mul_ps(basis[i], g));
+                    accB[i] = _mm_add_ps(accB[i], _mm_mul_ps(basis[i], b));
+                }
+                accW = _mm_add_ps(accW, dw);
+            }
+            for (int i = 0; i < 9; ++i) {
+                sums.r[i] += horizontalSum(accR[i]);
+                sums.g[i] += horizontalSum(accG[i]);
+                sums.b[i] += horizontalSum(accB[i]);
+            }
+            sums.weight += horizontalSum(accW);
+            return x;
+        }
+#endif
+
+        void accumulateRows(const Image& image, int face, int firstRow, int lastRow, Accumulator& out)
+        {
+            const float* toLinear = srgbToLinear();
+            const FaceFrame& frame = kFaces[face];
+            RowSetup row;
+            row.width = image.width;
+            row.channels = image.channels;
+            row.du = 2.0f / image.width;
+            row.texelArea = row.du * (2.0f / image.height);
+            row.axis = frame.s;
+
+            for (int y = firstRow; y < lastRow; ++y) {
+                row.pixels = image.pixels.get() + static_cast<size_t>(y) * image.width * image.channels;
+                row.tc = -1.0f + (y + 0.5f) * (2.0f / image.height);
+                row.origin = frame.major + frame.t * row.tc;
+
+                RowSums sums;
+                int x = 0;
+#ifdef GFX_SH_SSE2
+                x = accumulateTexelsSse2(row, toLinear, sums);
+#endif
+                accumulateTexels(row, x, row.width, toLinear, sums);
+
+                for (int i = 0; i < 9; ++i) {
+                    out.c[i][0] += sums.r[i];
+                    out.c[i][1] += sums.g[i];
+                    out.c[i][2] += sums.b[i];
+                }
+                out.weight += sums.weight;
+            }
+        }
+    }
+
+    SH9 projectCubeMap(const std::vector<Image>& faces, ThreadPool& pool)
+    {
+        SH9 result;
+        if (faces.size() != 6) {
+            std::cerr << "SH projection needs 6 cube faces, got " << faces.size() << "\n";
+            return result;
+        }
+        for (const Image& face : faces)
+            if (!face.valid() || face.width != face.height) {
+                std::cerr << "SH projection skipped: invalid or non-square cube face " << face.path << "\n";
+                return result;
+            }
+
+        // Work items are bands of rows; faces may differ in size
+        constexpr int kBandRows = 16;
+        struct Band { int face, first, last; };
+        std::vector<Band> bands;
+        for (int f = 0; f < 6; ++f)
+            for (int y = 0; y < faces[f].height; y += kBandRows)
+                bands.push_back({ f, y, std::min(faces[f].height, y + kBandRows) });
+
+        Accumulator total;
+        std::mutex mutex;
+        pool.parallelFor(0, bands.size(), 1, [&](size_t begin, size_t end) {
+            Accumulator local;
+            for (size_t i = begin; i < end; ++i)
+                accumulateRows(faces[bands[i].face], bands[i].face, bands[i].first, bands[i].last, local);
+            std::lock_guard<std::mutex> lock(mutex);
+            for (int i = 0; i < 9; ++i)
+                for (int ch = 0; ch < 3; ++ch)
+                    total.c[i][ch] += local.c[i][ch];
+            total.weight += local.weight;
+        });
+
+        // Texel solid angles sum to almost exactly 4 pi; renormalise the remainder away
+        const double norm = total.weight > 0.0 ? 4.0 * kPi / total.weight : 0.0;
+        for (int i = 0; i < 9; ++i)
+            result.c[i] = glm::vec3(static_cast<float>(total.c[i][0] * norm),
+                                    static_cast<float>(total.c[i][1] * norm),
+                                    static_cast<float>(total.c[i][2] * norm));
+        return result;
+    }
+
+    SH9 irradianceCoefficients(const SH9& radiance)
+    {
+        // Cosine lobe per band (pi, 2pi/3, pi/4), divided by pi for Lambert
+        const double band[3] = { 1.0, 2.0 / 3.0, 0.25 };
+        const double basis[9] = { kY00, kY1, kY1, kY1, kY2, kY2, kY20, kY2, kY22 };
+        SH9 out;
+        for (int i = 0; i < 9; ++i) {
+            const int l = i == 0 ? 0 : (i < 4 ? 1 : 2);
+            out.c[i] = radiance.c[i] * static_cast<float>(band[l] * basis[i]);
+        }
+        return out;
+    }
+
+    glm::vec3 evaluateIrradiance(const SH9& k, const glm::vec3& n)
+    {
+        return k.c[0]
+             + k.c[1] * n.y + k.c[2] * n.z + k.c[3] * n.x
+             + k.c[4] * (n.x * n.y) + k.c[5] * (n.y * n.z) + k.c[6] * (3.0f * n.z * n.z - 1.0f)
+             + k.c[7] * (n.x * n.z) + k.c[8] * (n.x * n.x - n.y * n.y);
+    }
+
+    void applyAmbientSH(ShaderProgram& shader, const SH9& coefficients, float intensity, const std::string& name)
+    {
+        std::array<glm::vec3, 9> scaled;
+        for (int i = 0; i < 9; ++i)
+            scaled[i] = coefficients.c[i] * intensity;
+        shader.use();
+        shader.setUniform(name, scaled.data(), 9);
+    }
+
+} // namespace gfx
@@ -0,0 +1,177 @@
+//
+// Created by dengq on 10/19/26.
+//
+
+#include "startup_graph.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+
+namespace gfx {
+
+    StartupGraph::TaskId StartupGraph::cpu(const std::string& name, std::function<void()> fn,
+                                           const std::vector<TaskId>& after)
+    {
+        return add_(name, false, std::move(fn), after);
+    }
+
+    StartupGraph::TaskId StartupGraph::gl(const std::string& name, std::function<void()> fn,
+                                          const std::vector<TaskId>& after)
+    {
+        return add_(name, true, std::move(fn), after);
+    }
+
+    StartupGraph::TaskId StartupGraph::add_(const std::string& name, bool onContext, std::function<void()> fn,
+                                            const std::vector<TaskId>& after)
+    {
+        const TaskId id = static_cast<TaskId>(tasks.size());
+        Task task;
+        task.name = name;
+        task.onContext = onContext;
+        task.fn = std::move(fn);
+        for (TaskId dependency : after) {
+            if (dependency < 0 || dependency >= id) {
+                std::cerr << "Startup task " << name << ": ignoring dependency on unknown task " << dependency << "\n";
+                continue;
+            }
+            task.after.push_back(dependency);
+            tasks[dependency].dependents.push_back(id);
+        }
+        tasks.push_back(std::move(task));
+        return id;
+    }
+
+    void StartupGraph::execute_(TaskId id)
+    {
+        Task& task = tasks[id];
+        task.start = Clock::now();
+        // Dependencies are complete and no longer written, so reading their errors is safe
+        for (TaskId dependency : task.after)
+            if (!tasks[dependency].error.empty()) {
+                task.error = "skipped, " + tasks[dependency].name + " failed";
+                return;
+            }
+        try {
+            task.fn();
+        } catch (const std::exception& e) {
+            task.error = e.what();
+            if (task.error.empty())
+                task.error = "exception";
+        } catch (...) {
+            task.error = "unknown exception";
+        }
+    }
+
+    bool StartupGraph::run(ThreadPool& pool)
+    {
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::deque<TaskId> contextReady;
+        size_t remaining = tasks.size();
+        started = Clock::now();
+
+        // Called with `mutex` held
+        std::function<void(TaskId)> schedule;
+        auto complete = [&](TaskId id) {
+            tasks[id].end = Clock::now();
+            for (TaskId dependent : tasks[id].dependents)
+                if (--tasks[dependent].waiting == 0)
+                    schedule(dependent);
+            --remaining;
+            changed.notify_all();
+        };
+        schedule = [&](TaskId id) {
+            if (tasks[id].onContext) {
+                contextReady.push_back(id);
+                return;
+            }
+            pool.submit([&, id]() {
+                execute_(id);
+                std::lock_guard<std::mutex> lock(mutex);
+                complete(id);
+            });
+        };
+
+        std::unique_lock<std::mutex> lock(mutex);
+        for (Task& task : tasks)
+            task.waiting = static_cast<int>(task.after.size());
+        for (TaskId id = 0; id < static_cast<TaskId>(tasks.size()); ++id)
+            if (tasks[id].waiting == 0)
+                schedule(id);
+
+        while (remaining > 0) {
+            changed.wait(lock, [&]() { return remaining == 0 || !contextReady.empty(); });
+            if (contextReady.empty())
+                break;
+            const TaskId id = contextReady.front();
+            contextReady.pop_front();
+            lock.unlock();
+            execute_(id);
+            lock.lock();
+            complete(id);
+        }
+        finished = Clock::now();
+
+        bool ok = true;
+        for (const Task& task : tasks)
+            if (!task.error.empty()) {
+                std::cerr << "Startup task " << task.name << ": " << task.error << "\n";
+                ok = false;
+            }
+        return ok;
+    }
+
+    double StartupGraph::ms_(Clock::time_point t) const
+    {
+        return std::chrono::duration<double, std::milli>(t - started).count();
+    }
+
+    void StartupGraph::printTimings(std::ostream& out) const
+    {
+        std::vector<TaskId> order(tasks.size());
+        for (TaskId id = 0; id < static_cast<TaskId>(tasks.size()); ++id)
+            order[id] = id;
+        std::sort(order.begin(), order.end(), [&](TaskId a, TaskId b) { return tasks[a].start < tasks[b].start; });
+
+        // Longest chain by task time; ids are topologically ordered already
+        std::vector<double> chain(tasks.size(), 0.0);
+        std::vector<TaskId> via(tasks.size(), -1);
+        double busy = 0.0;
+        TaskId last = -1;
+        for (TaskId id = 0; id < static_cast<TaskId>(tasks.size()); ++id) {
+            const Task& task = tasks[id];
+            for (TaskId dependency : task.after)
+                if (chain[dependency] > chain[id]) {
+                    chain[id] = chain[dependency];
+                    via[id] = dependency;
+                }
+            const double duration = ms_(task.end) - ms_(task.start);
+            chain[id] += duration;
+            busy += duration;
+            if (last < 0 || chain[id] > chain[last])
+                last = id;
+        }
+
+        char line[160];
+        out << "Startup: " << tasks.size() << " tasks\n";
+        for (TaskId id : order) {
+            const Task& task = tasks[id];
+            std::snprintf(line, sizeof(line), "  %-28s %-3s start %8.1f ms  took %8.1f ms%s\n", task.name.c_str(),
+                          task.onContext ? "gl" : "cpu", ms_(task.start), ms_(task.end) - ms_(task.start),
+                          task.error.empty() ? "" : "  (failed)");
+            out << line;
+        }
+        std::string path;
+        for (TaskId id = last; id >= 0; id = via[id])
+            path = tasks[id].name + (path.empty() ? "" : " -> " + path);
+        std::snprintf(line, sizeof(line), "  wall %.1f ms, tasks %.1f ms, critical path %.1f ms\n",
+                      ms_(finished), busy, last >= 0 ? chain[last] : 0.0);
+        out << line << "  critical path: " << path << "\n";
+    }
+
+} // namespace gfx
@@ -0,0 +1,204 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "static_batch.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <ostream>
+#include <tuple>
+#include <unordered_set>
+
+namespace gfx {
+
+    StaticBatcher::StaticBatcher(float chunkSize)
+        : chunkSize(chunkSize) {}
+
+    StaticBatcher::~StaticBatcher()
+    {
+        cleanup();
+    }
+
+    int StaticBatcher::addMaterial()
+    {
+        batches.emplace_back();
+        return static_cast<int>(batches.size()) - 1;
+    }
+
+    void StaticBatcher::add(const Mesh& mesh, const glm::mat4& model, int material)
+    {
+        pending.push_back(Placement { &mesh, model, material });
+    }
+
+    void StaticBatcher::build(ThreadPool& pool)
+    {
+        statistics = Stats{};
+        statistics.objects = pending.size();
+
+        std::unordered_set<const Mesh*> sources;
+        for (const auto& p : pending)
+            if (sources.insert(p.mesh).second)
+                statistics.sourceBytes += p.mesh->getVertices().byteSize()
+                                        + p.mesh->getIndices().size() * sizeof(unsigned int);
+
+        for (int material = 0; material < static_cast<int>(batches.size()); ++material) {
+            Batch& batch = batches[material];
+
+            // Bucket this material's objects by grid cell of their world center
+            using Cell = std::tuple<int, int, int>;
+            std::map<Cell, std::vector<const Placement*>> cells;
+            for (const auto& p : pending) {
+                if (p.material != material) continue;
+                glm::vec3 c = transformAABB(p.mesh->getBounds(), p.model).center() / chunkSize;
+                cells[Cell(static_cast<int>(std::floor(c.x)),
+                           static_cast<int>(std::floor(c.y)),
+                           static_cast<int>(std::floor(c.z)))].push_back(&p);
+            }
+            if (cells.empty()) continue;
+
+            // Lay objects out cell by cell; record each one's output offsets
+            struct Job { const Placement* p; size_t firstVertex, firstIndex; };
+            std::vector<Job> jobs;
+            size_t vertexCount = 0, indexCount = 0;
+            batch.chunks.clear();
+            for (const auto& cell : cells) {
+                Chunk chunk;
+                chunk.firstIndex = indexCount;
+                for (const Placement* p : cell.second) {
+                    jobs.push_back(Job { p, vertexCount, indexCount });
+                    vertexCount += p->mesh->getVertices().size();
+                    indexCount  += p->mesh->getIndices().size();
+                    chunk.bounds.expand(transformAABB(p->mesh->getBounds(), p->model));
+                }
+                chunk.indexCount = static_cast<GLsizei>(indexCount - chunk.firstIndex);
+                batch.chunks.push_back(chunk);
+            }
+
+            // Pre-transform in parallel; every job writes a disjoint range
+            Mesh::Vertices vertices;
+            vertices.resize(vertexCount);
+            std::vector<unsigned int> indices(indexCount);
+            const auto out = vertices.span();
+            pool.parallelFor(0, jobs.size(), 16, [&](size_t begin, size_t end) {
+                for (size_t j = begin; j < end; ++j) {
+                    const Job& job = jobs[j];
+                    const glm::mat4& model = job.p->model;
+                    glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+                    const auto src = job.p->mesh->getVertices().span();
+
+                    for (size_t v = 0, dst = job.firstVertex; v < src.size(); ++v, ++dst) {
+                        glm::vec3 pos = glm::vec3(model * glm::vec4(src.get<Position3f>(v), 1.0f));
+                        glm::vec3 nor = glm::normalize(normalMatrix * src.get<NormalOct16>(v));
+                        out.set<Position3f>(dst, pos);
+                        out.set<NormalOct16>(dst, nor);
+                        out.set<UV2h>(dst, src.get<UV2h>(v));
+                    }
+
+                    const std::vector<unsigned int>& srcIdx = job.p->mesh->getIndices();
+                    unsigned int base = static_cast<unsigned int>(job.firstVertex);
+                    for (size_t i = 0; i < srcIdx.size(); ++i)
+                        indices[job.firstIndex + i] = srcIdx[i] + base;
+                }
+            });
+
+            upload_(batch, vertices, indices);
+            statistics.batches++;
+            statistics.chunks += batch.chunks.size();
+            statistics.batchedBytes += vertices.byteSize() + indices.size() * sizeof(unsigned int);
+        }
+
+        pending.clear();
+    }
+
+    void StaticBatcher::upload_(Batch& batch, const Mesh::Vertices& vertices, const std::vector<unsigned int>& indices)
+    {
+        if (!batch.VAO) {
+            glGenVertexArrays(1, &batch.VAO);
+            glGenBuffers(1, &batch.VBO);
+            glGenBuffers(1, &batch.EBO);
+        }
+        glBindVertexArray(batch.VAO);
+
+        glBindBuffer(GL_ARRAY_BUFFER, batch.VBO);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertices.byteSize()),
+                     vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch.EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indices.size() * sizeof(unsigned int)),
+                     indices.data(), GL_STATIC_DRAW);
+
+        Mesh::VertexFormat::setupAttributes();
+
+        glBindVertexArray(0);
+    }
+
+    int StaticBatcher::draw(int material, const Frustum& frustum,
+                            const std::function<void(const AABB&)>& perChunk) const
+    {
+        const Batch& batch = batches[material];
+        if (!batch.VAO || batch.chunks.empty())
+            return 0;
+
+        glBindVertexArray(batch.VAO);
+        int drawn = 0;
+        if (perChunk) {
+            for (const Chunk& chunk : batch.chunks) {
+                if (!frustum.intersects(chunk.bounds)) continue;
+                perChunk(chunk.bounds);
+                glDrawElements(GL_TRIANGLES, chunk.indexCount, GL_UNSIGNED_INT,
+                               reinterpret_cast<const void*>(chunk.firstIndex * sizeof(unsigned int)));
+                ++drawn;
+            }
+        } else {
+            // Adjacent visible chunks are contiguous in the index buffer: merge them
+            std::vector<GLsizei> counts;
+            std::vector<const void*> offsets;
+            size_t runBegin = 0, runEnd = 0;
+            for (const Chunk& chunk : batch.chunks) {
+                if (!frustum.intersects(chunk.bounds)) continue;
+                ++drawn;
+                if (runEnd == chunk.firstIndex && runEnd != runBegin) {
+                    runEnd += chunk.indexCount;
+                    continue;
+                }
+                if (runEnd != runBegin) {
+                    counts.push_back(static_cast<GLsizei>(runEnd - runBegin));
+                    offsets.push_back(reinterpret_cast<const void*>(runBegin * sizeof(unsigned int)));
+                }
+                runBegin = chunk.firstIndex;
+                runEnd = chunk.firstIndex + chunk.indexCount;
+            }
+            if (runEnd != runBegin) {
+                counts.push_back(static_cast<GLsizei>(runEnd - runBegin));
+                offsets.push_back(reinterpret_cast<const void*>(runBegin * sizeof(unsigned int)));
+            }
+            if (!counts.empty())
+                glMultiDrawElements(GL_TRIANGLES, counts.data(), GL_UNSIGNED_INT, offsets.data(),
+                                    static_cast<GLsizei>(counts.size()));
+        }
+        glBindVertexArray(0);
+        return drawn;
+    }
+
+    const StaticBatcher::Stats& StaticBatcher::stats() const
+    {
+        return statistics;
+    }
+
+    void StaticBatcher::printStats(std::ostream& out) const
+    {
+        out << "Static batching: " << statistics.objects << " objects -> "
+            << statistics.batches << " batches / " << statistics.chunks << " chunks; "
+            << statistics.batchedBytes / 1024 << " KB merged vs "
+            << statistics.sourceBytes / 1024 << " KB unbatched source\n";
+    }
+
+    void StaticBatcher::cleanup()
+    {
+        for (Batch& batch : batches) {
+            if (batch.VAO) { glDeleteVertexArrays(1, &batch.VAO); batch.VAO = 0; }
+            if (batch.VBO) { glDeleteBuffers(1, &batch.VBO); batch.VBO = 0; }
+            if (batch.EBO) { glDeleteBuffers(1, &batch.EBO); batch.EBO = 0; }
+        }
+    }
+
+} // namespace gfx
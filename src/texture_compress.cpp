@@ -0,0 +1,419 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "texture_compress.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include "asset_vfs.h"
+#include "gl_ext.h"
+#include "hash.h"
+#include "mipmap.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GFX_BC_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace gfx {
+
+    namespace {
+        constexpr uint32_t kCacheMagic = 0x58544342;  // "BCTX"
+        constexpr uint32_t kCacheVersion = 2;   // 2: sRGB-correct mips
+
+        size_t blockBytes(BlockFormat format)
+        {
+            return format == BlockFormat::BC3 ? 16 : 8;
+        }
+
+        // 4x4 RGBA block, clamped at the right/bottom edges
+        void fetchBlock(const uint8_t* rgba, int width, int height, int bx, int by, uint8_t block[64])
+        {
+            for (int y = 0; y < 4; ++y) {
+                int sy = std::min(by * 4 + y, height - 1);
+                for (int x = 0; x < 4; ++x) {
+                    int sx = std::min(bx * 4 + x, width - 1);
+                    std::memcpy(block + (y * 4 + x) * 4, rgba + (static_cast<size_t>(sy) * width + sx) * 4, 4);
+                }
+            }
+        }
+
+        void blockMinMax(const uint8_t block[64], uint8_t mn[4], uint8_t mx[4])
+        {
+#ifdef GFX_BC_SSE2
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16));
+            __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 32));
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 48));
+            __m128i lo = _mm_min_epu8(_mm_min_epu8(a, b), _mm_min_epu8(c, d));
+            __m128i hi = _mm_max_epu8(_mm_max_epu8(a, b), _mm_max_epu8(c, d));
+            lo = _mm_min_epu8(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(1, 0, 3, 2)));
+            hi = _mm_max_epu8(hi, _mm_shuffle_epi32(hi, _MM_SHUFFLE(1, 0, 3, 2)));
+            lo = _mm_min_epu8(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(2, 3, 0, 1)));
+            hi = _mm_max_epu8(hi, _mm_shuffle_epi32(hi, _MM_SHUFFLE(2, 3, 0, 1)));
+            int packedMin = _mm_cvtsi128_si32(lo), packedMax = _mm_cvtsi128_si32(hi);
+            std::memcpy(mn, &packedMin, 4);
+            std::memcpy(mx, &packedMax, 4);
+#else
+            for (int c = 0; c < 4; ++c) { mn[c] = 255; mx[c] = 0; }
+            for (int i = 0; i < 16; ++i)
+                for (int c = 0; c < 4; ++c) {
+                    mn[c] = std::min(mn[c], block[i * 4 + c]);
+                    mx[c] = std::max(mx[c], block[i * 4 + c]);
+                }
+#endif
+        }
+
+        uint16_t pack565(const int c[3])
+        {
+            int r = (c[0] * 31 + 127) / 255, g = (c[1] * 63 + 127) / 255, b = (c[2] * 31 + 127) / 255;
+            return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+        }
+
+        void unpack565(uint16_t v, int c[3])
+        {
+            int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+            c[0] = (r << 3) | (r >> 2);
+            c[1] = (g << 2) | (g >> 4);
+            c[2] = (b << 3) | (b >> 2);
+        }
+
+        // 2-bit index of the nearest palette color per pixel (alpha ignored)
+        uint32_t colorIndices(const uint8_t block[64], const int palette[4][3])
+        {
+            uint32_t bits = 0;
+#ifdef GFX_BC_SSE2
+            const __m128i zero = _mm_setzero_si128();
+            for (int q = 0; q < 4; ++q) {
+                __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + q * 16));
+                __m128i lo = _mm_unpacklo_epi8(px, zero), hi = _mm_unpackhi_epi8(px, zero);
+                __m128 r = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero));
+                __m128 g = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero));
+                __m128 b = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero));
+                __m128 a = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero));
+                _MM_TRANSPOSE4_PS(r, g, b, a);   // now r/g/b hold one channel of four pixels
+
+                __m128 best = _mm_set1_ps(1e30f);
+                __m128i index = zero;
+                for (int k = 0; k < 4; ++k) {
+                    __m128 dr = _mm_sub_ps(r, _mm_set1_ps(static_cast<float>(palette[k][0])));
+                    __m128 dg = _mm_sub_ps(g, _mm_set1_ps(static_cast<float>(palette[k][1])));
+                    __m128 db = _mm_sub_ps(b, _mm_set1_ps(static_cast<float>(palette[k][2])));
+                    __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+                    __m128i closer = _mm_castps_si128(_mm_cmplt_ps(dist, best));
+                    best = _mm_min_ps(dist, best);
+                    index = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(k)), _mm_andnot_si128(closer, index));
+                }
+                alignas(16) int32_t idx[4];
+                _mm_store_si128(reinterpret_cast<__m128i*>(idx), index);
+                for (int i = 0; i < 4; ++i)
+                    bits |= static_cast<uint32_t>(idx[i]) << (2 * (q * 4 + i));
+            }
+#else
+            for (int i = 0; i < 16; ++i) {
+                int best = 1 << 30, index = 0;
+                for (int k = 0; k < 4; ++k) {
+                    int dr = block[i * 4] - palette[k][0];
+                    int dg = block[i * 4 + 1] - palette[k][1];
+                    int db = block[i * 4 + 2] - palette[k][2];
+                    int dist = dr * dr + dg * dg + db * db;
+                    if (dist < best) { best = dist; index = k; }
+                }
+                bits |= static_cast<uint32_t>(index) << (2 * i);
+            }
+#endif
+            return bits;
+        }
+
+        void writeLE16(uint8_t* out, uint16_t v) { out[0] = v & 0xFF; out[1] = v >> 8; }
+
+        // Bounding-box endpoints (inset, diagonal picked by covariance sign), four-color mode
+        void encodeColor(const uint8_t block[64], uint8_t out[8])
+        {
+            uint8_t mn8[4], mx8[4];
+            blockMinMax(block, mn8, mx8);
+            int mn[3] = { mn8[0], mn8[1], mn8[2] }, mx[3] = { mx8[0], mx8[1], mx8[2] };
+
+            int axis = 0;
+            for (int c = 1; c < 3; ++c)
+                if (mx[c] - mn[c] > mx[axis] - mn[axis]) axis = c;
+            int cov[3] = { 0, 0, 0 };
+            for (int i = 0; i < 16; ++i) {
+                int ref = 2 * block[i * 4 + axis] - mn[axis] - mx[axis];
+                for (int c = 0; c < 3; ++c)
+                    cov[c] += ref * (2 * block[i * 4 + c] - mn[c] - mx[c]);
+            }
+            for (int c = 0; c < 3; ++c) {
+                if (cov[c] < 0) std::swap(mn[c], mx[c]);
+                int inset = (mx[c] - mn[c]) / 16;
+                mx[c] -= inset;
+                mn[c] += inset;
+            }
+
+            uint16_t c0 = pack565(mx), c1 = pack565(mn);
+            if (c0 < c1) std::swap(c0, c1);
+            writeLE16(out, c0);
+            writeLE16(out + 2, c1);
+
+            uint32_t bits = 0;
+            if (c0 != c1) {
+                int palette[4][3];
+                unpack565(c0, palette[0]);
+                unpack565(c1, palette[1]);
+                for (int c = 0; c < 3; ++c) {
+                    palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                    palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+                }
+                bits = colorIndices(block, palette);
+            }
+            std::memcpy(out + 4, &bits, 4);
+        }
+
+        // BC4 / BC3-alpha: eight-value mode, indices by rounding along [min, max]
+        void encodeChannel(const uint8_t values[16], uint8_t out[8])
+        {
+#ifdef GFX_BC_SSE2
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+            __m128i lo = _mm_min_epu8(v, _mm_srli_si128(v, 8));
+            __m128i hi = _mm_max_epu8(v, _mm_srli_si128(v, 8));
+            lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 4)); hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 4));
+            lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 2)); hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 2));
+            lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 1)); hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 1));
+            int mn = _mm_cvtsi128_si32(lo) & 0xFF, mx = _mm_cvtsi128_si32(hi) & 0xFF;
+#else
+            int mn = 255, mx = 0;
+            for (int i = 0; i < 16; ++i) { mn = std::min<int>(mn, values[i]); mx = std::max<int>(mx, values[i]); }
+#endif
+            out[0] = static_cast<uint8_t>(mx);
+            out[1] = static_cast<uint8_t>(mn);
+
+            uint64_t bits = 0;
+            int range = mx - mn;
+            if (range > 0) {
+                for (int i = 0; i < 16; ++i) {
+                    int t = ((values[i] - mn) * 14 + range) / (2 * range);  // 0..7 from min to max
+                    int index = t == 7 ? 0 : (t == 0 ? 1 : 8 - t);
+                    bits |= static_cast<uint64_t>(index) << (3 * i);
+                }
+            }
+            for (int i = 0; i < 6; ++i)
+                out[2 + i] = static_cast<uint8_t>(bits >> (8 * i));
+        }
+
+        void encodeBlock(BlockFormat format, const uint8_t block[64], uint8_t* out)
+        {
+            uint8_t channel[16];
+            switch (format) {
+                case BlockFormat::BC1:
+                    encodeColor(block, out);
+                    break;
+                case BlockFormat::BC3:
+                    for (int i = 0; i < 16; ++i) channel[i] = block[i * 4 + 3];
+                    encodeChannel(channel, out);
+                    encodeColor(block, out + 8);
+                    break;
+                case BlockFormat::BC4:
+                    for (int i = 0; i < 16; ++i) channel[i] = block[i * 4];
+                    encodeChannel(channel, out);
+                    break;
+            }
+        }
+
+        void compressLevel(const uint8_t* rgba, int width, int height, BlockFormat format,
+                           uint8_t* out, ThreadPool& pool)
+        {
+            const int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+            const size_t bytes = blockBytes(format);
+            pool.parallelFor(0, static_cast<size_t>(blocksY), 4, [&](size_t begin, size_t end) {
+                uint8_t block[64];
+                for (size_t by = begin; by < end; ++by)
+                    for (int bx = 0; bx < blocksX; ++bx) {
+                        fetchBlock(rgba, width, height, bx, static_cast<int>(by), block);
+                        encodeBlock(format, block, out + (by * blocksX + bx) * bytes);
+                    }
+            });
+        }
+
+        template <class T> void put(std::ostream& out, T v) { out.write(reinterpret_cast<const char*>(&v), sizeof(T)); }
+        template <class T> bool get(std::istream& in, T& v) { return static_cast<bool>(in.read(reinterpret_cast<char*>(&v), sizeof(T))); }
+
+        // Levels a full chain from a width x height base has
+        int fullChainLevels(int width, int height)
+        {
+            int levels = 1;
+            for (int size = std::max(width, height); size > 1; size >>= 1)
+                ++levels;
+            return levels;
+        }
+
+        // Everything comes from the file: a count, dimension or size that doesn't
+        // describe a BC chain of this format means a stale or corrupt cache, which
+        // the caller recompresses over
+        bool readCache(const std::string& path, CompressedTexture& texture)
+        {
+            constexpr int32_t kMaxDimension = 1 << 16;
+            std::error_code ec;
+            const uint64_t fileSize = std::filesystem::file_size(path, ec);
+            if (ec)
+                return false;
+            std::ifstream in(path, std::ios::binary);
+            uint32_t magic = 0, version = 0, format = 0, grayscale = 0, levelCount = 0;
+            if (!in || !get(in, magic) || magic != kCacheMagic || !get(in, version) || version != kCacheVersion)
+                return false;
+            if (!get(in, format) || !get(in, grayscale) || !get(in, levelCount) || format > 2 ||
+                levelCount == 0 || levelCount > static_cast<uint32_t>(fullChainLevels(kMaxDimension, kMaxDimension)))
+                return false;
+
+            auto stale = [&texture] {
+                texture.levels.clear();
+                texture.data.clear();
+                return false;
+            };
+            texture.format = static_cast<BlockFormat>(format);
+            texture.grayscale = grayscale != 0;
+            texture.levels.resize(levelCount);
+            uint64_t total = 0;
+            for (size_t i = 0; i < texture.levels.size(); ++i) {
+                int32_t w = 0, h = 0;
+                uint64_t size = 0;
+                if (!get(in, w) || !get(in, h) || !get(in, size))
+                    return stale();
+                // Level 0 must hold a chain this long; the rest must halve it
+                const CompressedTexture::Level& base = texture.levels[0];
+                const bool shaped = i == 0 ? w > 0 && h > 0 && w <= kMaxDimension && h <= kMaxDimension &&
+                                             static_cast<int>(levelCount) <= fullChainLevels(w, h)
+                                           : w == std::max(1, base.width >> i) && h == std::max(1, base.height >> i);
+                const uint64_t expected = static_cast<uint64_t>((w + 3) / 4) * ((h + 3) / 4) * blockBytes(texture.format);
+                if (!shaped || size != expected)
+                    return stale();
+                CompressedTexture::Level& level = texture.levels[i];
+                level.width = w;
+                level.height = h;
+                level.offset = static_cast<size_t>(total);
+                level.size = static_cast<size_t>(size);
+                total += size;
+            }
+            const uint64_t headerSize = 5 * sizeof(uint32_t) + levelCount * (2 * sizeof(int32_t) + sizeof(uint64_t));
+            if (headerSize + total != fileSize)
+                return stale();
+            texture.data.resize(static_cast<size_t>(total));
+            if (!in.read(reinterpret_cast<char*>(texture.data.data()), static_cast<std::streamsize>(total)))
+                return stale();
+            return true;
+        }
+
+        void writeCache(const std::string& path, const CompressedTexture& texture)
+        {
+            // Write then rename so a concurrent reader never sees a partial file
+            std::string temp = path + ".tmp";
+            {
+                std::ofstream out(temp, std::ios::binary);
+                if (!out) return;
+                put(out, kCacheMagic);
+                put(out, kCacheVersion);
+                put(out, static_cast<uint32_t>(texture.format));
+                put(out, static_cast<uint32_t>(texture.grayscale));
+                put(out, static_cast<uint32_t>(texture.levels.size()));
+                for (const auto& level : texture.levels) {
+                    put(out, static_cast<int32_t>(level.width));
+                    put(out, static_cast<int32_t>(level.height));
+                    put(out, static_cast<uint64_t>(level.size));
+                }
+                out.write(reinterpret_cast<const char*>(texture.data.data()), static_cast<std::streamsize>(texture.data.size()));
+                if (!out) return;
+            }
+            std::error_code ec;
+            std::filesystem::rename(temp, path, ec);
+        }
+    }
+
+    GLenum CompressedTexture::glFormat() const
+    {
+        switch (format) {
+            case BlockFormat::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            case BlockFormat::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            case BlockFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+        }
+        return 0;
+    }
+
+    BlockFormat chooseBlockFormat(const Image& image)
+    {
+        if (image.channels == 1)
+            return BlockFormat::BC4;
+        if (image.channels == 2)
+            return BlockFormat::BC3;
+
+        bool gray = true, opaque = true;
+        const uint8_t* p = image.pixels.get();
+        size_t count = static_cast<size_t>(image.width) * image.height;
+        for (size_t i = 0; i < count && (gray || opaque); ++i, p += image.channels) {
+            gray = gray && p[0] == p[1] && p[1] == p[2];
+            opaque = opaque && (image.channels == 3 || p[3] == 255);
+        }
+        if (!opaque) return BlockFormat::BC3;
+        return gray ? BlockFormat::BC4 : BlockFormat::BC1;
+    }
+
+    CompressedTexture compressImage(const Image& image, BlockFormat format, bool mipmaps, ThreadPool& pool)
+    {
+        CompressedTexture texture;
+        if (!image.valid())
+            return texture;
+        texture.format = format;
+        texture.grayscale = format == BlockFormat::BC4 && image.channels != 1;
+
+        // Color formats carry sRGB albedo/sky data; BC4 carries masks filtered as stored
+        const bool srgb = format != BlockFormat::BC4;
+        MipLevel source{ image.width, image.height, expandToRGBA(image) };
+        for (;;) {
+            CompressedTexture::Level level;
+            level.width = source.width;
+            level.height = source.height;
+            level.offset = texture.data.size();
+            level.size = static_cast<size_t>((source.width + 3) / 4) * ((source.height + 3) / 4) * blockBytes(format);
+            texture.data.resize(level.offset + level.size);
+            compressLevel(source.rgba.data(), source.width, source.height, format, texture.data.data() + level.offset, pool);
+            texture.levels.push_back(level);
+
+            if (!mipmaps || (source.width == 1 && source.height == 1))
+                break;
+            source = downsampleRGBA(source, srgb, pool);
+        }
+        return texture;
+    }
+
+    CompressedTexture loadCompressedTexture(const std::string& path, bool flipVertical,
+                                            const std::string& cacheDir, ThreadPool& pool)
+    {
+        CompressedTexture texture;
+        AssetData bytes = readAsset(path);
+        if (!bytes.valid()) {
+            std::cerr << "Failed to load texture: " << path << "\n";
+            return texture;
+        }
+
+        const std::string name = hashName(hashBytes(bytes.data(), bytes.size(), (kCacheVersion << 1) | (flipVertical ? 1u : 0u)));
+        std::string cachePath = (std::filesystem::path(cacheDir) / (name + ".bct")).string();
+        if (readCache(cachePath, texture))
+            return texture;
+
+        Image image = decodeImage(bytes.data(), bytes.size(), flipVertical, path);
+        if (!image.valid())
+            return texture;
+        texture = compressImage(image, chooseBlockFormat(image), true, pool);
+
+        std::error_code ec;
+        std::filesystem::create_directories(cacheDir, ec);
+        writeCache(cachePath, texture);
+        return texture;
+    }
+
+    bool supportsBlockCompression()
+    {
+        return hasGLExtension("GL_EXT_texture_compression_s3tc");
+    }
+
+} // namespace gfx
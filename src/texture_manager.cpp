@@ -0,0 +1,492 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "texture_manager.h"
+#include "gl_ext.h"
+#include "mipmap.h"
+#include <algorithm>
+#include <iostream>
+#include <ostream>
+#include <sstream>
+
+namespace gfx {
+
+    namespace {
+        void formatForChannels(int channels, GLenum& srcFormat, GLint& internal)
+        {
+            srcFormat = GL_RGB;
+            internal  = GL_RGB;
+            if (channels == 4) { srcFormat = GL_RGBA; internal = GL_RGBA; }
+            else if (channels == 1) { srcFormat = GL_RED; internal = GL_RED; }
+        }
+
+        void applySampler(GLenum target, const SamplerParams& sampler)
+        {
+            glTexParameteri(target, GL_TEXTURE_WRAP_S, sampler.wrap);
+            glTexParameteri(target, GL_TEXTURE_WRAP_T, sampler.wrap);
+            if (target == GL_TEXTURE_CUBE_MAP)
+                glTexParameteri(target, GL_TEXTURE_WRAP_R, sampler.wrap);
+            glTexParameteri(target, GL_TEXTURE_MIN_FILTER, sampler.minFilter);
+            glTexParameteri(target, GL_TEXTURE_MAG_FILTER, sampler.magFilter);
+        }
+
+        // Every level of a CPU-built chain (RGBA8 rows are always 4-byte aligned)
+        void uploadMipChain(GLenum target, GLint internal, const std::vector<MipLevel>& chain)
+        {
+            for (size_t level = 0; level < chain.size(); ++level)
+                glTexImage2D(target, static_cast<GLint>(level), internal, chain[level].width, chain[level].height, 0,
+                             GL_RGBA, GL_UNSIGNED_BYTE, chain[level].rgba.data());
+        }
+
+        // Drivers store 3-channel textures padded to 4 bytes per texel
+        size_t textureBytes(const Image& image, bool mipmaps)
+        {
+            size_t texel = image.channels == 1 ? 1 : 4;
+            size_t bytes = static_cast<size_t>(image.width) * image.height * texel;
+            return mipmaps ? bytes + bytes / 3 : bytes;
+        }
+    }
+
+    GLuint uploadTexture2D(const Image& image, const SamplerParams& sampler)
+    {
+        if (!image.valid())
+            return 0;
+
+        GLenum srcFormat; GLint internal;
+        formatForChannels(image.channels, srcFormat, internal);
+
+        GLuint texID = 0;
+        glGenTextures(1, &texID);
+        glBindTexture(GL_TEXTURE_2D, texID);
+        applySampler(GL_TEXTURE_2D, sampler);
+
+        if (sampler.generateMipmaps) {
+            uploadMipChain(GL_TEXTURE_2D, internal, buildMipChain(image, prefersSrgbMips(image)));
+            return texID;
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, internal, image.width, image.height, 0, srcFormat, GL_UNSIGNED_BYTE, image.pixels.get());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        return texID;
+    }
+
+    GLuint uploadCubeMap(const std::vector<Image>& faces, const SamplerParams& sampler)
+    {
+        for (const Image& face : faces)
+            if (!face.valid()) {
+                std::cerr << "Failed to load cubmap face: " << face.path << std::endl;
+                return 0;
+            }
+
+        GLuint texID = 0;
+        glGenTextures(1, &texID);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, texID);
+
+        if (sampler.generateMipmaps) {
+            // All faces share one filter so the sky does not change tone across seams
+            auto chains = buildMipChains(faces, prefersSrgbMips(faces[0]));
+            for (size_t i = 0; i < faces.size(); ++i) {
+                GLenum srcFormat; GLint internal;
+                formatForChannels(faces[i].channels, srcFormat, internal);
+                uploadMipChain(GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(i), internal, chains[i]);
+            }
+        } else {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            for (size_t i = 0; i < faces.size(); ++i) {
+                GLenum srcFormat; GLint internal;
+                formatForChannels(faces[i].channels, srcFormat, internal);
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(i), 0, internal,
+                             faces[i].width, faces[i].height, 0, srcFormat, GL_UNSIGNED_BYTE, faces[i].pixels.get());
+            }
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        }
+
+        applySampler(GL_TEXTURE_CUBE_MAP, sampler);
+        return texID;
+    }
+
+    GLuint uploadCompressedTexture2D(const CompressedTexture& texture, const SamplerParams& sampler)
+    {
+        if (!texture.valid())
+            return 0;
+
+        GLuint texID = 0;
+        glGenTextures(1, &texID);
+        glBindTexture(GL_TEXTURE_2D, texID);
+        applySampler(GL_TEXTURE_2D, sampler);
+
+        size_t levels = sampler.generateMipmaps ? texture.levels.size() : 1;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels) - 1);
+        for (size_t i = 0; i < levels; ++i) {
+            const CompressedTexture::Level& level = texture.levels[i];
+            glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), texture.glFormat(), level.width, level.height, 0,
+                                   static_cast<GLsizei>(level.size), texture.data.data() + level.offset);
+        }
+        if (texture.grayscale) {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_RED);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
+        }
+        return texID;
+    }
+
+    GLuint uploadKtx(const KtxTexture& texture, const SamplerParams& sampler)
+    {
+        if (texture.levels() == 0)
+            return 0;
+
+        const GLenum target = texture.isCube() ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+        const int levels = sampler.generateMipmaps ? texture.levels() : 1;
+        const bool immutable = glTexStorage2D != nullptr;
+
+        GLuint texID = 0;
+        glGenTextures(1, &texID);
+        glBindTexture(target, texID);
+        applySampler(target, sampler);
+        glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+        if (immutable)
+            glTexStorage2D(target, levels, texture.internalFormat(), texture.width(), texture.height());
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);  // KTX rows are 4-byte aligned
+        for (int level = 0; level < levels; ++level) {
+            GLsizei w = std::max(1, texture.width() >> level), h = std::max(1, texture.height() >> level);
+            GLsizei size = static_cast<GLsizei>(texture.imageSize(level));
+            for (int face = 0; face < texture.faces(); ++face) {
+                GLenum image = texture.isCube() ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+                const void* data = texture.imageData(level, face);
+                if (texture.isCompressed()) {
+                    if (immutable) glCompressedTexSubImage2D(image, level, 0, 0, w, h, texture.internalFormat(), size, data);
+                    else glCompressedTexImage2D(image, level, texture.internalFormat(), w, h, 0, size, data);
+                } else {
+                    if (immutable) glTexSubImage2D(image, level, 0, 0, w, h, texture.format(), texture.type(), data);
+                    else glTexImage2D(image, level, static_cast<GLint>(texture.internalFormat()), w, h, 0,
+                                      texture.format(), texture.type(), data);
+                }
+            }
+        }
+        if (texture.value("KTXswizzle") == "rrr1") {
+            glTexParameteri(target, GL_TEXTURE_SWIZZLE_G, GL_RED);
+            glTexParameteri(target, GL_TEXTURE_SWIZZLE_B, GL_RED);
+        }
+        return texID;
+    }
+
+    TextureManager::~TextureManager()
+    {
+        clear();
+    }
+
+    bool TextureManager::enableCompression(const std::string& cacheDir)
+    {
+        compression = supportsBlockCompression();
+        compressionCache = cacheDir;
+        if (!compression)
+            std::cerr << "S3TC not supported: textures stay uncompressed\n";
+        return compression;
+    }
+
+    void TextureManager::setStreamer(TextureStreamer* textureStreamer)
+    {
+        streamer = textureStreamer;
+    }
+
+    void TextureManager::prefetch(const std::string& path, bool flipVertical)
+    {
+        prefetch_(path, flipVertical, compression);
+    }
+
+    void TextureManager::prefetchCube(const std::vector<std::string>& faces, bool flipVertical)
+    {
+        for (const auto& face : faces)
+            prefetch_(face, flipVertical, false);
+    }
+
+    void TextureManager::prefetch_(const std::string& path, bool flipVertical, bool compressed)
+    {
+        PendingKey key(path, flipVertical, compressed);
+        if (streamer || isKtxPath(path) || pending.count(key))
+            return;
+        std::string cacheDir = compressionCache;
+        pending.emplace(key, ThreadPool::shared().submit([path, flipVertical, compressed, cacheDir] {
+            Source source;
+            if (compressed)
+                source.compressed = loadCompressedTexture(path, flipVertical, cacheDir);
+            else
+                source.image = loadImage(path, flipVertical);
+            return source;
+        }));
+    }
+
+    TextureManager::Source TextureManager::load_(const std::string& path, bool flipVertical, bool compressed)
+    {
+        prefetch_(path, flipVertical, compressed);
+        auto it = pending.find(PendingKey(path, flipVertical, compressed));
+        Source source = it->second.get();
+        pending.erase(it);
+        return source;
+    }
+
+    GLuint TextureManager::acquire2D(const std::string& path, const SamplerParams& sampler, bool flipVertical)
+    {
+        return acquire_("2d|" + path, GL_TEXTURE_2D, { path }, sampler, flipVertical);
+    }
+
+    GLuint TextureManager::acquireCube(const std::vector<std::string>& faces, const SamplerParams& sampler, bool flipVertical)
+    {
+        std::string key = "cube";
+        for (const auto& face : faces)
+            key += "|" + face;
+        return acquire_(key, GL_TEXTURE_CUBE_MAP, faces, sampler, flipVertical);
+    }
+
+    GLuint TextureManager::acquire_(const std::string& sourceKey, GLenum target, const std::vector<std::string>& paths,
+                                    const SamplerParams& sampler, bool flipVertical)
+    {
+        std::ostringstream key;
+        key << sourceKey << "|w" << sampler.wrap << "|min" << sampler.minFilter << "|mag" << sampler.magFilter
+            << "|mip" << sampler.generateMipmaps << "|flip" << flipVertical
+            << "|bc" << (compression && target == GL_TEXTURE_2D);
+
+        auto found = entries.find(key.str());
+        if (found != entries.end()) {
+            found->second.refs++;
+            statistics.hits++;
+            statistics.savedBytes += found->second.bytes;
+            return found->second.handle;
+        }
+        statistics.misses++;
+
+        const bool compressed = compression && target == GL_TEXTURE_2D;
+        if (streamer)
+            return stream_(key.str(), target, paths, sampler, flipVertical, compressed);
+
+        Entry entry;
+        entry.target = target;
+        entry.refs = 1;
+        entry.paths = paths;
+        entry.sampler = sampler;
+        entry.flipVertical = flipVertical;
+        entry.compressed = compressed;
+        if (paths.size() == 1 && isKtxPath(paths[0])) {
+            // Pre-baked: no decode, no mip generation, the file already has the target's layout
+            KtxTexture ktx;
+            if (ktx.load(paths[0]))
+                entry.texture = uploadKtx(ktx, sampler);
+            entry.target = ktx.isCube() ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+            for (int level = 0; level < (sampler.generateMipmaps ? ktx.levels() : std::min(1, ktx.levels())); ++level)
+                entry.bytes += ktx.imageSize(level) * ktx.faces();
+        } else if (compressed) {
+            Source source = load_(paths[0], flipVertical, true);
+            entry.texture = uploadCompressedTexture2D(source.compressed, sampler);
+            for (const auto& level : source.compressed.levels) {
+                entry.bytes += level.size;
+                if (!sampler.generateMipmaps) break;
+            }
+        } else {
+            // Faces not already prefetched still decode together
+            for (const auto& path : paths)
+                prefetch_(path, flipVertical, false);
+            std::vector<Image> images;
+            for (const auto& path : paths)
+                images.push_back(std::move(load_(path, flipVertical, false).image));
+
+            entry.texture = target == GL_TEXTURE_CUBE_MAP ? uploadCubeMap(images, sampler)
+                                                          : uploadTexture2D(images[0], sampler);
+            for (const Image& image : images)
+                entry.bytes += textureBytes(image, sampler.generateMipmaps);
+        }
+        if (!entry.texture) {
+            std::cerr << "Failed to load texture: " << paths[0] << "\n";
+            return 0;
+        }
+        GLuint texture = entry.texture;
+        entry.handle = texture;
+
+        statistics.textures++;
+        statistics.residentBytes += entry.bytes;
+        keyOf[texture] = key.str();
+        entries.emplace(key.str(), entry);
+        return texture;
+    }
+
+    GLuint TextureManager::stream_(const std::string& key, GLenum target, const std::vector<std::string>& paths,
+                                   const SamplerParams& sampler, bool flipVertical, bool compressed)
+    {
+        Entry entry;
+        entry.target = target;
+        entry.refs = 1;
+        entry.paths = paths;
+        entry.sampler = sampler;
+        entry.flipVertical = flipVertical;
+        entry.compressed = compressed;
+        // Callers get an empty texture (it reads black) as the handle, and the load
+        // fills a second one that nothing samples yet, which may then be written from
+        // another context; swap_ puts it behind the handle once it is resident
+        glGenTextures(1, &entry.handle);
+        entry.texture = entry.handle;
+        GLuint loading = 0;
+        glGenTextures(1, &loading);
+        glBindTexture(target, loading);
+        applySampler(target, sampler);
+
+        // Resident size is only known once the source has loaded
+        streamer->stream(loading, target, loadStreamSource_(entry), [this, key, handle = entry.handle](GLuint loaded, const StreamSource& source) {
+            if (source.empty()) {
+                std::cerr << "Failed to load texture: " << key << "\n";
+                glDeleteTextures(1, &loaded);
+                return;
+            }
+            swap_(key, handle, loaded, source);
+        });
+
+        statistics.textures++;
+        keyOf[entry.handle] = key;
+        entries.emplace(key, entry);
+        return entry.handle;
+    }
+
+    std::future<StreamSource> TextureManager::loadStreamSource_(const Entry& entry) const
+    {
+        std::string cacheDir = compressionCache;
+        return ThreadPool::shared().submit([paths = entry.paths, flipVertical = entry.flipVertical,
+                                            compressed = entry.compressed, cacheDir,
+                                            mipmaps = entry.sampler.generateMipmaps] {
+            if (paths.size() == 1 && isKtxPath(paths[0]))
+                return streamSourceFromKtx(paths[0], mipmaps);
+            if (compressed)
+                return streamSourceFromCompressed(loadCompressedTexture(paths[0], flipVertical, cacheDir), mipmaps);
+            return streamSourceFromImages(loadImages(paths, flipVertical), mipmaps);
+        });
+    }
+
+    std::vector<std::string> TextureManager::sources(GLuint texture) const
+    {
+        auto key = keyOf.find(texture);
+        return key != keyOf.end() ? entries.at(key->second).paths : std::vector<std::string>();
+    }
+
+    bool TextureManager::reload(GLuint texture, std::function<void(GLuint)> onDone)
+    {
+        auto key = keyOf.find(texture);
+        if (key == keyOf.end())
+            return false;
+        if (!streamer) {
+            std::cerr << "Texture reload needs a TextureStreamer: " << key->second << "\n";
+            return false;
+        }
+        const Entry& entry = entries.at(key->second);
+
+        GLuint replacement = 0;
+        glGenTextures(1, &replacement);
+        glBindTexture(entry.target, replacement);
+        applySampler(entry.target, entry.sampler);
+        streamer->stream(replacement, entry.target, loadStreamSource_(entry),
+                         [this, name = key->second, texture = entry.handle, previous = entry.texture, onDone](GLuint loaded, const StreamSource& source) {
+            GLuint swapped = 0;
+            if (source.empty()) {
+                std::cerr << "Reload failed, keeping the previous texture: " << name << "\n";
+                glDeleteTextures(1, &loaded);
+            } else if (swap_(name, previous, loaded, source)) {
+                swapped = texture;
+            }
+            if (onDone)
+                onDone(swapped);
+        });
+        return true;
+    }
+
+    bool TextureManager::swap_(const std::string& key, GLuint previous, GLuint texture, const StreamSource& source)
+    {
+        auto entry = entries.find(key);
+        if (entry == entries.end() || entry->second.texture != previous) {
+            glDeleteTextures(1, &texture);    // released meanwhile
+            return false;
+        }
+
+        // The handle callers hold stays reserved (and keeps resolving here) until release
+        streamer->cancel(previous);
+        if (previous != entry->second.handle) {
+            glDeleteTextures(1, &previous);
+            keyOf.erase(previous);
+        }
+        entry->second.texture = texture;
+        statistics.residentBytes += source.bytes - entry->second.bytes;
+        entry->second.bytes = source.bytes;
+        keyOf[texture] = key;
+
+        GLint activeUnit = GL_TEXTURE0;
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &activeUnit);
+        for (size_t unit = 0; unit < unitTextures.size(); ++unit)
+            if (unitTextures[unit] == previous)
+                bind(texture, static_cast<GLint>(unit));
+        glActiveTexture(static_cast<GLenum>(activeUnit));
+        return true;
+    }
+
+    void TextureManager::release(GLuint texture)
+    {
+        auto key = keyOf.find(texture);
+        if (key == keyOf.end())
+            return;
+        auto entry = entries.find(key->second);
+        if (--entry->second.refs > 0)
+            return;
+
+        const GLuint handle = entry->second.handle, current = entry->second.texture;
+        if (streamer) streamer->cancel(current);
+        glDeleteTextures(1, &current);
+        keyOf.erase(current);
+        if (handle != current) {
+            glDeleteTextures(1, &handle);
+            keyOf.erase(handle);
+        }
+        statistics.textures--;
+        statistics.residentBytes -= entry->second.bytes;
+        entries.erase(entry);
+    }
+
+    void TextureManager::bind(GLuint texture, GLint unit) const
+    {
+        auto key = keyOf.find(texture);
+        GLenum target = GL_TEXTURE_2D;
+        if (key != keyOf.end()) {
+            const Entry& entry = entries.at(key->second);
+            target = entry.target;
+            texture = entry.texture;
+        }
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(target, texture);
+        if (unitTextures.size() <= static_cast<size_t>(unit))
+            unitTextures.resize(unit + 1, 0);
+        unitTextures[unit] = texture;
+    }
+
+    const TextureManager::Stats& TextureManager::stats() const
+    {
+        return statistics;
+    }
+
+    void TextureManager::printStats(std::ostream& out) const
+    {
+        out << "Textures: " << statistics.textures << " resident (" << statistics.residentBytes / 1024 << " KB), "
+            << statistics.hits << " hits / " << statistics.misses << " misses, "
+            << statistics.savedBytes / 1024 << " KB of duplicate uploads avoided\n";
+    }
+
+    void TextureManager::clear()
+    {
+        for (auto& pair : pending)
+            if (pair.second.valid()) pair.second.wait();
+        pending.clear();
+        for (auto& pair : entries) {
+            if (streamer) streamer->cancel(pair.second.texture);
+            glDeleteTextures(1, &pair.second.texture);
+            if (pair.second.handle != pair.second.texture)
+                glDeleteTextures(1, &pair.second.handle);
+        }
+        entries.clear();
+        keyOf.clear();
+        statistics.textures = 0;
+        statistics.residentBytes = 0;
+    }
+
+} // namespace gfx
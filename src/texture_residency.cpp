@@ -0,0 +1,216 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "texture_residency.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <ostream>
+
+namespace gfx {
+
+    namespace {
+        // Same scratch unit as the streamer: level changes never disturb bound units
+        constexpr GLint kResidencyUnit = 15;
+    }
+
+    float projectedSize(const BoundingSphere& sphere, const glm::vec3& eye, const glm::mat4& projection,
+                        float viewportHeight)
+    {
+        float distance = glm::length(sphere.center - eye);
+        if (distance <= sphere.radius)
+            return std::numeric_limits<float>::max();
+        return sphere.radius * projection[1][1] * viewportHeight / distance;
+    }
+
+    int mipForCoverage(int textureSize, float pixels)
+    {
+        if (pixels >= static_cast<float>(textureSize))
+            return 0;
+        if (pixels <= 1.0f)
+            return std::numeric_limits<int>::max();
+        return static_cast<int>(std::floor(std::log2(static_cast<float>(textureSize) / pixels)));
+    }
+
+    TextureResidency::TextureResidency(size_t budgetBytes, TextureStreamer& streamer, int tailSize, ThreadPool& pool)
+        : pool(pool), streamer(streamer), tailSize(tailSize)
+    {
+        statistics.budget = budgetBytes;
+    }
+
+    int TextureResidency::tailLevel(int width, int height, int levels) const
+    {
+        int level = 0;
+        while (level + 1 < levels && std::max(width >> level, height >> level) > tailSize)
+            ++level;
+        return level;
+    }
+
+    int TextureResidency::track(ResidencyDesc desc)
+    {
+        Tracked t;
+        const int levels = static_cast<int>(desc.levelBytes.size());
+        t.tail = tailLevel(desc.width, desc.height, levels);
+        t.base = std::min(desc.residentBase, levels - 1);
+        t.wanted = t.tail;
+        t.live = true;
+        t.desc = std::move(desc);
+        statistics.residentBytes += bytesBetween_(t, t.base, levels - 1);
+        textures.push_back(std::move(t));
+        return static_cast<int>(textures.size()) - 1;
+    }
+
+    void TextureResidency::untrack(int handle)
+    {
+        if (handle < 0 || handle >= static_cast<int>(textures.size())) return;
+        Tracked& t = textures[handle];
+        if (!t.live) return;
+        if (t.loadingBase >= 0) {
+            size_t cost = bytesBetween_(t, t.loadingBase, t.base - 1);
+            streamer.cancel(t.desc.texture);
+            statistics.residentBytes -= cost;
+            statistics.loadingBytes -= cost;
+        }
+        statistics.residentBytes -= bytesBetween_(t, t.base, static_cast<int>(t.desc.levelBytes.size()) - 1);
+        t = Tracked();
+    }
+
+    void TextureResidency::request(int handle, int level)
+    {
+        if (handle < 0 || handle >= static_cast<int>(textures.size())) return;
+        Tracked& t = textures[handle];
+        if (!t.live) return;
+        t.wanted = std::min(t.wanted, std::max(0, level));
+        t.lastUsed = frame;
+    }
+
+    void TextureResidency::requestCoverage(int handle, float pixels)
+    {
+        if (handle < 0 || handle >= static_cast<int>(textures.size())) return;
+        const Tracked& t = textures[handle];
+        if (!t.live) return;
+        request(handle, mipForCoverage(std::max(t.desc.width, t.desc.height), pixels));
+    }
+
+    size_t TextureResidency::bytesBetween_(const Tracked& t, int first, int last) const
+    {
+        size_t bytes = 0;
+        for (int level = first; level <= last; ++level)
+            bytes += t.desc.levelBytes[level];
+        return bytes;
+    }
+
+    void TextureResidency::freeLevel_(Tracked& t)
+    {
+        const ResidencyDesc& d = t.desc;
+        const GLint level = t.base;
+        glBindTexture(d.target, d.texture);
+        glTexParameteri(d.target, GL_TEXTURE_BASE_LEVEL, level + 1);
+
+        // Redefining a level as 0x0 hands its storage back to the driver
+        if (d.target == GL_TEXTURE_2D_ARRAY) {
+            if (d.type == 0) glCompressedTexImage3D(d.target, level, d.internalFormat, 0, 0, 0, 0, 0, nullptr);
+            else glTexImage3D(d.target, level, static_cast<GLint>(d.internalFormat), 0, 0, 0, 0, d.format, d.type, nullptr);
+        } else {
+            const int faces = d.target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+            for (int face = 0; face < faces; ++face) {
+                GLenum image = faces == 6 ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : d.target;
+                if (d.type == 0) glCompressedTexImage2D(image, level, d.internalFormat, 0, 0, 0, 0, nullptr);
+                else glTexImage2D(image, level, static_cast<GLint>(d.internalFormat), 0, 0, 0, d.format, d.type, nullptr);
+            }
+        }
+        statistics.residentBytes -= d.levelBytes[level];
+        statistics.evictions++;
+        t.base++;
+    }
+
+    bool TextureResidency::evictOne_(int keep)
+    {
+        // Least recently used first; something used this frame only gives up
+        // levels finer than it asked for
+        Tracked* victim = nullptr;
+        for (size_t i = 0; i < textures.size(); ++i) {
+            Tracked& t = textures[i];
+            if (!t.live || static_cast<int>(i) == keep || t.loadingBase >= 0 || t.base >= t.tail)
+                continue;
+            if (t.lastUsed == frame && t.base >= std::min(t.wanted, t.tail))
+                continue;
+            if (!victim || t.lastUsed < victim->lastUsed)
+                victim = &t;
+        }
+        if (!victim)
+            return false;
+        freeLevel_(*victim);
+        return true;
+    }
+
+    void TextureResidency::update()
+    {
+        GLint previousUnit = GL_TEXTURE0;
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &previousUnit);
+        glActiveTexture(GL_TEXTURE0 + kResidencyUnit);
+
+        while (statistics.residentBytes > statistics.budget && evictOne_(-1)) {}
+
+        for (size_t i = 0; i < textures.size(); ++i) {
+            Tracked& t = textures[i];
+            const int target = std::min(t.wanted, t.tail);
+            if (!t.live || t.loadingBase >= 0 || target >= t.base)
+                continue;
+
+            // Make room, then settle for whatever part of the request fits
+            int first = target;
+            while (statistics.residentBytes + bytesBetween_(t, first, t.base - 1) > statistics.budget
+                   && evictOne_(static_cast<int>(i))) {}
+            while (first < t.base && statistics.residentBytes + bytesBetween_(t, first, t.base - 1) > statistics.budget)
+                ++first;
+            if (first >= t.base)
+                continue;
+
+            const int last = t.base - 1;
+            const size_t cost = bytesBetween_(t, first, last);
+            statistics.residentBytes += cost;
+            statistics.loadingBytes += cost;
+            statistics.loads++;
+            t.loadingBase = first;
+
+            auto load = t.desc.load;
+            const int handle = static_cast<int>(i);
+            streamer.stream(t.desc.texture, t.desc.target, pool.submit([load, first, last] { return load(first, last); }),
+                            [this, handle, first, cost](GLuint texture, const StreamSource& source) {
+                Tracked& done = textures[handle];
+                statistics.loadingBytes -= cost;
+                done.loadingBase = -1;
+                if (source.empty()) {
+                    statistics.residentBytes -= cost;   // load failed: keep the coarser levels
+                    return;
+                }
+                glBindTexture(done.desc.target, texture);
+                glTexParameteri(done.desc.target, GL_TEXTURE_BASE_LEVEL, first);
+                done.base = first;
+            });
+        }
+
+        for (Tracked& t : textures)
+            t.wanted = t.tail;
+        frame++;
+        glActiveTexture(static_cast<GLenum>(previousUnit));
+    }
+
+    void TextureResidency::setBudget(size_t budgetBytes)
+    {
+        statistics.budget = budgetBytes;
+    }
+
+    const TextureResidency::Stats& TextureResidency::stats() const
+    {
+        return statistics;
+    }
+
+    void TextureResidency::printStats(std::ostream& out) const
+    {
+        out << "Residency: " << statistics.residentBytes / 1024 << " / " << statistics.budget / 1024 << " KB, "
+            << statistics.loads << " loads, " << statistics.evictions << " levels evicted\n";
+    }
+
+} // namespace gfx
@@ -0,0 +1,484 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "texture_streamer.h"
+#include "mipmap.h"
+#include "upload_thread.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+namespace gfx {
+
+    namespace {
+        // Scratch unit so streaming never disturbs the units programs sample from
+        constexpr GLint kStreamUnit = 15;
+        // Base level past any real level: the texture stays incomplete (reads black) until done
+        constexpr GLint kIncompleteBaseLevel = 1000;
+
+        int storedRows(const StreamUpload& upload)
+        {
+            return (upload.height + upload.rowHeight - 1) / upload.rowHeight;
+        }
+
+        bool isReady(const std::future<void>& f)
+        {
+            return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+
+        // Storage for every level the source defines, on the texture bound to its target.
+        // Returns the highest level.
+        GLint allocateLevels(const StreamSource& source)
+        {
+            GLint maxLevel = 0;
+            std::vector<bool> allocated;   // array levels hold every layer: allocate once
+            for (const StreamUpload& upload : source.uploads) {
+                const GLsizei size = static_cast<GLsizei>(upload.rowBytes * storedRows(upload));
+                if (upload.target == GL_TEXTURE_2D_ARRAY) {
+                    if (allocated.size() <= static_cast<size_t>(upload.level))
+                        allocated.resize(upload.level + 1, false);
+                    if (allocated[upload.level]) continue;
+                    allocated[upload.level] = true;
+                    if (upload.type == 0)
+                        glCompressedTexImage3D(upload.target, upload.level, static_cast<GLenum>(upload.internalFormat),
+                                               upload.width, upload.height, source.layers, 0, size * source.layers, nullptr);
+                    else
+                        glTexImage3D(upload.target, upload.level, upload.internalFormat, upload.width, upload.height,
+                                     source.layers, 0, upload.format, upload.type, nullptr);
+                } else if (upload.type == 0) {
+                    glCompressedTexImage2D(upload.target, upload.level, static_cast<GLenum>(upload.internalFormat),
+                                           upload.width, upload.height, 0, size, nullptr);
+                } else {
+                    glTexImage2D(upload.target, upload.level, upload.internalFormat, upload.width, upload.height, 0,
+                                 upload.format, upload.type, nullptr);
+                }
+                maxLevel = std::max(maxLevel, upload.level);
+            }
+            return maxLevel;
+        }
+
+        // Rows [y, y + height) of one upload from `pixels` (a PBO offset when one is bound)
+        void uploadRows(const StreamUpload& upload, int y, int height, size_t size, const void* pixels)
+        {
+            if (upload.target == GL_TEXTURE_2D_ARRAY) {
+                glPixelStorei(GL_UNPACK_ALIGNMENT, upload.alignment);
+                if (upload.type == 0)
+                    glCompressedTexSubImage3D(upload.target, upload.level, 0, y, upload.layer, upload.width, height, 1,
+                                              static_cast<GLenum>(upload.internalFormat), static_cast<GLsizei>(size), pixels);
+                else
+                    glTexSubImage3D(upload.target, upload.level, 0, y, upload.layer, upload.width, height, 1,
+                                    upload.format, upload.type, pixels);
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            } else if (upload.type == 0) {
+                glCompressedTexSubImage2D(upload.target, upload.level, 0, y, upload.width, height,
+                                          static_cast<GLenum>(upload.internalFormat), static_cast<GLsizei>(size), pixels);
+            } else {
+                glPixelStorei(GL_UNPACK_ALIGNMENT, upload.alignment);
+                glTexSubImage2D(upload.target, upload.level, 0, y, upload.width, height, upload.format, upload.type, pixels);
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            }
+        }
+    }
+
+    StreamSource streamSourceFromImages(std::vector<Image> faces, bool mipmaps)
+    {
+        StreamSource source;
+        if (faces.empty())
+            return source;
+        for (const Image& face : faces)
+            if (!face.valid()) {
+                std::cerr << "Failed to load texture: " << face.path << "\n";
+                return source;
+            }
+
+        const bool cube = faces.size() == 6;
+        const int channels = faces[0].channels;
+        const GLenum format = channels == 4 ? GL_RGBA : (channels == 1 ? GL_RED : GL_RGB);
+        auto upload = [&](GLenum target, GLint level, int width, int height, GLenum clientFormat, int texelBytes,
+                          const uint8_t* data) {
+            StreamUpload u;
+            u.target = target;
+            u.level = level;
+            u.width = width;
+            u.height = height;
+            u.internalFormat = static_cast<GLint>(format);
+            u.format = clientFormat;
+            u.type = GL_UNSIGNED_BYTE;
+            u.rowBytes = static_cast<size_t>(width) * texelBytes;
+            u.data = data;
+            source.uploads.push_back(u);
+            source.bytes += static_cast<size_t>(width) * height * (channels == 1 ? 1 : 4);
+        };
+
+        if (mipmaps) {
+            // The whole chain is built here on the worker; GL only copies levels in
+            auto chains = std::make_shared<std::vector<std::vector<MipLevel>>>(
+                buildMipChains(faces, prefersSrgbMips(faces[0])));
+            for (size_t level = 0; level < (*chains)[0].size(); ++level)
+                for (size_t i = 0; i < chains->size(); ++i) {
+                    const MipLevel& mip = (*chains)[i][level];
+                    upload(cube ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(i) : GL_TEXTURE_2D,
+                           static_cast<GLint>(level), mip.width, mip.height, GL_RGBA, 4, mip.rgba.data());
+                }
+            source.owner = chains;
+            return source;
+        }
+
+        auto owner = std::make_shared<std::vector<Image>>(std::move(faces));
+        for (size_t i = 0; i < owner->size(); ++i) {
+            const Image& image = (*owner)[i];
+            upload(cube ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(i) : GL_TEXTURE_2D, 0,
+                   image.width, image.height, format, image.channels, image.pixels.get());
+        }
+        source.owner = owner;
+        return source;
+    }
+
+    StreamSource streamSourceFromCompressed(CompressedTexture texture, bool useMipmaps)
+    {
+        StreamSource source;
+        if (!texture.valid())
+            return source;
+
+        auto owner = std::make_shared<CompressedTexture>(std::move(texture));
+        const size_t levels = useMipmaps ? owner->levels.size() : 1;
+        for (size_t i = 0; i < levels; ++i) {
+            const CompressedTexture::Level& level = owner->levels[i];
+            StreamUpload upload;
+            upload.level = static_cast<GLint>(i);
+            upload.width = level.width;
+            upload.height = level.height;
+            upload.internalFormat = static_cast<GLint>(owner->glFormat());
+            upload.rowHeight = 4;
+            upload.rowBytes = level.size / static_cast<size_t>((level.height + 3) / 4);
+            upload.data = owner->data.data() + level.offset;
+            source.uploads.push_back(upload);
+            source.bytes += level.size;
+        }
+        source.owner = owner;
+        source.swizzleRed = owner->grayscale;
+        return source;
+    }
+
+    StreamSource streamSourceFromKtx(const std::string& path, bool useMipmaps)
+    {
+        StreamSource source;
+        auto owner = std::make_shared<KtxTexture>();
+        if (!owner->load(path))
+            return source;
+
+        const int levels = useMipmaps ? owner->levels() : 1;
+        for (int level = 0; level < levels; ++level)
+            for (int face = 0; face < owner->faces(); ++face) {
+                StreamUpload upload;
+                upload.target = owner->isCube() ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(face) : GL_TEXTURE_2D;
+                upload.level = level;
+                upload.width = std::max(1, owner->width() >> level);
+                upload.height = std::max(1, owner->height() >> level);
+                upload.internalFormat = static_cast<GLint>(owner->internalFormat());
+                upload.format = owner->format();
+                upload.type = owner->type();
+                upload.rowHeight = owner->isCompressed() ? 4 : 1;
+                upload.alignment = 4;
+                upload.rowBytes = owner->imageSize(level) / static_cast<size_t>(storedRows(upload));
+                upload.data = owner->imageData(level, face);
+                source.uploads.push_back(upload);
+                source.bytes += owner->imageSize(level);
+            }
+        source.owner = owner;
+        source.swizzleRed = owner->value("KTXswizzle") == "rrr1";
+        return source;
+    }
+
+    TextureStreamer::TextureStreamer(size_t frameBudget, size_t slotBytes, int slotCount, ThreadPool& pool)
+        : pool(pool), frameBudget(frameBudget), slotBytes(std::min(slotBytes, frameBudget)), slots(slotCount) {}
+
+    TextureStreamer::~TextureStreamer()
+    {
+        cleanup();
+    }
+
+    void TextureStreamer::stream(GLuint texture, GLenum bindTarget, std::future<StreamSource> source,
+                                 std::function<void(GLuint, const StreamSource&)> onReady)
+    {
+        Job job;
+        job.texture = texture;
+        job.bindTarget = bindTarget;
+        job.loading = std::move(source);
+        job.onReady = std::move(onReady);
+        jobs.push_back(std::move(job));
+    }
+
+    void TextureStreamer::cancel(GLuint texture)
+    {
+        for (Job& job : jobs) {
+            if (job.texture != texture || job.cancelled) continue;
+            job.cancelled = true;
+            // Queued bands go now; bands already in a PBO drain through update()
+            auto queued = std::remove_if(bands.begin(), bands.end(), [&](const Band& b) { return b.job == &job; });
+            job.bandsLeft -= static_cast<size_t>(std::distance(queued, bands.end()));
+            bands.erase(queued, bands.end());
+        }
+    }
+
+    void TextureStreamer::setUploadThread(UploadThread* uploadThread)
+    {
+        uploads = uploadThread && uploadThread->running() ? uploadThread : nullptr;
+    }
+
+    void TextureStreamer::startJob_(Job& job)
+    {
+        job.started = true;
+        if (job.cancelled)
+            return;
+        StreamSource& source = job.source;
+
+        glBindTexture(job.bindTarget, job.texture);
+        const GLint maxLevel = allocateLevels(source);
+        if (!source.keepLevels) {
+            glTexParameteri(job.bindTarget, GL_TEXTURE_BASE_LEVEL, kIncompleteBaseLevel);
+            glTexParameteri(job.bindTarget, GL_TEXTURE_MAX_LEVEL, maxLevel);
+            if (source.swizzleRed) {
+                glTexParameteri(job.bindTarget, GL_TEXTURE_SWIZZLE_G, GL_RED);
+                glTexParameteri(job.bindTarget, GL_TEXTURE_SWIZZLE_B, GL_RED);
+            }
+        }
+
+        // Bands never exceed a slot or the frame budget, so every one can go out in some frame
+        for (size_t i = 0; i < source.uploads.size(); ++i) {
+            const StreamUpload& upload = source.uploads[i];
+            const int rows = storedRows(upload);
+            const int rowsPerBand = std::max(1, static_cast<int>(slotBytes / std::max<size_t>(1, upload.rowBytes)));
+            for (int row = 0; row < rows; row += rowsPerBand) {
+                bands.push_back(Band{ &job, i, row, std::min(rowsPerBand, rows - row) });
+                job.bandsLeft++;
+            }
+        }
+        // Nothing to upload (failed load): finish straight away
+        if (job.bandsLeft == 0) {
+            job.bandsLeft = 1;
+            bandDone_(job);
+        }
+    }
+
+    // The whole texture in one job on the upload thread's context. Its parameters are set
+    // here first, and a fence keeps the loader from touching the texture before they land.
+    // Nothing samples the texture until onReady, so the incomplete base level isn't needed
+    // (and Mesa's swrast crashes redefining a texture another context gave one).
+    void TextureStreamer::startThreadJob_(Job& job)
+    {
+        job.started = true;
+        if (job.cancelled)
+            return;
+        const StreamSource& source = job.source;
+        GLint maxLevel = 0;
+        for (const StreamUpload& upload : source.uploads)
+            maxLevel = std::max(maxLevel, upload.level);
+
+        glBindTexture(job.bindTarget, job.texture);
+        glTexParameteri(job.bindTarget, GL_TEXTURE_MAX_LEVEL, maxLevel);
+        if (source.swizzleRed) {
+            glTexParameteri(job.bindTarget, GL_TEXTURE_SWIZZLE_G, GL_RED);
+            glTexParameteri(job.bindTarget, GL_TEXTURE_SWIZZLE_B, GL_RED);
+        }
+        GLsync created = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+
+        job.bandsLeft = 1;
+        Job* pending = &job;
+        const bool queued = uploads->submit([texture = job.texture, target = job.bindTarget, source, created] {
+            glWaitSync(created, 0, GL_TIMEOUT_IGNORED);
+            glDeleteSync(created);
+            glBindTexture(target, texture);
+            allocateLevels(source);
+            for (const StreamUpload& upload : source.uploads)
+                uploadRows(upload, 0, upload.height, upload.rowBytes * storedRows(upload), upload.data);
+            glBindTexture(target, 0);
+        }, [this, pending] {
+            // Completions run outside update(): keep the units programs sample from intact
+            GLint previousUnit = GL_TEXTURE0;
+            glGetIntegerv(GL_ACTIVE_TEXTURE, &previousUnit);
+            glActiveTexture(GL_TEXTURE0 + kStreamUnit);
+            bandDone_(*pending);
+            glActiveTexture(static_cast<GLenum>(previousUnit));
+        });
+        if (!queued) {
+            // Queue full: this one takes the PBO path after all
+            glDeleteSync(created);
+            job.bandsLeft = 0;
+            startJob_(job);
+            return;
+        }
+        statistics.threadBytes += source.bytes;
+    }
+
+    void TextureStreamer::submit_(Slot& slot)
+    {
+        Job& job = *slot.band.job;
+        const StreamUpload& upload = job.source.uploads[slot.band.upload];
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        slot.mapped = nullptr;
+
+        if (job.cancelled) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            slot.state = SlotState::Free;
+            bandDone_(job);
+            return;
+        }
+
+        const int y = slot.band.firstRow * upload.rowHeight;
+        const int height = std::min(slot.band.rows * upload.rowHeight, upload.height - y);
+        const size_t size = upload.rowBytes * slot.band.rows;
+        glBindTexture(job.bindTarget, job.texture);
+        uploadRows(upload, y, height, size, nullptr);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot.state = SlotState::InFlight;
+        statistics.lastFrameBytes += size;
+    }
+
+    void TextureStreamer::bandDone_(Job& job)
+    {
+        if (--job.bandsLeft > 0 || job.cancelled)
+            return;
+
+        if (!job.source.keepLevels) {
+            glBindTexture(job.bindTarget, job.texture);
+            glTexParameteri(job.bindTarget, GL_TEXTURE_BASE_LEVEL, 0);
+        }
+        if (job.onReady)
+            job.onReady(job.texture, job.source);
+        job.source.owner.reset();
+        statistics.completed++;
+    }
+
+    void TextureStreamer::update()
+    {
+        statistics.lastFrameBytes = 0;
+        if (jobs.empty())
+            return;
+
+        GLint previousUnit = GL_TEXTURE0;
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &previousUnit);
+        glActiveTexture(GL_TEXTURE0 + kStreamUnit);
+
+        // Loads that finished on the pool get storage and are cut into bands
+        for (Job& job : jobs)
+            if (!job.started && job.loading.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                job.source = job.loading.get();
+                if (uploads && !job.source.keepLevels && !job.source.empty())
+                    startThreadJob_(job);
+                else
+                    startJob_(job);
+            }
+
+        // Retire uploads the GPU has consumed
+        for (Slot& slot : slots) {
+            if (slot.state != SlotState::InFlight) continue;
+            GLenum status = glClientWaitSync(slot.fence, 0, 0);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) continue;
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+            slot.state = SlotState::Free;
+            bandDone_(*slot.band.job);
+        }
+
+        // Hand filled PBOs to GL in order, within the frame budget
+        while (!filling.empty() && isReady(filling.front()->copy)) {
+            Slot& slot = *filling.front();
+            const StreamUpload& upload = slot.band.job->source.uploads[slot.band.upload];
+            size_t size = upload.rowBytes * slot.band.rows;
+            if (statistics.lastFrameBytes > 0 && statistics.lastFrameBytes + size > frameBudget)
+                break;
+            slot.copy.get();
+            filling.pop_front();
+            submit_(slot);
+        }
+
+        // Map free PBOs and let workers copy the next bands in
+        for (Slot& slot : slots) {
+            if (slot.state != SlotState::Free || bands.empty()) continue;
+            Band band = bands.front();
+            bands.pop_front();
+            const StreamUpload& upload = band.job->source.uploads[band.upload];
+            const size_t size = upload.rowBytes * band.rows;
+
+            if (!slot.pbo) glGenBuffers(1, &slot.pbo);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+            if (slot.capacity < size) {
+                slot.capacity = std::max(size, slotBytes);
+                glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(slot.capacity), nullptr, GL_STREAM_DRAW);
+            }
+            // The fence already retired, so the GPU is done with this buffer
+            slot.mapped = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(size),
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            if (!slot.mapped) {
+                bands.push_front(band);
+                break;
+            }
+
+            slot.band = band;
+            slot.state = SlotState::Filling;
+            const uint8_t* src = upload.data + upload.rowBytes * band.firstRow;
+            uint8_t* dst = slot.mapped;
+            slot.copy = pool.submit([dst, src, size] { std::memcpy(dst, src, size); });
+            filling.push_back(&slot);
+        }
+
+        jobs.remove_if([](const Job& job) { return job.started && job.bandsLeft == 0; });
+
+        glActiveTexture(static_cast<GLenum>(previousUnit));
+        statistics.totalBytes += statistics.lastFrameBytes;
+        statistics.peakFrameBytes = std::max(statistics.peakFrameBytes, statistics.lastFrameBytes);
+    }
+
+    void TextureStreamer::finish()
+    {
+        while (busy()) {
+            update();
+            if (uploads)
+                uploads->update();
+            glFlush();
+            std::this_thread::yield();
+        }
+    }
+
+    bool TextureStreamer::busy() const
+    {
+        return !jobs.empty();
+    }
+
+    const TextureStreamer::Stats& TextureStreamer::stats() const
+    {
+        return statistics;
+    }
+
+    void TextureStreamer::cleanup()
+    {
+        for (Slot& slot : slots) {
+            if (slot.copy.valid()) slot.copy.wait();
+            if (slot.mapped) {
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+                slot.mapped = nullptr;
+            }
+            if (slot.fence) { glDeleteSync(slot.fence); slot.fence = nullptr; }
+            if (slot.pbo) { glDeleteBuffers(1, &slot.pbo); slot.pbo = 0; }
+            slot.capacity = 0;
+            slot.state = SlotState::Free;
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        for (Job& job : jobs)
+            if (job.loading.valid()) job.loading.wait();
+        filling.clear();
+        bands.clear();
+        jobs.clear();
+    }
+
+} // namespace gfx
@@ -0,0 +1,112 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+
+namespace gfx {
+
+    ThreadPool::ThreadPool(unsigned threads)
+    {
+        if (threads == 0) {
+            unsigned hw = std::thread::hardware_concurrency();
+            threads = hw > 1 ? hw - 1 : 1;
+        }
+        workers.reserve(threads);
+        for (unsigned i = 0; i < threads; ++i)
+            workers.emplace_back([this]() { workerLoop_(); });
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : workers)
+            t.join();
+    }
+
+    ThreadPool& ThreadPool::shared()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    unsigned ThreadPool::size() const
+    {
+        return static_cast<unsigned>(workers.size());
+    }
+
+    void ThreadPool::enqueue_(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        wake.notify_one();
+    }
+
+    void ThreadPool::workerLoop_()
+    {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                if (stopping && jobs.empty())
+                    return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+    void ThreadPool::parallelFor(size_t begin, size_t end, size_t grain,
+                                 const std::function<void(size_t, size_t)>& body)
+    {
+        if (begin >= end)
+            return;
+        grain = std::max<size_t>(grain, 1);
+        size_t chunks = (end - begin + grain - 1) / grain;
+        if (chunks == 1) {
+            body(begin, end);
+            return;
+        }
+
+        // Chunks are claimed from a shared counter by helpers and the caller alike.
+        struct State {
+            std::atomic<size_t> next { 0 };
+            std::atomic<size_t> done { 0 };
+            std::mutex m;
+            std::condition_variable finished;
+        };
+        auto state = std::make_shared<State>();
+
+        auto drain = [state, begin, end, grain, chunks, &body]() {
+            for (;;) {
+                size_t c = state->next.fetch_add(1);
+                if (c >= chunks)
+                    return;
+                size_t b = begin + c * grain;
+                body(b, std::min(end, b + grain));
+                if (state->done.fetch_add(1) + 1 == chunks) {
+                    std::lock_guard<std::mutex> lock(state->m);
+                    state->finished.notify_all();
+                }
+            }
+        };
+
+        size_t helpers = std::min<size_t>(workers.size(), chunks - 1);
+        for (size_t i = 0; i < helpers; ++i)
+            enqueue_(drain);
+        drain();
+
+        std::unique_lock<std::mutex> lock(state->m);
+        state->finished.wait(lock, [&]() { return state->done.load() == chunks; });
+    }
+
+} // namespace gfx
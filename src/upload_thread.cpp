@@ -0,0 +1,143 @@
+//
+// Created by dengq on 10/19/26.
+//
+#include "upload_thread.h"
+#include <iostream>
+#include "GLFW/glfw3.h"
+
+namespace gfx {
+
+    UploadThread::UploadThread(size_t capacity)
+        : jobs(capacity), done(capacity)
+    {
+    }
+
+    UploadThread::~UploadThread()
+    {
+        stop();
+    }
+
+    bool UploadThread::start(GLFWwindow* window)
+    {
+        if (running())
+            return true;
+        // The version hints are still whatever created `window`; contexts that share
+        // objects should match
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        context = glfwCreateWindow(1, 1, "uploads", nullptr, window);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+        if (!context) {
+            std::cerr << "Upload thread: no shared context, uploading on the render thread\n";
+            return false;
+        }
+        stopping = false;
+        exited = false;
+        thread = std::thread([this] { run_(); });
+        return true;
+    }
+
+    void UploadThread::stop()
+    {
+        if (!thread.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        // Keep taking completions meanwhile: the loader can't finish while `done` is full
+        Job job;
+        while (!exited.load()) {
+            while (done.pop(job))
+                waiting.push_back(std::move(job));
+            std::this_thread::yield();
+        }
+        thread.join();
+
+        // Everything queued has run; wait for the GPU so completions can take their objects
+        while (busy()) {
+            update();
+            if (!waiting.empty())
+                glClientWaitSync(waiting.front().fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000);
+        }
+        glfwDestroyWindow(context);
+        context = nullptr;
+    }
+
+    bool UploadThread::running() const
+    {
+        return context != nullptr;
+    }
+
+    bool UploadThread::submit(std::function<void()> upload, std::function<void()> onComplete)
+    {
+        if (!running())
+            return false;
+        outstanding++;
+        if (!jobs.push(Job{ std::move(upload), std::move(onComplete), nullptr })) {
+            outstanding--;
+            return false;
+        }
+        // Pairs with the fence in run_(): either the loader sees the job or we see it asleep
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            wake.notify_one();
+        }
+        return true;
+    }
+
+    void UploadThread::update()
+    {
+        Job job;
+        while (done.pop(job))
+            waiting.push_back(std::move(job));
+        // Fences signal in submission order: stop at the first one still pending
+        while (!waiting.empty()) {
+            const GLenum status = glClientWaitSync(waiting.front().fence, 0, 0);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                break;
+            job = std::move(waiting.front());
+            waiting.pop_front();
+            glDeleteSync(job.fence);
+            if (job.onComplete)
+                job.onComplete();
+            outstanding--;
+        }
+    }
+
+    bool UploadThread::busy() const
+    {
+        return outstanding.load() > 0;
+    }
+
+    void UploadThread::run_()
+    {
+        glfwMakeContextCurrent(context);
+        Job job;
+        for (;;) {
+            if (jobs.pop(job)) {
+                job.upload();
+                job.upload = nullptr;
+                job.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                // The render thread waits on this fence from its own context: it has to
+                // reach the GPU, not sit in this context's command buffer
+                glFlush();
+                while (!done.push(std::move(job)))
+                    std::this_thread::yield();      // render thread is behind on update()
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            wake.wait(lock, [this] { return !jobs.empty() || stopping; });
+            sleeping.store(false, std::memory_order_relaxed);
+            if (stopping && jobs.empty())
+                break;
+        }
+        glfwMakeContextCurrent(nullptr);
+        exited = true;
+    }
+
+} // namespace gfx
@@ -0,0 +1,69 @@
+//
+// Created by dengq on 10/19/26.
+//
+// Packs loose assets into one archive the demo maps at startup (asset_pack.h).
+//
+//   asset_pack output.pak name=path [name=path ...]
+//
+// `name` is the entry name the demo looks up (relative to the directory the
+// pack is mounted on). Entries are stored in argument order, so list them in
+// the order they load. KTX textures are never compressed: they stay
+// page-aligned and are uploaded straight from the mapping.
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "asset_pack.h"
+#include "ktx.h"
+#include "mapped_file.h"
+
+namespace {
+    int usage()
+    {
+        std::cerr << "usage: asset_pack output.pak name=path [name=path ...]\n";
+        return 1;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+        return usage();
+
+    std::vector<gfx::AssetPackInput> inputs;
+    size_t looseBytes = 0;
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const size_t split = arg.find('=');
+        if (split == 0 || split == std::string::npos)
+            return usage();
+
+        gfx::AssetPackInput input;
+        input.name = arg.substr(0, split);
+        const std::string path = arg.substr(split + 1);
+        gfx::MappedFile file;
+        if (!file.open(path)) {
+            std::cerr << "Failed to read " << path << "\n";
+            return 1;
+        }
+        input.bytes.assign(file.data(), file.data() + file.size());
+        input.allowCompression = !gfx::isKtxPath(input.name);
+        looseBytes += input.bytes.size();
+        inputs.push_back(std::move(input));
+    }
+
+    if (!gfx::writeAssetPack(argv[1], inputs)) {
+        std::cerr << "Failed to write " << argv[1] << "\n";
+        return 1;
+    }
+
+    gfx::AssetPack pack;
+    if (!pack.open(argv[1]))
+        return 1;
+    for (const gfx::AssetPack::Entry& entry : pack.entries())
+        std::cout << "  " << entry.name << ": " << entry.size << " -> " << entry.storedSize
+                  << (entry.compressed ? " (lz4)" : " (raw)") << "\n";
+    std::cout << argv[1] << ": " << inputs.size() << " assets, " << looseBytes / 1024 << " KiB loose, "
+              << pack.fileSize() / 1024 << " KiB packed\n";
+    return 0;
+}
@@ -0,0 +1,112 @@
+//
+// Created by dengq on 10/19/26.
+//
+// Bakes PNG/JPEG sources into KTX files with the full mip chain, so the demo
+// never decodes or generates mips at startup.
+//
+//   ktx_convert [--raw] [--flip] [--linear] input.png output.ktx
+//   ktx_convert [--raw] [--flip] [--linear] --cube +x -x +y -y +z -z output.ktx
+//
+// By default levels are block-compressed (BC1/BC3/BC4, see texture_compress.h);
+// --raw keeps RGBA8. Color sources get sRGB-correct mips; --linear filters a
+// raw color source as plain data instead (normal maps and the like).
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "image_loader.h"
+#include "ktx.h"
+#include "mipmap.h"
+#include "texture_compress.h"
+
+namespace {
+    GLenum baseFormatFor(gfx::BlockFormat format)
+    {
+        switch (format) {
+            case gfx::BlockFormat::BC1: return GL_RGB;
+            case gfx::BlockFormat::BC3: return GL_RGBA;
+            case gfx::BlockFormat::BC4: return GL_RED;
+        }
+        return GL_RGBA;
+    }
+
+    int usage()
+    {
+        std::cerr << "usage: ktx_convert [--raw] [--flip] [--linear] input output.ktx\n"
+                     "       ktx_convert [--raw] [--flip] [--linear] --cube +x -x +y -y +z -z output.ktx\n";
+        return 1;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool raw = false, flip = false, cube = false, linear = false;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--raw") raw = true;
+        else if (arg == "--flip") flip = true;
+        else if (arg == "--cube") cube = true;
+        else if (arg == "--linear") linear = true;
+        else args.push_back(arg);
+    }
+    const size_t inputCount = cube ? 6 : 1;
+    if (args.size() != inputCount + 1)
+        return usage();
+
+    const std::string output = args.back();
+    args.pop_back();
+    std::vector<gfx::Image> faces = gfx::loadImages(args, flip);
+    for (const auto& face : faces)
+        if (!face.valid())
+            return 1;
+
+    gfx::KtxSource ktx;
+    ktx.width = faces[0].width;
+    ktx.height = faces[0].height;
+    ktx.faces = static_cast<int>(faces.size());
+
+    if (raw) {
+        ktx.internalFormat = GL_RGBA8;
+        ktx.format = GL_RGBA;
+        ktx.type = GL_UNSIGNED_BYTE;
+        ktx.baseInternalFormat = GL_RGBA;
+        auto chains = gfx::buildMipChains(faces, !linear && gfx::prefersSrgbMips(faces[0]));
+        ktx.images.resize(chains[0].size() * faces.size());
+        for (size_t level = 0; level < chains[0].size(); ++level)
+            for (size_t face = 0; face < faces.size(); ++face)
+                ktx.images[level * faces.size() + face] = std::move(chains[face][level].rgba);
+    } else {
+        // One format for every face, so a cube map stays a single texture
+        gfx::BlockFormat format = gfx::chooseBlockFormat(faces[0]);
+        std::vector<gfx::CompressedTexture> compressed;
+        for (const auto& face : faces)
+            compressed.push_back(gfx::compressImage(face, format, true));
+
+        ktx.internalFormat = compressed[0].glFormat();
+        ktx.baseInternalFormat = baseFormatFor(format);
+        if (compressed[0].grayscale)
+            ktx.keyValues.emplace_back("KTXswizzle", "rrr1");
+        const size_t levels = compressed[0].levels.size();
+        ktx.images.resize(levels * faces.size());
+        for (size_t level = 0; level < levels; ++level)
+            for (size_t face = 0; face < faces.size(); ++face) {
+                const auto& l = compressed[face].levels[level];
+                const uint8_t* begin = compressed[face].data.data() + l.offset;
+                ktx.images[level * faces.size() + face].assign(begin, begin + l.size);
+            }
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(output).parent_path(), ec);
+    if (!gfx::writeKtx(output, ktx))
+        return 1;
+
+    size_t bytes = 0;
+    for (const auto& image : ktx.images)
+        bytes += image.size();
+    std::cout << output << ": " << ktx.width << "x" << ktx.height << ", " << ktx.images.size() / ktx.faces
+              << " levels x " << ktx.faces << " faces, " << bytes / 1024 << " KB\n";
+    return 0;
+}
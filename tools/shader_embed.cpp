@@ -0,0 +1,69 @@
+//
+// Created by dengq on 10/19/26.
+//
+// Preprocesses shaders (see shader_source.h) and writes them into a header as
+// constexpr strings, so the demo compiles them without touching the disk.
+//
+//   shader_embed output.h shaderDir name...
+//
+// Each name is a path relative to shaderDir and is also the lookup key used by
+// gfx::shaderSource(SHADER_DIR + name).
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "shader_source.h"
+
+namespace {
+    const char* const kDelimiter = "GLSL";
+
+    int usage()
+    {
+        std::cerr << "usage: shader_embed output.h shaderDir name...\n";
+        return 1;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 4)
+        return usage();
+    const std::filesystem::path output = argv[1];
+    const std::filesystem::path shaderDir = argv[2];
+
+    std::string header =
+        "// Generated by tools/shader_embed.cpp from the sources in shaders/. Do not edit.\n"
+        "#include <string_view>\n"
+        "\n"
+        "namespace gfx::embedded {\n"
+        "    struct Shader {\n"
+        "        std::string_view name;\n"
+        "        std::string_view source;\n"
+        "    };\n"
+        "\n"
+        "    constexpr Shader shaders[] = {\n";
+    for (int i = 3; i < argc; ++i) {
+        const std::string name = argv[i];
+        const std::string source = gfx::preprocessShader((shaderDir / name).string());
+        if (source.empty())
+            return 1;
+        if (source.find(std::string(")") + kDelimiter + "\"") != std::string::npos) {
+            std::cerr << name << ": contains the raw string delimiter\n";
+            return 1;
+        }
+        header += "        { \"" + name + "\", R\"" + kDelimiter + "(" + source + ")" + kDelimiter + "\" },\n";
+    }
+    header += "    };\n"
+              "}\n";
+
+    std::error_code ec;
+    if (output.has_parent_path())
+        std::filesystem::create_directories(output.parent_path(), ec);
+    std::ofstream out(output, std::ios::binary);
+    if (!out.write(header.data(), static_cast<std::streamsize>(header.size()))) {
+        std::cerr << "Failed to write " << output.string() << "\n";
+        return 1;
+    }
+    return 0;
+}